@@ -11,8 +11,15 @@
 #include "hardware/clocks.h"
 #include "backscatter.pio.h"
 #include "packet_generation.h"
+#include "tx_scheduler.h"
+#include "backscatter_fifo.h"
 
-#define TX_DURATION 250 // send a packet every 250ms (when changing baud-rate, ensure that the TX delay is larger than the transmission time)
+#define TX_PERIOD_US 250000 // start a burst every 250ms (hardware timer)
+#define TX_BURST 1 // frames per burst
+#ifndef TX_GAP_US
+#define TX_GAP_US 200 // gap between the frames of a burst: set to the "gap min" of the "# scheduler" line of carrier-receiver-baseband (re-arm time of the receiver)
+#endif
+#define STATS_INTERVAL 100 // print the achieved duty cycle and frame rate every 100 frames
 #define RECEIVER 1352 // define the receiver board either 2500 or 1352
 #define PIN_TX1 6
 #define PIN_TX2 27
@@ -29,8 +36,17 @@ int main() {
     static uint8_t seq = 0;
     uint8_t *header_tmplate = packet_hdr_template(RECEIVER);
     uint8_t tx_payload_buffer[PAYLOADSIZE];
+    static struct tx_scheduler scheduler;
+    tx_scheduler_init(&scheduler, TX_BURST, TX_PERIOD_US);
 
     while (true) {
+        /* wait for the hardware timer to open the next burst */
+        if (!tx_scheduler_ready(&scheduler)){
+            tight_loop_contents();
+            continue;
+        }
+        tx_scheduler_window_start(&scheduler);
+
         /* generate new data */
         generate_data(tx_payload_buffer, PAYLOADSIZE, true);
 
@@ -43,9 +59,17 @@ int main() {
         for (uint8_t i=0; i < buffer_size(PAYLOADSIZE, HEADER_LEN); i++) {
             buffer[i] = ((uint32_t) message[4*i+3]) | (((uint32_t) message[4*i+2]) << 8) | (((uint32_t) message[4*i+1]) << 16) | (((uint32_t)message[4*i]) << 24);
         }
-        /* put the data to FIFO */
-        backscatter_send(pio,sm,buffer,buffer_size(PAYLOADSIZE, HEADER_LEN));
+        /* put the data to FIFO and wait until the state-machine stalls on the empty FIFO (last symbol sent) */
+        uint64_t start_us = time_us_64();
+        backscatter_start(pio, sm, buffer, buffer_size(PAYLOADSIZE, HEADER_LEN));
+        backscatter_wait_sent(pio, sm);
+        if (!tx_scheduler_sent(&scheduler, start_us)){
+            busy_wait_us(TX_GAP_US); // next frame of the burst
+            tx_scheduler_rearmed(&scheduler); // report the applied gap as "gap min" (no receiver to measure it)
+        }
         seq++;
-        sleep_ms(TX_DURATION);
+        if (seq % STATS_INTERVAL == 0){
+            print_tx_scheduler(&scheduler);
+        }
     }
 }
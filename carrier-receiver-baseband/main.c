@@ -11,6 +11,7 @@
  */
 
 #include <stdio.h>
+#include <stdarg.h>
 #include <math.h>
 #include <string.h>
 #include "pico/stdlib.h"
@@ -26,6 +27,20 @@
 #include "carrier_CC2500.h"
 #include "receiver_CC2500.h"
 #include "packet_generation.h"
+#include "channel_scan.h"
+#include "link_stats.h"
+#include "tx_scheduler.h"
+#include "ber_stats.h"
+#include "trace.h"
+#include "fec.h"
+#include "backscatter_optimizer.h"
+#include "usb_logger.h"
+#include "pio_loopback.h"
+#include "flash_config.h"
+#include "lib_output.h"
+#if LIB_PICO_STDIO_USB
+#include "pico/stdio_usb.h"
+#endif
 
 
 #define RADIO_SPI             spi0
@@ -33,7 +48,8 @@
 #define RADIO_MOSI              19
 #define RADIO_SCK               18
 
-#define TX_DURATION            250 // send a packet every 250ms (when changing baud-rate, ensure that the TX delay is larger than the transmission time)
+#define TX_PERIOD_US             0 // start a carrier-on window every TX_PERIOD_US (0: back-to-back as soon as the receivers are re-armed)
+#define TX_BURST                 4 // frames per carrier-on window
 #define RECEIVER              2500 // define the receiver board either 2500 or 1352
 #define PIN_TX1                  6
 #define PIN_TX2                 27
@@ -41,8 +57,290 @@
 #define CLOCK_DIV1              18 // smaller
 #define DESIRED_BAUD        100000
 #define TWOANTENNAS          true
+#define ANTENNA_PHASE  PHASE_IN_PHASE // phase of the second antenna (PIN_TX2) to the first one (see backscatter.h)
+#define LOOPBACK_TEST         true // measure subcarrier frequencies and symbol timing of each new program on pio1 (see pio_loopback.h)
+#define ANTENNA_ALTERNATE    false // cycle through antenna_phases frame by frame (two antennas) and print the link statistics per phase
+#define FAST_BOOT             true // restore the last known-good configuration from flash instead of the full setup (see flash_config.h)
+#ifndef BUILD_STAMP
+#define BUILD_STAMP      "no stamp" // a flash record of another build is ignored (set by CMakeLists.txt: hash of the sources)
+#endif
+#define OPTIMIZE_CONFIG      false // replace CLOCK_DIV0/CLOCK_DIV1/DESIRED_BAUD by the fastest feasible configuration for RECEIVER (see backscatter_optimizer.h)
 
 #define CARRIER_FEQ     2450000000
+#define TAG_CRC               true // append the CRC-16 of the CC2500 to each frame (changes the frame format on air, see README)
+
+#define DIVERSITY            false // two receiver CC2500 listen to the same subcarrier (selection diversity, requires the second receiver on GPIO 20/22)
+#define NUM_RECEIVERS     (DIVERSITY ? 2 : 1)
+#define STATS_INTERVAL         100 // print the link statistics every 100 frames
+#define BINARY_LOG           false // log the received frames as binary records (printPacketBinary, decode with serial-capture.py)
+#define LOG_CORE1             true // format and write the received frames on core 1 (see usb_logger.h): the reception does not wait for USB
+#define FEC                  false // encode seq and payload with the convolutional code and interleaver of fec.h
+#define TX_TIMESTAMP         false // append the TX start time to each frame and log in us (one-way latency: host/analyzer/log_analyzer --tx-timestamp)
+#define TRAILER_LEN   (TX_TIMESTAMP ? TX_TIMESTAMP_LEN : 0)
+#define BODY_LEN(fec) (((fec) ? FEC_ENCODED_LEN(1 + PAYLOADSIZE) : 1 + PAYLOADSIZE) + TRAILER_LEN) // bytes after the length byte (seq and payload, encoded with FEC, and the TX timestamp)
+#define FRAME_LEN     (BODY_LEN(true) - 1 + (TAG_CRC ? CRC_LEN : 0)) // maximal frame length after the header
+
+#define BENCHMARK            false // transfer a file of FILE_SIZE bytes after boot and report the file transmission time (can also be started by sending 'b' over USB)
+#define FILE_SIZE  (2*1024*1024) // [B] file data (without file index)
+#define FILE_FRAMES   ((FILE_SIZE + PAYLOADSIZE - 3)/(PAYLOADSIZE - 2)) // frames to transfer the file
+#define BENCHMARK_DRAIN_US   20000 // wait for the last frame to be received [us]
+
+#define SALVAGE_LENGTH        true // receive the full frame despite a corrupted length byte (fixed length mode of the receivers, see set_salvage_length_rx)
+
+#define FRAME_SWEEP          false // cycle through frame_formats to compare the goodput without reflashing
+#define FRAMES_PER_FORMAT      500
+
+/* frame formats: preamble bytes, sync word bytes, fixed length mode (no length byte) */
+static const struct frame_format frame_formats[] = {
+    {.preamble_len = 4, .sync_len = 4, .fixed_length = false}, // default: 10 byte overhead
+    {.preamble_len = 2, .sync_len = 4, .fixed_length = false}, //  8 byte overhead
+    {.preamble_len = 2, .sync_len = 2, .fixed_length = false}, //  6 byte overhead
+    {.preamble_len = 2, .sync_len = 2, .fixed_length = true},  //  5 byte overhead
+};
+
+#define CHANNEL_SCAN          true // select the carrier and subcarrier with the lowest noise floor (see channel_scan.h)
+#define SCAN_INTERVAL_MS     60000 // re-scan periodically [ms]
+#define SCAN_WINDOW_US       20000 // observation window per candidate [us]
+#define SCAN_SAMPLE_US         100 // time between two RSSI samples [us]
+
+/* candidates for the channel scan */
+static const uint32_t scan_carriers[] = {2405000000, 2425000000, 2450000000, 2475000000};
+static const struct scan_offset scan_offsets[] = {{CLOCK_DIV0, CLOCK_DIV1}, {26, 24}, {32, 30}};
+
+#define PARAM_SWEEP          false // walk the grid below after boot (can also be started by sending 's' over USB)
+#define SWEEP_FRAMES           200 // frames per grid point
+
+/* grid of the parameter sweep: clock dividers x baud-rates x antenna modes */
+static const struct scan_offset sweep_dividers[] = {{20, 18}, {26, 24}, {32, 30}, {40, 36}};
+static const uint32_t sweep_bauds[] = {50000, 100000, 250000};
+static const bool sweep_antennas[] = {true, false};
+static const bool sweep_fec[] = {false, true};
+#define SWEEP_POINTS ((sizeof(sweep_dividers)/sizeof(sweep_dividers[0])) * (sizeof(sweep_bauds)/sizeof(sweep_bauds[0])) * (sizeof(sweep_antennas)/sizeof(sweep_antennas[0])) * (sizeof(sweep_fec)/sizeof(sweep_fec[0])))
+
+/* antenna phases of ANTENNA_ALTERNATE (the quarter phase reloads the program, in-phase is used if it does not fit) */
+static const enum antenna_phase antenna_phases[] = {PHASE_IN_PHASE, PHASE_INVERTED, PHASE_QUARTER, PHASE_SINGLE};
+
+/* configuration of the tag */
+struct tag_setting {
+  uint16_t d0;
+  uint16_t d1;
+  uint32_t baud;
+  bool two_antennas;
+  bool fec;
+};
+
+/* log a received copy: hand its slot over to core 1 (LOG_CORE1) or print it as text line or binary record */
+static inline void logPacket(RX_copy *copy, struct log_slot **slot){
+    if (*slot != NULL){
+        (*slot)->time_us = copy->time_us;
+        (*slot)->status = copy->status;
+        usb_logger_submit(*slot);
+        *slot = NULL;
+    } else if (!LOG_CORE1){
+        if (BINARY_LOG){
+            printPacketBinary(copy->packet, copy->status, copy->time_us);
+        } else {
+            printPacket(copy->packet, copy->status, copy->time_us);
+        }
+    } // else: dropped by the logger
+}
+
+/* '#' line of the RX loop: written by core 1 in order with the frames (LOG_CORE1), core 0 does not wait for stdio */
+static void log_printf(const char *format, ...){
+    va_list args;
+    va_start(args, format);
+    if (LOG_CORE1){
+        usb_logger_vprintf(format, args, false);
+    } else {
+        vprintf(format, args);
+    }
+    va_end(args);
+}
+
+/* output of the libraries in the RX loop (register settings and loopback while reconfiguring, trace dump):
+ * through core 1 as well, but waits for a free text slot instead of losing lines (only between carrier-on windows or on request) */
+static bool lib_output(const char *format, va_list args){
+    return usb_logger_vprintf(format, args, true);
+}
+
+static void log_link_stats(const char *name, struct link_stats *stats, uint32_t sent){
+    char line[LINK_STATS_LINE_MAX];
+    format_link_stats(line, sizeof(line), name, stats, sent);
+    log_printf("%s", line);
+}
+
+static void log_ber_stats(const char *name, struct ber_stats *stats, uint32_t sent){
+    char line[BER_STATS_LINE_MAX];
+    format_ber_stats(line, sizeof(line), name, stats, sent, PAYLOADSIZE);
+    log_printf("%s", line);
+}
+
+static void log_tx_scheduler(struct tx_scheduler *sched){
+    char line[TX_SCHEDULER_LINE_MAX];
+    if (format_tx_scheduler(line, sizeof(line), sched) > 0){
+        log_printf("%s", line);
+    }
+}
+
+static void log_scan_table(struct scan_table *table){
+    char line[SCAN_LINE_MAX];
+    format_scan_header(line, sizeof(line), table);
+    log_printf("%s", line);
+    for (uint8_t i = 0; i < table->len; i++){
+        format_scan_entry(line, sizeof(line), table, i);
+        log_printf("%s", line);
+    }
+}
+
+/* grid point of the parameter sweep */
+struct tag_setting sweep_point(uint16_t idx){
+    uint16_t n_bauds = sizeof(sweep_bauds)/sizeof(sweep_bauds[0]);
+    uint16_t n_antennas = sizeof(sweep_antennas)/sizeof(sweep_antennas[0]);
+    uint16_t n_fec = sizeof(sweep_fec)/sizeof(sweep_fec[0]);
+    struct tag_setting setting = {
+        .d0 = sweep_dividers[idx / (n_bauds*n_antennas*n_fec)].d0,
+        .d1 = sweep_dividers[idx / (n_bauds*n_antennas*n_fec)].d1,
+        .baud = sweep_bauds[(idx / (n_antennas*n_fec)) % n_bauds],
+        .two_antennas = sweep_antennas[(idx / n_fec) % n_antennas],
+        .fec = sweep_fec[idx % n_fec]
+    };
+    return setting;
+}
+
+/* configure all receivers to approximate the backscatter settings */
+void configure_receiver(uint32_t f_carrier, struct backscatter_config *conf){
+    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+        select_receiver_rx(r);
+        set_frecuency_rx(f_carrier + conf->center_offset);
+        set_frequency_deviation_rx(conf->deviation);
+        set_datarate_rx(conf->baudrate);
+        set_filter_bandwidth_rx(conf->minRxBw);
+    }
+    select_receiver_rx(0);
+    sleep_ms(1);
+}
+
+/* configure all receivers for the frame format of the tag (fec: encoded frames) */
+void configure_format(const struct frame_format *format, bool fec){
+    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+        select_receiver_rx(r);
+        set_packet_format_rx(format->preamble_len, format->sync_len, format->fixed_length ? BODY_LEN(fec) : 0);
+        if (SALVAGE_LENGTH && !format->fixed_length){
+            set_salvage_length_rx(1 + BODY_LEN(fec)); // length byte, seq and payload
+        }
+    }
+    select_receiver_rx(0);
+}
+
+/* measure the loaded program with the loopback self-test (LOOPBACK_TEST) */
+void run_loopback(PIO pio, uint sm, struct tag_setting *tag, struct backscatter_config *conf){
+    struct loopback_result result;
+    loopback_selftest(pio, sm, PIN_TX1, PIN_TX2, tag->two_antennas, tag->d0, tag->d1, conf, &result);
+    print_loopback(&result);
+}
+
+/* antenna phase of the next frame: switch the output override or reload the program, returns the phase in use */
+enum antenna_phase select_antenna_phase(enum antenna_phase phase, PIO pio, uint sm, struct tag_setting *tag, struct backscatter_config *conf, uint16_t *instructionBuffer){
+    if (!backscatter_switch_phase(PIN_TX2, phase)){
+        setAntennaPhase(phase);
+        backscatter_program_reload(pio, sm, PIN_TX1, PIN_TX2, tag->d0, tag->d1, tag->baud, conf, instructionBuffer, tag->two_antennas);
+    }
+    return getAntennaPhase();
+}
+
+/* candidates of scan_offsets which are feasible at the baud-rate and antenna mode of the tag (the program fits, the receiver
+ * supports deviation and bandwidth), returns their number (the current dividers of the tag if none is feasible) */
+uint8_t feasible_scan_offsets(struct tag_setting *tag, struct scan_offset *offsets){
+    struct opt_search search = opt_default_search(RECEIVER, CARRIER_FEQ, tag->two_antennas);
+    search.min_offset = 0;    // the scan measures the distance from the carrier
+    search.min_index_pct = 0; // as backscatter_program_init
+    struct opt_candidate candidate;
+    uint8_t n = 0;
+    for (uint8_t i = 0; i < sizeof(scan_offsets)/sizeof(scan_offsets[0]); i++){
+        if (opt_evaluate(&search, scan_offsets[i].d0, scan_offsets[i].d1, tag->baud, &candidate)){
+            offsets[n++] = scan_offsets[i];
+        }
+    }
+    if (n == 0){
+        offsets[n++] = (struct scan_offset) {tag->d0, tag->d1};
+    }
+    return n;
+}
+
+/* sequence number of a received copy (FEC: byte 1 is encoded, the seq and payload are decoded into decoded) */
+uint8_t copy_seq(RX_copy *copy, bool fec, uint8_t *decoded){
+    if (fec){
+        fec_decode(&copy->packet[1], 1 + PAYLOADSIZE, decoded);
+        return decoded[0];
+    }
+    return copy->packet[1];
+}
+
+/* restore tag, carrier and receivers from a flash record (FAST_BOOT), returns false if a part could not be restored */
+bool restore_config(struct flash_config *record, PIO pio, uint sm, struct tag_setting *tag, uint32_t *f_carrier, struct backscatter_config *conf){
+    if (record->n_receivers != NUM_RECEIVERS || !backscatter_program_restore(pio, sm, PIN_TX1, PIN_TX2, &record->program)){
+        return false;
+    }
+    bool restored = restoreCarrier(record->carrier);
+    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+        select_receiver_rx(r);
+        restored = restoreReceiver(record->receivers[r], record->salvage_len[r]) && restored;
+    }
+    select_receiver_rx(0);
+    if (!restored){
+        return false; // the full setup starts from the defaults, not from the rejected record
+    }
+    *tag = (struct tag_setting) {.d0 = record->d0, .d1 = record->d1, .baud = record->baud, .two_antennas = record->two_antennas, .fec = record->fec};
+    *conf = record->program.config;
+    *f_carrier = record->f_carrier;
+    return true;
+}
+
+/* flash record of the current configuration of tag, carrier and receivers (FAST_BOOT) */
+void capture_config(struct flash_config *record, struct tag_setting *tag, uint32_t f_carrier){
+    memset(record, 0, sizeof(struct flash_config)); // the padding is compared as well
+    record->build = flash_config_build(BUILD_STAMP);
+    record->d0 = tag->d0;
+    record->d1 = tag->d1;
+    record->baud = tag->baud;
+    record->two_antennas = tag->two_antennas;
+    record->fec = tag->fec;
+    backscatter_program_image(&record->program);
+    record->f_carrier = f_carrier;
+    read_image_tx(record->carrier);
+    record->n_receivers = NUM_RECEIVERS;
+    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+        select_receiver_rx(r);
+        read_image_rx(record->receivers[r]);
+        record->salvage_len[r] = get_salvage_length_rx();
+    }
+    select_receiver_rx(0);
+}
+
+/* a host is connected to read the log (USB) */
+static inline bool console_connected(){
+#if LIB_PICO_STDIO_USB
+    return stdio_usb_connected();
+#else
+    return true;
+#endif
+}
+
+void start_listen_all(){
+    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+        select_receiver_rx(r);
+        RX_start_listen();
+    }
+    select_receiver_rx(0);
+}
+
+void stop_listen_all(){
+    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+        select_receiver_rx(r);
+        RX_stop_listen();
+    }
+    select_receiver_rx(0);
+}
 
 int main() {
     /* setup SPI */
@@ -61,96 +359,526 @@ int main() {
     gpio_put(RX_CSN, 1);
     bi_decl(bi_1pin_with_name(RX_CSN, "SPI Receiver CS"));
 
+    if (DIVERSITY){
+        gpio_init(RX2_CSN);
+        gpio_set_dir(RX2_CSN, GPIO_OUT);
+        gpio_put(RX2_CSN, 1);
+        bi_decl(bi_1pin_with_name(RX2_CSN, "SPI Receiver 2 CS"));
+    }
+
     // Chip select is active-low, so we'll initialise it to a driven-high state
     gpio_init(CARRIER_CSN);
     gpio_set_dir(CARRIER_CSN, GPIO_OUT);
     gpio_put(CARRIER_CSN, 1);
     bi_decl(bi_1pin_with_name(CARRIER_CSN, "SPI Carrier CS"));
 
-    sleep_ms(5000);
-
     /* setup backscatter state machine */
     PIO pio = pio0;
     uint sm = 0;
     struct backscatter_config backscatter_conf;
     uint16_t instructionBuffer[32] = {0}; // maximal instruction size: 32
-    backscatter_program_init(pio, sm, PIN_TX1, PIN_TX2, CLOCK_DIV0, CLOCK_DIV1, DESIRED_BAUD, &backscatter_conf, instructionBuffer, TWOANTENNAS);
+    struct tag_setting tag;
+    uint32_t f_carrier = CARRIER_FEQ;
+    setAntennaPhase(ANTENNA_PHASE);
+
+    /* fast boot: restore the last known-good configuration of this build (the full setup follows if it is missing or fails) */
+    static struct flash_config boot_record;
+    bool boot_record_valid = FAST_BOOT && flash_config_load(&boot_record, flash_config_build(BUILD_STAMP));
+    bool fast_boot = boot_record_valid && restore_config(&boot_record, pio, sm, &tag, &f_carrier, &backscatter_conf);
+    if (!fast_boot){
+        sleep_ms(5000);
+    }
+
+    struct tag_setting default_tag = {.d0 = CLOCK_DIV0, .d1 = CLOCK_DIV1, .baud = DESIRED_BAUD, .two_antennas = TWOANTENNAS, .fec = FEC};
+    if (OPTIMIZE_CONFIG){
+        struct opt_search search = opt_default_search(RECEIVER, CARRIER_FEQ, TWOANTENNAS);
+        struct opt_candidate best;
+        if (opt_find_best(&search, &best, 1) > 0){
+            printf("Optimized configuration: d0 %u, d1 %u, baud %u\n", best.d0, best.d1, best.baud);
+            default_tag.d0 = best.d0;
+            default_tag.d1 = best.d1;
+            default_tag.baud = best.baud;
+        }
+    }
+    if (!fast_boot){
+        tag = default_tag;
+        setAntennaPhase(ANTENNA_PHASE); // a failed restore may have loaded the phase of the record
+        f_carrier = CARRIER_FEQ;
+        backscatter_program_init(pio, sm, PIN_TX1, PIN_TX2, tag.d0, tag.d1, tag.baud, &backscatter_conf, instructionBuffer, tag.two_antennas);
+    }
+    if (LOOPBACK_TEST){
+        run_loopback(pio, sm, &tag, &backscatter_conf);
+    }
 
-    static uint8_t message[buffer_size(PAYLOADSIZE+2, HEADER_LEN)*4] = {0};  // include 10 header bytes
-    static uint32_t buffer[buffer_size(PAYLOADSIZE, HEADER_LEN)] = {0}; // initialize the buffer
+    static uint8_t message[buffer_size(FRAME_LEN, HEADER_LEN)*4] = {0};  // include 10 header bytes
+    static uint32_t buffer[buffer_size(FRAME_LEN, HEADER_LEN)] = {0}; // initialize the buffer
     static uint8_t seq = 0;
     uint8_t *header_tmplate = packet_hdr_template(RECEIVER);
     uint8_t tx_payload_buffer[PAYLOADSIZE];
 
     /* Setup carrier */
-    printf("\nConfiguring one CC2500 as carrier generator:\n");
-    setupCarrier();
-    set_frecuency_tx(CARRIER_FEQ);
-    sleep_ms(1);
+    if (!fast_boot){
+        printf("\nConfiguring one CC2500 as carrier generator:\n");
+        setupCarrier();
+        setCarrierManualCalibration(true); // calibrate once instead of at every carrier start
+        set_frecuency_tx(f_carrier);
+        sleep_ms(1);
+    }
+    uint32_t max_settle_us = 0;
 
     /* Start Receiver */
-    printf("\nConfiguring one CC2500 to approximate the obtained radio settings:\n");
     event_t evt = no_evt;
-    Packet_status status;
-    uint8_t rx_buffer[RX_BUFFER_SIZE];
-    uint64_t time_us;
-    setupReceiver();
-    set_frecuency_rx(CARRIER_FEQ + backscatter_conf.center_offset);
-    set_frequency_deviation_rx(backscatter_conf.deviation);
-    set_datarate_rx(backscatter_conf.baudrate);
-    set_filter_bandwidth_rx(backscatter_conf.minRxBw);
-    sleep_ms(1);
-    RX_start_listen();
+    static RX_copy rx[NUM_RECEIVERS];
+    static struct log_slot *rx_slot[NUM_RECEIVERS];  // slot of the logger holding the copy (LOG_CORE1)
+    static struct link_stats rx_stats[NUM_RECEIVERS];
+    static struct link_stats merged_stats;
+    static struct ber_stats ber_stats;
+    static uint8_t rx_decoded[1 + PAYLOADSIZE]; // seq and payload of a received encoded frame
+    uint32_t sent = 0;
+    uint32_t latency_n = 0, latency_max = 0;    // one-way latency of the received frames (TX_TIMESTAMP)
+    uint64_t latency_sum = 0;
+    uint32_t salvaged = 0;                       // received frames with a corrupted length byte (SALVAGE_LENGTH)
+    static struct link_stats phase_stats[ANTENNA_PHASES];  // frames received per antenna phase (ANTENNA_ALTERNATE)
+    static uint32_t phase_sent[ANTENNA_PHASES];
+    static uint8_t tx_phase[256];                          // antenna phase of each seq
+    uint8_t phase_idx = 0;
+    for (uint8_t p = 0; p < ANTENNA_PHASES; p++){
+        link_stats_reset(&phase_stats[p]);
+    }
+    setLogMicroseconds(TX_TIMESTAMP);
+    if (LOG_CORE1){
+        usb_logger_init(BINARY_LOG);
+    }
+    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+        link_stats_reset(&rx_stats[r]);
+    }
+    link_stats_reset(&merged_stats);
+    ber_stats_reset(&ber_stats);
+    uint8_t format_idx = 0;
+    struct frame_format format = frame_formats[format_idx];
+    if (!fast_boot){
+        printf("\nConfiguring %d CC2500 to approximate the obtained radio settings:\n", NUM_RECEIVERS);
+        for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+            select_receiver_rx(r);
+            setupReceiver();
+            setReceiverManualCalibration(true); // calibrate once instead of at every re-arm
+        }
+        configure_receiver(f_carrier, &backscatter_conf);
+        configure_format(&format, tag.fec);
+    }
+
+    /* Channel scan (carrier is off) */
+    static struct scan_table scan_table;
+    static struct scan_offset scan_feasible[sizeof(scan_offsets)/sizeof(scan_offsets[0])];
+    struct scan_config scan_conf = {
+        .carriers = scan_carriers,
+        .n_carriers = sizeof(scan_carriers)/sizeof(scan_carriers[0]),
+        .offsets = scan_feasible,
+        .n_offsets = feasible_scan_offsets(&tag, scan_feasible),
+        .window_us = SCAN_WINDOW_US,
+        .sample_interval_us = SCAN_SAMPLE_US
+    };
+    bool scan_pending = CHANNEL_SCAN && !fast_boot; // the restored configuration is the result of a scan
+    if (scan_pending){
+        channel_scan(&scan_conf, &scan_table);
+    }
+    start_listen_all();
     printf("started listening\n");
+    if (LOG_CORE1){
+        lib_output_redirect(lib_output); // from here on, core 0 prints nothing directly
+    }
+    uint64_t setup_us = time_us_64();  // boot-to-first-frame time: setup, first frame sent and received
+    uint64_t first_tx_us = 0, first_rx_us = 0;
+    bool boot_report = true;
+    bool config_pending = FAST_BOOT;   // configuration not yet compared with the flash record
+    bool config_good = false;          // a frame passed the CRC check with the current configuration
     bool rx_ready = true;
+    static struct tx_scheduler scheduler;
+    tx_scheduler_init(&scheduler, TX_BURST, TX_PERIOD_US);
+    int16_t sweep_idx = PARAM_SWEEP ? 0 : -1;  // current grid point of the parameter sweep (-1: inactive)
+    bool sweep_apply = PARAM_SWEEP;
+    bool benchmark_start = BENCHMARK;  // benchmark requested (starts between carrier-on windows)
+    bool benchmark = false;            // benchmark running
+    uint64_t benchmark_sent_us = 0;    // end of the last frame of the file
 
     /* loop */
     while (true) {
         evt = get_event();
         switch(evt){
             case rx_assert_evt:
+            case rx2_assert_evt:
                 // started receiving
+                rx[event_receiver(evt)].busy = true;
                 rx_ready = false;
             break;
             case rx_deassert_evt:
-                // finished receiving
-                time_us = to_us_since_boot(get_absolute_time());
-                status = readPacket(rx_buffer);
-                printPacket(rx_buffer,status,time_us);
-                RX_start_listen();
-                rx_ready = true;
+            case rx2_deassert_evt: {
+                // finished receiving: read the copy, merge once no receiver is busy
+                uint8_t r = event_receiver(evt);
+                TRACE(TRACE_READ);
+                rx[r].time_us = to_us_since_boot(get_absolute_time());
+                select_receiver_rx(r);
+                if (LOG_CORE1 && rx_slot[r] == NULL){
+                    rx_slot[r] = usb_logger_acquire(); // NULL if the logger fell behind: the copy is not logged
+                }
+                rx[r].packet = (rx_slot[r] != NULL) ? rx_slot[r]->buffer : rx[r].buffer; // read directly into the slot
+                rx[r].status = readPacket(rx[r].packet);
+                select_receiver_rx(0);
+                rx[r].busy = false;
+                rx[r].received = true;
+                link_stats_update(&rx_stats[r], &rx[r].status);
+                TRACE(TRACE_IDLE);
+            }
             break;
-            case no_evt:
-                // backscatter new packet if receiver is listening
-                if (rx_ready){
+            case no_evt: {
+                // USB commands: 's' starts the parameter sweep, 'b' the file transfer benchmark, 't' dumps the trace buffer
+                int c = getchar_timeout_us(0);
+                if (c == 't'){
+                    trace_dump();
+                }
+                if (c == 's' && sweep_idx < 0 && !benchmark){
+                    sweep_idx = 0;
+                    sweep_apply = true;
+                }
+                if (c == 'b' && sweep_idx < 0 && !benchmark){
+                    benchmark_start = true;
+                }
+                // merge the copies of the last frame (frames with the same seq are printed once)
+                bool busy = false, received = false;
+                for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+                    busy     |= rx[r].busy;
+                    received |= rx[r].received;
+                }
+                if (received && !busy){
+                    // re-arm first (the next frame can be sent while printing)
+                    TRACE(TRACE_REARM);
+                    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+                        if (rx[r].received){
+                            select_receiver_rx(r);
+                            RX_start_listen();
+                        }
+                    }
+                    select_receiver_rx(0);
+                    tx_scheduler_rearmed(&scheduler);
+                    TRACE(TRACE_PRINT);
+                    int8_t best = select_best_copy(rx, NUM_RECEIVERS);
+                    link_stats_update(&merged_stats, &rx[best].status);
+                    if (rx[best].status.CRCcheck && !rx[best].status.overflowed){
+                        first_rx_us = first_rx_us ? first_rx_us : rx[best].time_us;
+                        config_good = config_pending;
+                    }
+                    if (!rx[best].status.overflowed && rx[best].status.len == 1 + BODY_LEN(tag.fec)){ // length, seq and payload
+                        uint8_t *payload = &rx[best].packet[2];
+                        if (tag.fec){
+                            fec_decode(&rx[best].packet[1], 1 + PAYLOADSIZE, rx_decoded);
+                            payload = &rx_decoded[1];
+                        }
+                        ber_stats_update(&ber_stats, payload, PAYLOADSIZE, rx[best].time_us);
+                        salvaged += (rx[best].packet[0] != BODY_LEN(tag.fec)); // length byte: bytes after it (without the CRC)
+                        if (ANTENNA_ALTERNATE){
+                            uint8_t rx_seq = tag.fec ? rx_decoded[0] : rx[best].packet[1];
+                            link_stats_update(&phase_stats[tx_phase[rx_seq]], &rx[best].status);
+                        }
+                        if (TX_TIMESTAMP){
+                            // until the frame has been read (the time of the log line): the logging delay of core 1 is excluded
+                            uint32_t latency = (uint32_t) rx[best].time_us - read_tx_timestamp(&rx[best].packet[1 + BODY_LEN(tag.fec) - TRAILER_LEN]);
+                            latency_sum += latency;
+                            latency_max = max(latency_max, latency);
+                            latency_n++;
+                        }
+                    }
+                    rx_stats[best].selected++;
+                    // log after the statistics (a submitted slot belongs to core 1)
+                    uint8_t best_seq = copy_seq(&rx[best], tag.fec, rx_decoded);
+                    logPacket(&rx[best], &rx_slot[best]);
+                    for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+                        // a copy with a different seq is not a copy of this frame: print it as well
+                        if (r != best && rx[r].received && !rx[r].status.overflowed && !rx[best].status.overflowed && copy_seq(&rx[r], tag.fec, rx_decoded) != best_seq){
+                            logPacket(&rx[r], &rx_slot[r]);
+                        }
+                        if (rx_slot[r] != NULL){
+                            usb_logger_release(rx_slot[r]);
+                            rx_slot[r] = NULL;
+                        }
+                        rx[r].received = false;
+                    }
+                    received = false;
+                    TRACE(TRACE_IDLE);
+                }
+                rx_ready = !busy && !received;
+                // benchmark: report once the last frame of the file had the chance to be received
+                if (benchmark && sent >= FILE_FRAMES && rx_ready && time_us_64() - benchmark_sent_us > BENCHMARK_DRAIN_US){
+                    log_printf("# benchmark: file %u B, sent %u frames\n", FILE_SIZE, sent);
+                    log_ber_stats("benchmark", &ber_stats, sent);
+                    benchmark = false;
+                }
+                // re-scan periodically while the receiver is not busy
+                if (CHANNEL_SCAN && sweep_idx < 0 && rx_ready && tx_scheduler_idle(&scheduler) && to_us_since_boot(get_absolute_time()) - scan_table.time_us > ((uint64_t) SCAN_INTERVAL_MS)*1000){
+                    stop_listen_all();
+                    scan_conf.n_offsets = feasible_scan_offsets(&tag, scan_feasible);
+                    channel_scan(&scan_conf, &scan_table);
+                    scan_pending = true;
+                }
+                // apply the result of the last scan
+                if (scan_pending){
+                    struct scan_entry *best = &scan_table.entry[scan_table.best];
+                    log_scan_table(&scan_table);
+                    if (best->d0 != tag.d0 || best->d1 != tag.d1){
+                        struct tag_setting previous = tag;
+                        tag.d0 = best->d0;
+                        tag.d1 = best->d1;
+                        if (!backscatter_program_init(pio, sm, PIN_TX1, PIN_TX2, tag.d0, tag.d1, tag.baud, &backscatter_conf, instructionBuffer, tag.two_antennas)){
+                            // the state-machine has been stopped: keep the previous dividers
+                            log_printf("# scan: d0 %u d1 %u not feasible, keeping d0 %u d1 %u\n", tag.d0, tag.d1, previous.d0, previous.d1);
+                            tag = previous;
+                            backscatter_program_init(pio, sm, PIN_TX1, PIN_TX2, tag.d0, tag.d1, tag.baud, &backscatter_conf, instructionBuffer, tag.two_antennas);
+                        }
+                        if (LOOPBACK_TEST){
+                            run_loopback(pio, sm, &tag, &backscatter_conf);
+                        }
+                    }
+                    if (best->f_carrier != f_carrier){
+                        f_carrier = best->f_carrier;
+                        set_frecuency_tx(f_carrier);
+                    }
+                    configure_receiver(f_carrier, &backscatter_conf);
+                    while(get_event() != no_evt); // drop sync-word events received while scanning
+                    start_listen_all();
+                    scan_pending = false;
+                    config_pending = FAST_BOOT;
+                    config_good = false;
+                }
+                // keep the configuration in flash once a frame passed the CRC check (default frame format, no sweep or benchmark)
+                if (config_good && rx_ready && tx_scheduler_idle(&scheduler) && sweep_idx < 0 && format_idx == 0 && !benchmark){
+                    static struct flash_config record;
+                    capture_config(&record, &tag, f_carrier);
+                    if (!boot_record_valid || flash_config_differs(&record, &boot_record)){
+                        flash_config_save(&record, LOG_CORE1);
+                        boot_record = record;
+                        boot_record_valid = true;
+                        log_printf("# flash: configuration saved (d0 %u d1 %u baud %u carrier %u)\n", tag.d0, tag.d1, tag.baud, f_carrier);
+                    }
+                    config_pending = false;
+                    config_good = false;
+                }
+                // boot-to-first-frame time (once a host is connected: a fast boot does not wait for it)
+                if (boot_report && first_rx_us > 0 && console_connected()){
+                    log_printf("# boot: %s, setup %u us, first frame sent after %u us, received after %u us\n", fast_boot ? "fast boot (flash)" : "full setup",
+                           (uint32_t) setup_us, (uint32_t) first_tx_us, (uint32_t) first_rx_us);
+                    boot_report = false;
+                }
+                // backscatter new packet as soon as the receivers are re-armed (and a carrier-on window is open)
+                if (rx_ready && tx_scheduler_ready(&scheduler) && !(benchmark && sent >= FILE_FRAMES)){
+                    /* parameter sweep: summary of the finished grid point, retune tag and receivers (between carrier-on windows) */
+                    if (sweep_idx >= 0 && !benchmark_start && tx_scheduler_idle(&scheduler) && (sweep_apply || sent >= SWEEP_FRAMES)){
+                        if (!sweep_apply){
+                            uint32_t valid = max(1, merged_stats.received - merged_stats.overflowed);
+                            uint32_t per   = link_stats_per(&merged_stats, sent);
+                            uint32_t pass  = link_stats_crc_pass(&merged_stats);
+                            uint32_t data_per = ber_stats_per(&ber_stats, sent);
+                            log_printf("# sweep %3d %3u %3u %7u %u %u %5u %3u.%02u %3u.%02u %4d %4d %3u %7u %3u.%02u %7u\n", sweep_idx, tag.d0, tag.d1, tag.baud, tag.two_antennas ? 2 : 1,
+                                   tag.fec, sent, per/100, per%100, pass/100, pass%100, merged_stats.rssi_sum/((int32_t) valid), merged_stats.rssi_min,
+                                   merged_stats.lqi_sum/valid, link_stats_goodput(&merged_stats), data_per/100, data_per%100, ber_stats_goodput(&ber_stats, PAYLOADSIZE));
+                            sweep_idx++;
+                        }else{
+                            log_printf("# sweep idx  d0  d1    baud antennas fec sent PER[%%] CRC[%%] RSSI mean min LQI goodput[bit/s] data PER[%%] data goodput[bit/s]\n");
+                        }
+                        // next feasible grid point (the state-machine has to fit into the instruction memory, the receiver has to support deviation and bandwidth)
+                        bool feasible = false;
+                        while (sweep_idx < SWEEP_POINTS && !feasible){
+                            tag = sweep_point(sweep_idx);
+                            feasible = backscatter_program_init(pio, sm, PIN_TX1, PIN_TX2, tag.d0, tag.d1, tag.baud, &backscatter_conf, instructionBuffer, tag.two_antennas)
+                                       && backscatter_conf.deviation <= opt_receiver_limits(RECEIVER).max_deviation
+                                       && backscatter_conf.minRxBw <= opt_receiver_limits(RECEIVER).max_bandwidth;
+                            if (!feasible){
+                                log_printf("# sweep %3d %3u %3u %7u %u %u not feasible\n", sweep_idx, tag.d0, tag.d1, tag.baud, tag.two_antennas ? 2 : 1, tag.fec);
+                                sweep_idx++;
+                            }
+                        }
+                        if (!feasible){
+                            // sweep done: restore the default configuration
+                            log_printf("# sweep done\n");
+                            sweep_idx = -1;
+                            tag = default_tag;
+                            backscatter_program_init(pio, sm, PIN_TX1, PIN_TX2, tag.d0, tag.d1, tag.baud, &backscatter_conf, instructionBuffer, tag.two_antennas);
+                        }
+                        if (LOOPBACK_TEST){
+                            run_loopback(pio, sm, &tag, &backscatter_conf);
+                        }
+                        stop_listen_all();
+                        configure_receiver(f_carrier, &backscatter_conf);
+                        configure_format(&format, tag.fec);
+                        while(get_event() != no_evt); // drop events of the previous configuration
+                        start_listen_all();
+                        for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+                            link_stats_reset(&rx_stats[r]);
+                        }
+                        link_stats_reset(&merged_stats);
+                        ber_stats_reset(&ber_stats);
+                        sent = 0;
+                        sweep_apply = false;
+                        config_pending = FAST_BOOT;
+                        config_good = false;
+                    }
+
+                    /* switch to the next frame format (between carrier-on windows) */
+                    if (FRAME_SWEEP && sweep_idx < 0 && !benchmark && sent >= FRAMES_PER_FORMAT && tx_scheduler_idle(&scheduler)){
+                        log_printf("# frame format: preamble %u B, sync %u bit, %s length, overhead %u B\n", format.preamble_len, 8*format.sync_len,
+                               format.fixed_length ? "fixed" : "variable", header_len_format(&format));
+                        log_link_stats("merged", &merged_stats, sent);
+                        format_idx = (format_idx + 1) % (sizeof(frame_formats)/sizeof(frame_formats[0]));
+                        format = frame_formats[format_idx];
+                        stop_listen_all();
+                        configure_format(&format, tag.fec);
+                        start_listen_all();
+                        config_pending = FAST_BOOT;
+                        config_good = false;
+                        for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+                            link_stats_reset(&rx_stats[r]);
+                        }
+                        link_stats_reset(&merged_stats);
+                        ber_stats_reset(&ber_stats);
+                        sent = 0;
+                    }
+
+                    /* benchmark: restart the file and the statistics (between carrier-on windows) */
+                    if (benchmark_start && tx_scheduler_idle(&scheduler)){
+                        log_printf("# benchmark: transferring %u B in %u frames\n", FILE_SIZE, FILE_FRAMES);
+                        generator_reset(&file_generator);
+                        for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+                            link_stats_reset(&rx_stats[r]);
+                        }
+                        link_stats_reset(&merged_stats);
+                        ber_stats_reset(&ber_stats);
+                        sent = 0;
+                        benchmark_start = false;
+                        benchmark = true;
+                    }
+
+                    /* antenna phase of this frame */
+                    if (ANTENNA_ALTERNATE && tag.two_antennas){
+                        phase_idx = (phase_idx + 1) % (sizeof(antenna_phases)/sizeof(antenna_phases[0]));
+                        select_antenna_phase(antenna_phases[phase_idx], pio, sm, &tag, &backscatter_conf, instructionBuffer);
+                    }
+                    tx_phase[seq] = getAntennaPhase();
+                    phase_sent[tx_phase[seq]]++;
+
                     /* generate new data */
+                    TRACE(TRACE_GENERATE);
+                    uint32_t tx_start_us = time_us_32(); // TX timestamp: queueing, carrier start, airtime and reception are part of the latency
                     generate_data(tx_payload_buffer, PAYLOADSIZE, true);
 
-                    /* add header (10 byte) to packet */
-                    add_header(&message[0], seq, header_tmplate);
-                    /* add payload to packet */
-                    memcpy(&message[HEADER_LEN], tx_payload_buffer, PAYLOADSIZE);
+                    /* add header (preamble, sync, length, seq) to packet */
+                    TRACE(TRACE_HEADER);
+                    uint8_t header_len = add_header_format(&message[0], seq, header_tmplate, &format, BODY_LEN(tag.fec) - 1);
+                    uint8_t frame_len;
+                    if (tag.fec){
+                        /* encode seq and payload (the coded bytes replace the seq) */
+                        uint8_t plain[1 + PAYLOADSIZE] = {seq};
+                        memcpy(&plain[1], tx_payload_buffer, PAYLOADSIZE);
+                        frame_len = header_len - 1 + fec_encode(plain, 1 + PAYLOADSIZE, &message[header_len - 1]);
+                    } else {
+                        /* add payload to packet */
+                        memcpy(&message[header_len], tx_payload_buffer, PAYLOADSIZE);
+                        frame_len = header_len + PAYLOADSIZE;
+                    }
+                    /* add the TX timestamp (not encoded) */
+                    if (TX_TIMESTAMP){
+                        add_tx_timestamp(&message[frame_len], tx_start_us);
+                        frame_len += TX_TIMESTAMP_LEN;
+                    }
+                    /* add CRC (2 byte) covering length (if present), seq, payload and timestamp */
+                    if (TAG_CRC){
+                        uint8_t crc_start = format.preamble_len + format.sync_len;
+                        add_crc(&message[crc_start], frame_len - crc_start);
+                        frame_len += CRC_LEN;
+                    }
+                    memset(&message[frame_len], 0, sizeof(message) - frame_len);
 
                     /* casting for 32-bit fifo */
-                    for (uint8_t i=0; i < buffer_size(PAYLOADSIZE, HEADER_LEN); i++) {
+                    TRACE(TRACE_SWAP);
+                    uint8_t frame_words = buffer_size(frame_len, 0);
+                    for (uint8_t i=0; i < frame_words; i++) {
                         buffer[i] = ((uint32_t) message[4*i+3]) | (((uint32_t) message[4*i+2]) << 8) | (((uint32_t) message[4*i+1]) << 16) | (((uint32_t)message[4*i]) << 24);
                     }
                     /* put the data to FIFO (start backscattering) */
-                    startCarrier();
-                    sleep_ms(1); // wait for carrier to start
-                    backscatter_send(pio,sm,buffer,buffer_size(PAYLOADSIZE, HEADER_LEN));
-                    sleep_ms(ceil((((double) buffer_size(PAYLOADSIZE, HEADER_LEN))*8000.0)/((double) DESIRED_BAUD))+3); // wait transmission duration (+3ms)
-                    stopCarrier();
+                    // the carrier is only on during a window: settling time + (airtime + inter-frame gap) * TX_BURST
+                    if (tx_scheduler_window_start(&scheduler)){
+                        TRACE(TRACE_CARRIER_START);
+                        uint32_t settle_us = startCarrier_sync(); // returns once the carrier is stable
+                        if (settle_us > max_settle_us){
+                            max_settle_us = settle_us;
+                            log_printf("# carrier settling time: %u us\n", max_settle_us);
+                        }
+                    }
+                    TRACE(TRACE_FIFO);
+                    uint64_t frame_start_us = time_us_64();
+                    first_tx_us = first_tx_us ? first_tx_us : frame_start_us;
+                    backscatter_start(pio,sm,buffer,frame_words);
+                    TRACE(TRACE_AIRTIME);
+                    backscatter_wait_sent(pio,sm);            // returns when the last symbol has been sent
+                    TRACE(TRACE_CARRIER_STOP);
+                    if (tx_scheduler_sent(&scheduler, frame_start_us)){
+                        stopCarrier_sync();
+                    }
+                    if (benchmark && sent + 1 >= FILE_FRAMES){
+                        // file complete: do not keep the carrier on for the rest of the window
+                        if (tx_scheduler_close(&scheduler)){
+                            stopCarrier_sync();
+                        }
+                        benchmark_sent_us = time_us_64();
+                    }
                     /* increase seq number*/ 
                     seq++;
+                    sent++;
+                    if (sent % STATS_INTERVAL == 0){
+                        for (uint8_t r = 0; r < NUM_RECEIVERS; r++){
+                            log_link_stats(r == 0 ? "receiver 1" : "receiver 2", &rx_stats[r], sent);
+                        }
+                        log_link_stats("merged", &merged_stats, sent);
+                        log_ber_stats("BER merged", &ber_stats, sent);
+                        log_tx_scheduler(&scheduler);
+                        if (SALVAGE_LENGTH && salvaged > 0){
+                            log_printf("# salvage: %u frames with a corrupted length byte received completely\n", salvaged);
+                            salvaged = 0;
+                        }
+                        if (TX_TIMESTAMP && latency_n > 0){
+                            log_printf("# latency: frames %u mean %u us max %u us\n", latency_n, (uint32_t) (latency_sum/latency_n), latency_max);
+                            latency_n = 0;
+                            latency_sum = 0;
+                            latency_max = 0;
+                        }
+                        if (ANTENNA_ALTERNATE){
+                            // statistics of the last interval per antenna phase (lowest PER wins)
+                            int8_t best_phase = -1;
+                            for (uint8_t p = 0; p < ANTENNA_PHASES; p++){
+                                if (phase_sent[p] == 0){
+                                    continue;
+                                }
+                                char name[24];
+                                sprintf(name, "antenna %s", antennaPhaseName(p));
+                                log_link_stats(name, &phase_stats[p], phase_sent[p]);
+                                if (best_phase < 0 || link_stats_per(&phase_stats[p], phase_sent[p]) < link_stats_per(&phase_stats[best_phase], phase_sent[best_phase])){
+                                    best_phase = p;
+                                }
+                            }
+                            if (best_phase >= 0){
+                                log_printf("# antenna: best phase %s\n", antennaPhaseName(best_phase));
+                            }
+                            for (uint8_t p = 0; p < ANTENNA_PHASES; p++){
+                                link_stats_reset(&phase_stats[p]);
+                                phase_sent[p] = 0;
+                            }
+                        }
+                    }
+                    TRACE(TRACE_IDLE);
                 }
-                sleep_ms(TX_DURATION);
+            }
             break;
         }
-        sleep_ms(1);
     }
 
     /* stop carrier and receiver - never reached */
-    RX_stop_listen();
+    stop_listen_all();
     stopCarrier();
 }
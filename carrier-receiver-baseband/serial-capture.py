@@ -0,0 +1,213 @@
+#!/usr/bin/python3
+
+# Tobias Mages and Wenqing Yan
+# Course: Wireless Communication and Networked Embedded Systems, Project VT2023
+# Buffered serial capture with live statistics (replaces serial-print.py for long or fast experiments)
+#
+# - reads everything available on the port at once instead of one byte per call
+# - writes the log in batches (the log format is the one of printPacket, readable by the stats scripts)
+# - decodes text lines (printPacket) and binary records (printPacketBinary, main.c: BINARY_LOG true)
+# - shows the rolling PER (from sequence number gaps), RSSI, CRC pass rate and packets/s
+
+# usage example: python3 serial-capture.py --help
+# usage example: python3 serial-capture.py --port /dev/ttyACM0
+# usage example: python3 serial-capture.py --input raw_capture.bin --log received.txt   (decode a raw capture offline)
+
+import argparse
+import codecs
+import struct
+import sys
+import time
+from collections import deque
+from datetime import datetime
+
+# binary record (receiver_CC2500.h): sync | len | flags | rssi | lqi | time_us | frame | checksum
+SYNC = b'\xa5\x5a'
+HEADER = struct.Struct('<BBbBQ')   # after the sync word
+HEADER_LEN = len(SYNC) + HEADER.size
+FLAG_CRC = 0x01
+FLAG_OVERFLOW = 0x02
+time_resolution_us = False  # hh:mm:ss.mmmuuu instead of hh:mm:ss.mmm (--us)
+
+def format_time(time_us):
+    sec = time_us // 1000000
+    if time_resolution_us:
+        return f'{sec // 3600:02d}:{(sec // 60) % 60:02d}:{sec % 60:02d}.{time_us % 1000000:06d}'
+    return f'{sec // 3600:02d}:{(sec // 60) % 60:02d}:{sec % 60:02d}.{(time_us // 1000) % 1000:03d}'
+
+# binary record -> text line of printPacket
+def record_to_line(length, flags, rssi, time_us, frame):
+    if flags & FLAG_OVERFLOW:
+        return f'{format_time(time_us)} | packet overflow (possible length field corrupted) | CRC error'
+    crc = 'CRC pass' if flags & FLAG_CRC else 'CRC error'
+    return f"{format_time(time_us)} | {' '.join(f'{b:02x}' for b in frame)} | {rssi} {crc}"
+
+class StreamDecoder:
+    """Splits the byte stream into text lines and binary records (both returned as text lines)."""
+    def __init__(self):
+        self.buffer = bytearray()
+        self.utf8 = codecs.getincrementaldecoder('utf-8')(errors='replace')
+        self.checksum_errors = 0
+
+    def feed(self, data):
+        self.buffer += data
+        lines = []
+        pos = 0
+        buf = self.buffer
+        while pos < len(buf):
+            if buf[pos] == SYNC[0]:
+                # binary record (wait for the complete header and frame)
+                if len(buf) - pos < 2:
+                    break
+                if buf[pos + 1] != SYNC[1]:
+                    pos += 1  # not a record: resynchronize
+                    continue
+                if len(buf) - pos < HEADER_LEN:
+                    break
+                length, flags, rssi, lqi, time_us = HEADER.unpack_from(buf, pos + len(SYNC))
+                end = pos + HEADER_LEN + length + 1
+                if end > len(buf):
+                    break
+                checksum = 0
+                for b in buf[pos + len(SYNC):end]:
+                    checksum ^= b
+                if checksum != 0:
+                    self.checksum_errors += 1
+                    pos += 1  # corrupted (or false sync): resynchronize
+                    continue
+                lines.append(record_to_line(length, flags, rssi, time_us, bytes(buf[pos + HEADER_LEN:end - 1])))
+                pos = end
+            else:
+                # text line (printPacket or '#' statistics)
+                newline = buf.find(b'\n', pos)
+                if newline < 0:
+                    break
+                line = self.utf8.decode(bytes(buf[pos:newline]), final=True).rstrip('\r')
+                lines.append(line)
+                pos = newline + 1
+        del self.buffer[:pos]
+        return lines
+
+class LiveStats:
+    """Rolling statistics over the packets of the last `window` seconds (host time)."""
+    def __init__(self, window):
+        self.window = window
+        self.packets = deque()  # (host time, seq, rssi, crc)
+        self.total = 0
+        self.overflows = 0
+        self.lines = 0
+
+    def add(self, line, now):
+        self.lines += 1
+        fields = line.split('|')
+        if len(fields) != 3 or line.startswith('#'):
+            return
+        self.total += 1
+        if 'overflow' in fields[1]:
+            self.overflows += 1
+            return
+        frame = fields[1].split()
+        tail = fields[2].split()
+        if len(frame) < 2 or len(tail) < 2:
+            return
+        try:
+            self.packets.append((now, int(frame[1], 16), int(tail[0]), tail[-1] == 'pass'))
+        except ValueError:
+            return
+
+    def summary(self, now):
+        while self.packets and now - self.packets[0][0] > self.window:
+            self.packets.popleft()
+        n = len(self.packets)
+        if n == 0:
+            return f'packets {self.total:8d} | no packets in the last {self.window:.0f} s'
+        # sent frames from the (8-bit) sequence number gaps within the window
+        sent = 1
+        for i in range(1, n):
+            sent += (self.packets[i][1] - self.packets[i - 1][1]) % 256
+        crc = sum(p[3] for p in self.packets)
+        rssi = [p[2] for p in self.packets]
+        span = max(now - self.packets[0][0], 1e-3) if n > 1 else self.window
+        return (f'packets {self.total:8d} | {n/span:7.1f} packets/s | PER {100*(1 - crc/sent):6.2f} % | '
+                f'CRC pass {100*crc/n:6.2f} % | RSSI mean {sum(rssi)/n:6.1f} min {min(rssi):4d} max {max(rssi):4d} dBm | '
+                f'overflow {self.overflows}')
+
+def select_port():
+    from serial.tools.list_ports import comports
+    ports = [str(p).split(' ')[0] for p in comports()]
+    if len(ports) == 0:
+        print('Sorry, no serial ports are available.')
+        exit(1)
+    print('The available serial ports are:')
+    for p in comports():
+        print(f'- {p}')
+    port = input('\nWhich port would you like to use? ')
+    if port not in ports:
+        print('Sorry, the provided ports was not part of the list.')
+        exit(1)
+    return port
+
+time_now = datetime.now()
+parser = argparse.ArgumentParser(prog='Serial capture', description='Wireless Communication and Networked Embedded Systems, Project VT2023\nusage example: python3 serial-capture.py --port /dev/ttyACM0')
+parser.add_argument('--port', type=str, default=None, help='serial port (asked interactively if not given)')
+parser.add_argument('--baud', type=int, default=115200, help='baud-rate (ignored by the USB CDC of the Pico)')
+parser.add_argument('--log', type=str, default=f'./received_{time_now:%Y-%m-%d_%H-%M-%S}.txt', help='log file (appended)')
+parser.add_argument('--raw', type=str, default=None, help='additionally store the undecoded byte stream (e.g. to replay it with --input)')
+parser.add_argument('--input', type=str, default=None, help='decode a raw capture file instead of reading from the serial port')
+parser.add_argument('--window', type=float, default=10.0, help='window of the live statistics [s]')
+parser.add_argument('--batch', type=int, default=1000, help='write the log every BATCH lines (or at least once per second)')
+parser.add_argument('--print', action='store_true', help='print every line (as serial-print.py) instead of the live statistics')
+parser.add_argument('--us', action='store_true', help='timestamps of binary records with microseconds (e.g. for the latency of main.c: TX_TIMESTAMP)')
+args = parser.parse_args()
+time_resolution_us = args.us
+
+if args.input:
+    source = open(args.input, 'rb')
+    read = lambda: source.read(1 << 16)
+else:
+    import serial
+    port = args.port if args.port else select_port()
+    print(f'Starting to read from {port}...')
+    source = serial.Serial(port, args.baud, timeout=0.1)
+    # everything which is available (at least one byte or the timeout)
+    read = lambda: source.read(max(1, source.in_waiting))
+
+decoder = StreamDecoder()
+stats = LiveStats(args.window)
+pending = []
+raw = open(args.raw, 'ab') if args.raw else None
+last_flush = last_view = time.monotonic()
+try:
+    with open(args.log, 'a', newline='\n') as log:
+        while True:
+            data = read()
+            now = time.monotonic()
+            if args.input and len(data) == 0:
+                break
+            if raw:
+                raw.write(data)
+            for line in decoder.feed(data):
+                pending.append(line)
+                stats.add(line, now)
+                if args.print:
+                    print(line)
+            if len(pending) >= args.batch or (pending and now - last_flush > 1.0):
+                log.write('\n'.join(pending) + '\n')
+                pending = []
+                last_flush = now
+            if not args.print and now - last_view > 0.5:
+                sys.stdout.write('\r\033[K' + stats.summary(now))
+                sys.stdout.flush()
+                last_view = now
+except KeyboardInterrupt:
+    pass
+finally:
+    if pending:
+        with open(args.log, 'a', newline='\n') as log:
+            log.write('\n'.join(pending) + '\n')
+    if raw:
+        raw.close()
+    source.close()
+    if not args.print:
+        sys.stdout.write('\r\033[K' + stats.summary(time.monotonic()) + '\n')
+    print(f'{stats.lines} lines written to {args.log} ({decoder.checksum_errors} binary records with checksum errors)')
@@ -0,0 +1,419 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Columnar experiment store: aggregates many receiver logs tagged with their run settings.
+ *
+ * ingest: the packets of a log are evaluated (packet_results.hpp) and stored as one binary column
+ *         per field in <store>/<run>/ (native byte order), the run and its settings (key=value,
+ *         e.g. d0=20 baud=100000 distance=2) are appended to <store>/catalog.txt. The receive time is stored in ms
+ *         and us, the TX timestamp trailer (--tx-timestamp) in its own column.
+ * list:   prints the catalog (optionally filtered).
+ * query:  groups the matching runs by one setting and aggregates the metrics. The runs are filtered
+ *         with the catalog and only the columns of the requested metrics are memory-mapped.
+ *
+ * usage: ./experiment_store ingest <store> <log file> [--reference reference.bin | --seed 0xABCD] [--payload 14] [--fec] [--tx-timestamp] [--threads N] key=value...
+ *        ./experiment_store list <store> [key=value...]
+ *        ./experiment_store query <store> --by key [--metrics ber,per,crc,rssi,latency] [--threads N] [key=value...]
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log_parser.hpp"
+#include "packet_results.hpp"
+#include "reference.hpp"
+
+namespace fs = std::filesystem;
+
+/* columns of a run: file name and size of one element */
+struct Column {
+  const char *name;
+  size_t size;
+};
+static const Column COL_TIME       = {"time_ms.u64",    8};
+static const Column COL_TIME_US    = {"time_us.u64",    8};
+static const Column COL_TX_US      = {"tx_us.u32",      4}; // TX timestamp trailer (tx_timestamp=1 only)
+static const Column COL_SEQ        = {"seq.u8",         1};
+static const Column COL_FILE_INDEX = {"file_index.u16", 2};
+static const Column COL_LEN        = {"len.u8",         1};
+static const Column COL_BIT_ERRORS = {"bit_errors.u16", 2};
+static const Column COL_RSSI       = {"rssi.i16",       2};
+static const Column COL_CRC        = {"crc.u8",         1};
+
+/* one line of the catalog: "<run> key=value ..." */
+struct Run {
+  std::string id;
+  std::map<std::string, std::string> settings;
+};
+
+/* partial sums of one run (merged per group) */
+struct Aggregate {
+  uint64_t runs = 0;
+  uint64_t packets = 0;
+  uint64_t sent = 0;        // unwrapped sequence numbers
+  uint64_t error_free = 0;
+  uint64_t bits = 0;
+  uint64_t bit_errors = 0;
+  uint64_t crc_pass = 0;
+  double   rssi_sum = 0;
+  uint64_t latency_n = 0;   // packets of runs with the TX timestamp
+  uint64_t latency_sum = 0; // [us]
+
+  void merge(const Aggregate &other){
+    runs += other.runs;
+    packets += other.packets;
+    sent += other.sent;
+    error_free += other.error_free;
+    bits += other.bits;
+    bit_errors += other.bit_errors;
+    crc_pass += other.crc_pass;
+    rssi_sum += other.rssi_sum;
+    latency_n += other.latency_n;
+    latency_sum += other.latency_sum;
+  }
+};
+
+static void usage(const char *name){
+    std::fprintf(stderr, "usage: %s ingest <store> <log file> [--reference reference.bin | --seed 0xABCD] [--payload 14] [--fec] [--tx-timestamp] [--threads N] key=value...\n", name);
+    std::fprintf(stderr, "       %s list <store> [key=value...]\n", name);
+    std::fprintf(stderr, "       %s query <store> --by key [--metrics ber,per,crc,rssi,latency] [--threads N] [key=value...]\n", name);
+}
+
+static bool parse_setting(const std::string &arg, std::string &key, std::string &value){
+    size_t eq = arg.find('=');
+    if (eq == std::string::npos || eq == 0 || arg.find_first_of(" \t\n") != std::string::npos) {
+        return false;
+    }
+    key = arg.substr(0, eq);
+    value = arg.substr(eq + 1);
+    return true;
+}
+
+static std::vector<Run> read_catalog(const fs::path &store){
+    std::vector<Run> runs;
+    std::ifstream catalog(store / "catalog.txt");
+    std::string line;
+    while (std::getline(catalog, line)) {
+        std::istringstream fields(line);
+        Run run;
+        std::string field, key, value;
+        if (!(fields >> run.id)) continue;
+        while (fields >> field) {
+            if (parse_setting(field, key, value)) run.settings[key] = value;
+        }
+        runs.push_back(run);
+    }
+    return runs;
+}
+
+static bool matches(const Run &run, const std::map<std::string, std::string> &filter){
+    for (const auto &[key, value] : filter) {
+        auto it = run.settings.find(key);
+        if (it == run.settings.end() || it->second != value) return false;
+    }
+    return true;
+}
+
+template <typename T, typename F>
+static void write_column(const fs::path &dir, const Column &column, const std::vector<PacketResult> &packets, F field){
+    std::vector<T> values(packets.size());
+    for (size_t i = 0; i < packets.size(); i++) values[i] = (T) field(packets[i]);
+    std::ofstream out(dir / column.name, std::ios::binary);
+    out.write(reinterpret_cast<const char *>(values.data()), values.size()*sizeof(T));
+    if (!out) throw std::runtime_error(std::string("cannot write ") + (dir / column.name).string());
+}
+
+static int ingest(int argc, char **argv){
+    if (argc < 4) {
+        usage(argv[0]);
+        return 1;
+    }
+    fs::path store = argv[2];
+    std::string log_path = argv[3];
+    std::string reference_path;
+    uint32_t seed = 0xABCD;
+    unsigned payload_len = 0;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool fec = false;
+    bool tx_timestamp = false;
+    std::map<std::string, std::string> settings;
+    for (int i = 4; i < argc; i++) {
+        std::string arg = argv[i], key, value;
+        if (arg == "--payload" && i + 1 < argc) {
+            payload_len = std::strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--fec") {
+            fec = true;
+        } else if (arg == "--tx-timestamp") {
+            tx_timestamp = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 0));
+        } else if (arg == "--reference" && i + 1 < argc) {
+            reference_path = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 0);
+        } else if (parse_setting(arg, key, value)) {
+            settings[key] = value;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    try {
+        std::unique_ptr<Reference> reference(reference_path.empty() ? new Reference(seed) : new Reference(reference_path));
+        MappedFile log(log_path);
+        if (payload_len == 0) {
+            payload_len = reference->payload_size() > 0 ? reference->payload_size() : 14;
+        }
+        if (payload_len < 2 || payload_len > MAX_FRAME - 2) {
+            std::fprintf(stderr, "invalid payload length %u\n", payload_len);
+            return 1;
+        }
+        LogResults results = analyze_log(log, *reference, (uint8_t) payload_len, fec, threads, tx_timestamp);
+        if (results.packets.empty()) {
+            std::printf("Warning, the log-file seems empty.\n");
+            return 1;
+        }
+
+        // the run is written to a temporary directory and renamed once complete
+        fs::create_directories(store);
+        std::vector<Run> catalog = read_catalog(store);
+        char id[32];
+        std::snprintf(id, sizeof(id), "run_%04zu", catalog.size());
+        fs::path tmp = store / (std::string(id) + ".tmp");
+        fs::remove_all(tmp);
+        fs::create_directory(tmp);
+        const std::vector<PacketResult> &packets = results.packets;
+        write_column<uint64_t>(tmp, COL_TIME,       packets, [](const PacketResult &p){ return p.time_ms; });
+        write_column<uint64_t>(tmp, COL_TIME_US,    packets, [](const PacketResult &p){ return p.time_us; });
+        if (tx_timestamp) {
+            write_column<uint32_t>(tmp, COL_TX_US,  packets, [](const PacketResult &p){ return (uint32_t) p.time_us - p.latency_us; });
+        }
+        write_column<uint8_t> (tmp, COL_SEQ,        packets, [](const PacketResult &p){ return p.seq; });
+        write_column<uint16_t>(tmp, COL_FILE_INDEX, packets, [](const PacketResult &p){ return p.file_index; });
+        write_column<uint8_t> (tmp, COL_LEN,        packets, [](const PacketResult &p){ return p.len; });
+        write_column<uint16_t>(tmp, COL_BIT_ERRORS, packets, [](const PacketResult &p){ return p.bit_errors; });
+        write_column<int16_t> (tmp, COL_RSSI,       packets, [](const PacketResult &p){ return p.rssi; });
+        write_column<uint8_t> (tmp, COL_CRC,        packets, [](const PacketResult &p){ return p.crc; });
+        fs::rename(tmp, store / id);
+
+        std::ofstream out(store / "catalog.txt", std::ios::app);
+        char seed_str[16];
+        std::snprintf(seed_str, sizeof(seed_str), "0x%X", reference->seed());
+        out << id << " source=" << fs::path(log_path).filename().string() << " packets=" << packets.size()
+            << " overflows=" << results.overflows << " payload=" << payload_len << " fec=" << (fec ? 1 : 0)
+            << " tx_timestamp=" << (tx_timestamp ? 1 : 0) << " seed=" << seed_str;
+        for (const auto &[key, value] : settings) {
+            out << ' ' << key << '=' << value;
+        }
+        out << '\n';
+        std::printf("%s: %zu packets from %s\n", id, packets.size(), log_path.c_str());
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+static int list(int argc, char **argv){
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::map<std::string, std::string> filter;
+    for (int i = 3; i < argc; i++) {
+        std::string key, value;
+        if (!parse_setting(argv[i], key, value)) {
+            usage(argv[0]);
+            return 1;
+        }
+        filter[key] = value;
+    }
+    for (const Run &run : read_catalog(argv[2])) {
+        if (!matches(run, filter)) continue;
+        std::printf("%s", run.id.c_str());
+        for (const auto &[key, value] : run.settings) {
+            std::printf(" %s=%s", key.c_str(), value.c_str());
+        }
+        std::printf("\n");
+    }
+    return 0;
+}
+
+/* aggregate one run: only the columns required by the metrics are mapped */
+static Aggregate aggregate_run(const fs::path &dir, const Run &run, bool ber, bool per, bool crc, bool rssi, bool latency){
+    Aggregate a;
+    a.runs = 1;
+    a.packets = std::strtoull(run.settings.at("packets").c_str(), nullptr, 10);
+    uint8_t payload_len = (uint8_t) std::strtoul(run.settings.at("payload").c_str(), nullptr, 10);
+    auto column = [&](const Column &c){
+        auto file = std::make_unique<MappedFile>((dir / c.name).string());
+        if (file->size() != a.packets*c.size) throw std::runtime_error("corrupted column " + (dir / c.name).string());
+        return file;
+    };
+    if (ber || per) {
+        auto len = column(COL_LEN);
+        auto errors = column(COL_BIT_ERRORS);
+        const uint8_t *l = reinterpret_cast<const uint8_t *>(len->data());
+        const uint16_t *e = reinterpret_cast<const uint16_t *>(errors->data());
+        for (uint64_t i = 0; i < a.packets; i++) {
+            bool valid = (l[i] == payload_len);
+            a.bits += valid ? 8u*l[i] : 0u;  // the file index is counted as received bits (stats/functions.py)
+            a.bit_errors += valid ? e[i] : 0u;
+            a.error_free += valid && e[i] == 0;
+        }
+    }
+    if (per) {
+        auto seq = column(COL_SEQ);
+        const uint8_t *s = reinterpret_cast<const uint8_t *>(seq->data());
+        a.sent = a.packets > 0 ? 1 : 0;
+        for (uint64_t i = 1; i < a.packets; i++) {
+            a.sent += (uint8_t) (s[i] - s[i - 1]);
+        }
+    }
+    if (crc) {
+        auto pass = column(COL_CRC);
+        const uint8_t *c = reinterpret_cast<const uint8_t *>(pass->data());
+        for (uint64_t i = 0; i < a.packets; i++) a.crc_pass += c[i];
+    }
+    if (rssi) {
+        auto values = column(COL_RSSI);
+        const int16_t *r = reinterpret_cast<const int16_t *>(values->data());
+        int64_t sum = 0;
+        for (uint64_t i = 0; i < a.packets; i++) sum += r[i];
+        a.rssi_sum = (double) sum;
+    }
+    auto timestamp = run.settings.find("tx_timestamp");
+    if (latency && timestamp != run.settings.end() && timestamp->second == "1") {
+        auto rx_us = column(COL_TIME_US);
+        auto tx_us = column(COL_TX_US);
+        const uint64_t *rx = reinterpret_cast<const uint64_t *>(rx_us->data());
+        const uint32_t *tx = reinterpret_cast<const uint32_t *>(tx_us->data());
+        for (uint64_t i = 0; i < a.packets; i++) a.latency_sum += (uint32_t) ((uint32_t) rx[i] - tx[i]);
+        a.latency_n = a.packets;
+    }
+    return a;
+}
+
+/* numeric settings are sorted by value, others alphabetically */
+static bool setting_less(const std::string &a, const std::string &b){
+    char *end_a, *end_b;
+    double x = std::strtod(a.c_str(), &end_a);
+    double y = std::strtod(b.c_str(), &end_b);
+    if (*end_a == '\0' && *end_b == '\0' && !a.empty() && !b.empty()) return x < y;
+    return a < b;
+}
+
+static int query(int argc, char **argv){
+    if (argc < 3) {
+        usage(argv[0]);
+        return 1;
+    }
+    fs::path store = argv[2];
+    std::string by, metrics = "ber,per,crc,rssi";
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    std::map<std::string, std::string> filter;
+    for (int i = 3; i < argc; i++) {
+        std::string arg = argv[i], key, value;
+        if (arg == "--by" && i + 1 < argc) {
+            by = argv[++i];
+        } else if (arg == "--metrics" && i + 1 < argc) {
+            metrics = argv[++i];
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 0));
+        } else if (parse_setting(arg, key, value)) {
+            filter[key] = value;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (by.empty()) {
+        usage(argv[0]);
+        return 1;
+    }
+    bool ber = metrics.find("ber") != std::string::npos;
+    bool per = metrics.find("per") != std::string::npos;
+    bool crc = metrics.find("crc") != std::string::npos;
+    bool rssi = metrics.find("rssi") != std::string::npos;
+    bool latency = metrics.find("latency") != std::string::npos;
+
+    std::vector<Run> runs;
+    for (const Run &run : read_catalog(store)) {
+        if (matches(run, filter) && run.settings.count(by)) runs.push_back(run);
+    }
+    if (runs.empty()) {
+        std::printf("No runs with the setting '%s' match the filter.\n", by.c_str());
+        return 1;
+    }
+
+    // runs are distributed over the threads
+    std::vector<Aggregate> results(runs.size());
+    std::atomic<size_t> next{0};
+    std::atomic<bool> failed{false};
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < std::min<size_t>(threads, runs.size()); t++) {
+        workers.emplace_back([&](){
+            for (size_t i = next++; i < runs.size(); i = next++) {
+                try {
+                    results[i] = aggregate_run(store / runs[i].id, runs[i], ber, per, crc, rssi, latency);
+                } catch (const std::exception &e) {
+                    std::fprintf(stderr, "%s: %s\n", runs[i].id.c_str(), e.what());
+                    failed = true;
+                }
+            }
+        });
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+    if (failed) {
+        return 1;
+    }
+
+    std::map<std::string, Aggregate, std::function<bool(const std::string &, const std::string &)>> groups(setting_less);
+    for (size_t i = 0; i < runs.size(); i++) {
+        groups[runs[i].settings.at(by)].merge(results[i]);
+    }
+    std::printf("%12s %5s %10s", by.c_str(), "runs", "packets");
+    if (ber)  std::printf(" %12s", "BER [%]");
+    if (per)  std::printf(" %10s %8s", "sent", "PER [%]");
+    if (crc)  std::printf(" %8s", "CRC [%]");
+    if (rssi) std::printf(" %11s", "RSSI [dBm]");
+    if (latency) std::printf(" %12s", "latency [us]");
+    std::printf("\n");
+    for (const auto &[value, a] : groups) {
+        std::printf("%12s %5llu %10llu", value.c_str(), (unsigned long long) a.runs, (unsigned long long) a.packets);
+        if (ber)  std::printf(" %12.6f", a.bits ? 100.0*a.bit_errors/a.bits : 50.0);
+        if (per)  std::printf(" %10llu %8.3f", (unsigned long long) a.sent, a.sent ? 100.0*(1.0 - (double) a.error_free/a.sent) : 100.0);
+        if (crc)  std::printf(" %8.3f", a.packets ? 100.0*a.crc_pass/a.packets : 0.0);
+        if (rssi) std::printf(" %11.2f", a.packets ? a.rssi_sum/a.packets : 0.0);
+        if (latency && a.latency_n) std::printf(" %12.1f", (double) a.latency_sum/a.latency_n);
+        if (latency && !a.latency_n) std::printf(" %12s", "-");  // no run with the TX timestamp
+        std::printf("\n");
+    }
+    return 0;
+}
+
+int main(int argc, char **argv){
+    std::string command = argc > 1 ? argv[1] : "";
+    if (command == "ingest") return ingest(argc, argv);
+    if (command == "list")   return list(argc, argv);
+    if (command == "query")  return query(argc, argv);
+    usage(argv[0]);
+    return 1;
+}
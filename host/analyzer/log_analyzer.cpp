@@ -0,0 +1,210 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Native log analyzer: the metrics of stats/statistics.ipynb for large logs.
+ *
+ * The log is memory-mapped and split into chunks at line boundaries, each chunk is parsed by its
+ * own thread. The bit errors of each packet are computed against the reference file: memory-mapped
+ * from a file generated with make_reference or regenerated in memory (--seed). Frames encoded with
+ * fec.h (main.c: FEC) are decoded first (--fec). Frames with the TX timestamp trailer (main.c: TX_TIMESTAMP)
+ * give the one-way latency of each packet (--tx-timestamp): percentiles, jitter and delay variation.
+ * Frames with a corrupted length byte are evaluated at the expected length instead of being discarded
+ * (main.c: SALVAGE_LENGTH receives them completely).
+ *
+ * usage: ./log_analyzer <log file> [--reference reference.bin | --seed 0xABCD] [--payload 14] [--fec] [--tx-timestamp]
+ *                       [--threads N] [--csv packets.csv]
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "log_parser.hpp"
+#include "packet_results.hpp"
+#include "reference.hpp"
+
+static void usage(const char *name){
+    std::fprintf(stderr, "usage: %s <log file> [--reference reference.bin | --seed 0xABCD] [--payload 14] [--fec] [--tx-timestamp]\n"
+                         "       [--threads N] [--csv packets.csv]\n", name);
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string log_path = argv[1];
+    std::string csv_path;
+    std::string reference_path;
+    uint32_t seed = 0xABCD;
+    bool payload_given = false;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    bool fec = false;
+    bool tx_timestamp = false;
+    unsigned payload_len = 14;
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        if (arg == "--payload" && i + 1 < argc) {
+            payload_len = std::strtoul(argv[++i], nullptr, 0);
+            payload_given = true;
+        } else if (arg == "--fec") {
+            fec = true;
+        } else if (arg == "--tx-timestamp") {
+            tx_timestamp = true;
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 0));
+        } else if (arg == "--reference" && i + 1 < argc) {
+            reference_path = argv[++i];
+        } else if (arg == "--seed" && i + 1 < argc) {
+            seed = std::strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csv_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::unique_ptr<Reference> reference_ptr;
+    std::unique_ptr<MappedFile> log_ptr;
+    try {
+        reference_ptr.reset(reference_path.empty() ? new Reference(seed) : new Reference(reference_path));
+        log_ptr.reset(new MappedFile(log_path));
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    const Reference &reference = *reference_ptr;
+    const MappedFile &log = *log_ptr;
+    if (!payload_given && reference.payload_size() > 0) {
+        payload_len = reference.payload_size();
+    } else if (reference.payload_size() > 0 && reference.payload_size() != payload_len) {
+        std::fprintf(stderr, "Warning: the reference file has been generated for a payload of %u B\n", reference.payload_size());
+    }
+    if (payload_len < 2 || payload_len > MAX_FRAME - 2) {
+        std::fprintf(stderr, "invalid payload length %u\n", payload_len);
+        return 1;
+    }
+    LogResults results = analyze_log(log, reference, (uint8_t) payload_len, fec, threads, tx_timestamp);
+    const std::vector<PacketResult> &packets = results.packets;
+    uint64_t overflows = results.overflows, skipped = results.skipped;
+    if (packets.empty()) {
+        std::printf("Warning, the log-file seems empty.\n");
+        return 1;
+    }
+
+    // BER, PER (8-bit sequence number unwrapped), RSSI and CRC
+    uint64_t errors = 0, bits = 0, valid = 0, error_free = 0, crc_pass = 0, unique = 1, salvaged = 0;
+    double rssi_sum = 0, rssi_sq = 0;
+    int16_t rssi_min = packets[0].rssi, rssi_max = packets[0].rssi;
+    uint64_t unwrapped = 0;
+    for (size_t i = 0; i < packets.size(); i++) {
+        const PacketResult &p = packets[i];
+        if (i > 0) {
+            uint8_t step = (uint8_t) (p.seq - packets[i - 1].seq);
+            unwrapped += step;
+            unique += (step != 0);
+        }
+        if (p.valid_len) {
+            valid++;
+            errors += p.bit_errors;
+            bits += 8ull*p.len;  // the file index is counted as received bits (stats/functions.py)
+            error_free += (p.bit_errors == 0);
+        }
+        crc_pass += p.crc;
+        salvaged += p.salvaged;
+        rssi_sum += p.rssi;
+        rssi_sq  += (double) p.rssi*p.rssi;
+        rssi_min = std::min(rssi_min, p.rssi);
+        rssi_max = std::max(rssi_max, p.rssi);
+    }
+    uint64_t sent = unwrapped + 1;
+    double n = (double) packets.size();
+    double ber = bits ? (double) errors/bits : 0.5;
+    double per = 1.0 - (double) error_free/sent;
+    double file_delay_s = (packets.back().time_ms - packets.front().time_ms)/1000.0;
+    double rssi_mean = rssi_sum/n;
+    double rssi_std = std::sqrt(std::max(0.0, rssi_sq/n - rssi_mean*rssi_mean));
+    double data_rate = file_delay_s > 0 ? n*(payload_len - 2)/file_delay_s : 0.0;
+
+    std::printf("Packets: %zu received (%llu unique seq), %llu overflow, %llu with invalid length, %llu other lines\n", packets.size(),
+                (unsigned long long) unique, (unsigned long long) overflows, (unsigned long long) (packets.size() - valid), (unsigned long long) skipped);
+    if (salvaged > 0) {
+        std::printf("Salvaged: %llu packets with a corrupted length byte (evaluated at the expected length)\n", (unsigned long long) salvaged);
+    }
+    std::printf("The total number of packets transmitted by the tag is %llu.\n", (unsigned long long) sent);
+    std::printf("The time it takes to transfer the file is : %.3f seconds.\n", file_delay_s);
+    std::printf("Bit error rate [%%]: %.8f\t\t(in received packets within pseudo sequence + payload)\n", ber*100);
+    std::printf("Bit reliability [%%]: %.8f\n", (1 - ber)*100);
+    std::printf("Packet error rate [%%]: %.4f\t\t(lost packets and packets with bit errors)\n", per*100);
+    std::printf("CRC pass rate [%%]: %.4f\n", 100.0*crc_pass/n);
+    std::printf("Data rate [B/s]: %.8f (%.1f bit/s)\t\t(directly impacted by missed packets)\n", data_rate, 8*data_rate);
+    std::printf("RSSI [dBm]: mean %.2f std %.2f min %d max %d\n", rssi_mean, rssi_std, rssi_min, rssi_max);
+
+    // one-way latency (receive time - TX timestamp): distribution, jitter and delay variation of consecutive packets
+    if (tx_timestamp) {
+        std::vector<uint32_t> latency;
+        latency.reserve(packets.size());
+        double latency_sum = 0, latency_sq = 0, variation_sum = 0;
+        bool us_resolution = false;
+        for (size_t i = 0; i < packets.size(); i++) {
+            const PacketResult &p = packets[i];
+            latency.push_back(p.latency_us);
+            latency_sum += p.latency_us;
+            latency_sq  += (double) p.latency_us*p.latency_us;
+            if (i > 0) {
+                variation_sum += std::fabs((double) p.latency_us - packets[i - 1].latency_us);
+            }
+            us_resolution |= (p.time_us % 1000 != 0);
+        }
+        auto percentile = [&latency](double q){
+            size_t k = std::min(latency.size() - 1, (size_t) (q*latency.size()));
+            std::nth_element(latency.begin(), latency.begin() + k, latency.end());
+            return latency[k];
+        };
+        double latency_mean = latency_sum/n;
+        double latency_std = std::sqrt(std::max(0.0, latency_sq/n - latency_mean*latency_mean));
+        uint32_t p50 = percentile(0.5), p90 = percentile(0.9), p99 = percentile(0.99);
+        uint32_t latency_min = *std::min_element(latency.begin(), latency.end());
+        uint32_t latency_max = *std::max_element(latency.begin(), latency.end());
+        std::printf("Latency [us]: mean %.1f std %.1f min %u p50 %u p90 %u p99 %u max %u\t\t(receive time - TX timestamp)\n",
+                    latency_mean, latency_std, latency_min, p50, p90, p99, latency_max);
+        std::printf("Delay variation [us]: %.1f\t\t(mean |latency[i] - latency[i-1]|)\n", packets.size() > 1 ? variation_sum/(n - 1) : 0.0);
+        if (!us_resolution) {
+            std::printf("Warning: the log has timestamps in ms, the latency is quantized to 1 ms (setLogMicroseconds)\n");
+        }
+    }
+
+    if (!csv_path.empty()) {
+        FILE *csv = std::fopen(csv_path.c_str(), "w");
+        if (csv == nullptr) {
+            std::fprintf(stderr, "cannot write %s\n", csv_path.c_str());
+            return 1;
+        }
+        std::vector<char> buffer(1 << 20);
+        std::setvbuf(csv, buffer.data(), _IOFBF, buffer.size());
+        std::fprintf(csv, tx_timestamp ? "time_ms,seq,len,file_index,bit_errors,bits,rssi,crc,latency_us\n"
+                                       : "time_ms,seq,len,file_index,bit_errors,bits,rssi,crc\n");
+        for (const PacketResult &p : packets) {
+            std::fprintf(csv, "%llu,%u,%u,%u,%u,%u,%d,%d", (unsigned long long) p.time_ms, p.seq, p.len, p.file_index,
+                         p.bit_errors, p.valid_len ? 8u*p.len : 0u, p.rssi, p.crc ? 1 : 0);
+            if (tx_timestamp) {
+                std::fprintf(csv, ",%u", p.latency_us);
+            }
+            std::fprintf(csv, "\n");
+        }
+        std::fclose(csv);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "analyzed %.1f MB with %u threads in %.3f s\n", log.size()/1e6, threads, elapsed);
+    return 0;
+}
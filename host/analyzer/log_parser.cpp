@@ -0,0 +1,121 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Scanner for the receiver log (see log_parser.hpp).
+ *
+ */
+
+#include "log_parser.hpp"
+
+#include <algorithm>
+#include <cstring>
+#include <fcntl.h>
+#include <stdexcept>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static inline int hex_digit(char c){
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+static inline bool is_digit(char c){
+    return c >= '0' && c <= '9';
+}
+
+static inline const char *skip_spaces(const char *p, const char *end){
+    while (p < end && (*p == ' ' || *p == '\t')) p++;
+    return p;
+}
+
+// unsigned decimal number, returns nullptr if there is no digit
+static inline const char *parse_uint(const char *p, const char *end, uint64_t &value){
+    if (p >= end || !is_digit(*p)) return nullptr;
+    value = 0;
+    while (p < end && is_digit(*p)) value = 10*value + (*p++ - '0');
+    return p;
+}
+
+LineType parse_line(const char *p, const char *end, LogPacket &packet){
+    // timestamp: hh:mm:ss.mmm or hh:mm:ss.mmmuuu
+    uint64_t h, m, s, fraction;
+    if (!(p = parse_uint(p, end, h)) || p >= end || *p++ != ':') return LineType::skipped;
+    if (!(p = parse_uint(p, end, m)) || p >= end || *p++ != ':') return LineType::skipped;
+    if (!(p = parse_uint(p, end, s)) || p >= end || *p++ != '.') return LineType::skipped;
+    const char *digits = p;
+    if (!(p = parse_uint(p, end, fraction))) return LineType::skipped;
+    uint64_t us = (p - digits == 6) ? fraction : 1000*fraction;
+    packet.time_us = ((h*60 + m)*60 + s)*1000000 + us;
+    packet.time_ms = packet.time_us/1000;
+    p = skip_spaces(p, end);
+    if (p >= end || *p++ != '|') return LineType::skipped;
+    p = skip_spaces(p, end);
+
+    // frame: hex bytes separated by spaces (or "packet overflow ...")
+    packet.frame_len = 0;
+    packet.overflow = false;
+    packet.crc = false;
+    packet.rssi = 0;
+    if (p < end && *p == 'p') {
+        packet.overflow = true;
+        return LineType::packet;
+    }
+    while (p < end && *p != '|') {
+        int hi = hex_digit(*p);
+        int lo = (p + 1 < end) ? hex_digit(p[1]) : -1;
+        if (hi < 0 || lo < 0) return LineType::skipped;
+        if (packet.frame_len < MAX_FRAME) packet.frame[packet.frame_len++] = (uint8_t) ((hi << 4) | lo);
+        p = skip_spaces(p + 2, end);
+    }
+    if (p >= end) return LineType::skipped;
+    p = skip_spaces(p + 1, end);
+
+    // rssi and CRC
+    bool negative = (p < end && *p == '-');
+    uint64_t rssi;
+    if (!(p = parse_uint(p + negative, end, rssi))) return LineType::skipped;
+    packet.rssi = negative ? -((int16_t) rssi) : (int16_t) rssi;
+    p = skip_spaces(p, end);
+    packet.crc = (end - p >= 8 && std::memcmp(p, "CRC pass", 8) == 0);
+    return LineType::packet;
+}
+
+MappedFile::MappedFile(const std::string &path){
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0) throw std::runtime_error("cannot open " + path);
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        close(fd);
+        throw std::runtime_error("cannot stat " + path);
+    }
+    size_ = (size_t) st.st_size;
+    if (size_ > 0) {
+        void *addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (addr == MAP_FAILED) {
+            close(fd);
+            throw std::runtime_error("cannot map " + path);
+        }
+        madvise(addr, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<const char *>(addr);
+    }
+    close(fd);
+}
+
+MappedFile::~MappedFile(){
+    if (data_ != nullptr) munmap(const_cast<char *>(data_), size_);
+}
+
+std::vector<size_t> split_lines(const char *data, size_t size, unsigned n){
+    std::vector<size_t> offsets{0};
+    for (unsigned i = 1; i < n; i++) {
+        size_t pos = std::max(offsets.back(), size*i/n);
+        const void *newline = (pos < size) ? std::memchr(data + pos, '\n', size - pos) : nullptr;
+        pos = newline ? (size_t) (static_cast<const char *>(newline) - data) + 1 : size;
+        offsets.push_back(pos);
+    }
+    offsets.push_back(size);
+    return offsets;
+}
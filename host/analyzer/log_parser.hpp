@@ -0,0 +1,54 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Scanner for the receiver log (see stats/statistics.ipynb):
+ *   hh:mm:ss.mmm | len seq payload [hex] | rssi CRC pass/error
+ * The timestamp may have microseconds (hh:mm:ss.mmmuuu, setLogMicroseconds() of the firmware).
+ * Lines starting with '#' (statistics of the firmware) and other lines are skipped.
+ *
+ */
+
+#ifndef LOG_PARSER_HPP
+#define LOG_PARSER_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+constexpr size_t MAX_FRAME = 64;
+
+struct LogPacket {
+  uint64_t time_ms;         // receive timestamp [ms] (the hours are not limited to 24)
+  uint64_t time_us;         // receive timestamp [us] (ms * 1000 for a log in ms)
+  uint8_t  frame[MAX_FRAME];// len, seq, payload
+  uint8_t  frame_len;       // number of bytes in frame
+  int16_t  rssi;
+  bool     crc;
+  bool     overflow;        // "packet overflow" line
+};
+
+enum class LineType { packet, skipped };
+
+/* parse one line [begin, end) */
+LineType parse_line(const char *begin, const char *end, LogPacket &packet);
+
+/* memory-mapped, read-only file */
+class MappedFile {
+public:
+  explicit MappedFile(const std::string &path);
+  ~MappedFile();
+  MappedFile(const MappedFile &) = delete;
+  MappedFile &operator=(const MappedFile &) = delete;
+  const char *data() const { return data_; }
+  size_t size() const { return size_; }
+
+private:
+  const char *data_ = nullptr;
+  size_t size_ = 0;
+};
+
+/* split [0, size) into n chunks at line boundaries: returns n+1 offsets */
+std::vector<size_t> split_lines(const char *data, size_t size, unsigned n);
+
+#endif
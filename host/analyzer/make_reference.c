@@ -0,0 +1,64 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Generate the binary reference file (see reference_file.h) with the generator of the firmware.
+ *
+ * usage: ./make_reference <output file> [--seed 0xABCD] [--payload 14]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "packet_generation.h"
+#include "reference_file.h"
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s <output file> [--seed 0x%X] [--payload %u]\n", argv[0], DEFAULT_SEED, PAYLOADSIZE);
+        return 1;
+    }
+    uint32_t seed = DEFAULT_SEED;
+    uint32_t payload = PAYLOADSIZE;
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--seed") == 0 && i + 1 < argc) {
+            seed = strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--payload") == 0 && i + 1 < argc) {
+            payload = strtoul(argv[++i], NULL, 0);
+        } else {
+            fprintf(stderr, "unknown argument %s\n", argv[i]);
+            return 1;
+        }
+    }
+    if (payload < 2 || payload % 2 != 0 || payload > REFERENCE_PADDING) {
+        fprintf(stderr, "the payload size has to be even (2 - %u)\n", REFERENCE_PADDING);
+        return 1;
+    }
+
+    // the data of all packets, as generated by generate_data() (without the file index)
+    static uint8_t data[FILE_PERIOD + REFERENCE_PADDING];
+    struct data_generator gen;
+    generator_init(&gen, seed);
+    for (uint32_t i = 0; i < FILE_PERIOD; i += 2) {
+        uint16_t sample = generator_sample(&gen);
+        data[i]   = (uint8_t) (sample >> 8);
+        data[i+1] = (uint8_t) (sample & 0x00FF);
+    }
+    memcpy(&data[FILE_PERIOD], data, REFERENCE_PADDING);
+
+    struct reference_header header = {.seed = seed, .period = FILE_PERIOD, .payload_size = payload};
+    memcpy(header.magic, REFERENCE_MAGIC, sizeof(header.magic));
+    FILE *file = fopen(argv[1], "wb");
+    if (file == NULL) {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        return 1;
+    }
+    if (fwrite(&header, sizeof(header), 1, file) != 1 || fwrite(data, sizeof(data), 1, file) != 1) {
+        fprintf(stderr, "cannot write %s\n", argv[1]);
+        fclose(file);
+        return 1;
+    }
+    fclose(file);
+    printf("reference file %s: seed 0x%X, payload %u B, %u data bytes\n", argv[1], seed, payload, FILE_PERIOD);
+    return 0;
+}
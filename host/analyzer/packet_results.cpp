@@ -0,0 +1,107 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Per-packet evaluation of a receiver log (see packet_results.hpp).
+ *
+ */
+
+#include "packet_results.hpp"
+
+#include <cstring>
+#include <functional>
+#include <thread>
+
+extern "C" {
+#include "packet_generation.h"
+#include "fec.h"
+}
+#undef max
+#undef min
+
+static void analyze_chunk(const char *begin, const char *end, const Reference &reference, uint8_t payload_len, bool fec, bool tx_timestamp,
+                          LogResults &result){
+    LogPacket packet;
+    uint8_t decoded[1 + FEC_MAX_LEN];
+    // length byte, seq and payload (encoded with FEC) and the TX timestamp trailer
+    size_t expected = 1 + (fec ? FEC_ENCODED_LEN(1 + payload_len) : 1 + payload_len) + (tx_timestamp ? TX_TIMESTAMP_LEN : 0);
+    result.packets.reserve((end - begin)/64);
+    while (begin < end) {
+        const char *newline = static_cast<const char *>(std::memchr(begin, '\n', end - begin));
+        const char *line_end = newline ? newline : end;
+        if (parse_line(begin, line_end, packet) == LineType::packet) {
+            if (packet.overflow) {
+                result.overflows++;
+            } else if (packet.frame_len >= 2 + (tx_timestamp ? TX_TIMESTAMP_LEN : 0)) {
+                PacketResult r{};
+                if (packet.frame_len >= expected && packet.frame[0] != expected - 1) {
+                    // corrupted length byte: a larger value appends noise (variable length mode), the frame itself
+                    // is complete (or received in full by the salvage mode of the firmware)
+                    packet.frame_len = (uint8_t) expected;
+                    r.salvaged = true;
+                }
+                r.time_ms   = packet.time_ms;
+                r.time_us   = packet.time_us;
+                if (tx_timestamp) {
+                    // the trailer is not part of the evaluated payload
+                    packet.frame_len -= TX_TIMESTAMP_LEN;
+                    r.latency_us = (uint32_t) packet.time_us - read_tx_timestamp(packet.frame + packet.frame_len);
+                }
+                r.seq       = packet.frame[1];
+                r.len       = packet.frame_len - 2;
+                r.rssi      = packet.rssi;
+                r.crc       = packet.crc;
+                r.valid_len = (r.len == payload_len);
+                const uint8_t *payload = packet.frame + 2;
+                if (fec) {
+                    // encoded frame (fec.h): length byte followed by the coded seq and payload
+                    r.valid_len = (packet.frame_len == 1 + FEC_ENCODED_LEN(1 + payload_len));
+                    if (r.valid_len) {
+                        fec_decode(packet.frame + 1, 1 + payload_len, decoded);
+                        r.seq = decoded[0];
+                        r.len = payload_len;
+                        payload = decoded + 1;
+                    }
+                }
+                if (r.valid_len) {
+                    r.file_index = (uint16_t) ((payload[0] << 8) | payload[1]);
+                    // as on the device (ber_stats.c): an odd file index is compared with the start of the file
+                    uint16_t position = (r.file_index % 2 == 0) ? r.file_index : 0;
+                    r.bit_errors = bit_errors(payload + 2, reference.at(position), payload_len - 2);
+                }
+                result.packets.push_back(r);
+            } else {
+                result.skipped++;
+            }
+        } else {
+            result.skipped++;
+        }
+        begin = line_end + 1;
+    }
+}
+
+LogResults analyze_log(const MappedFile &log, const Reference &reference, uint8_t payload_len, bool fec, unsigned threads,
+                       bool tx_timestamp){
+    std::vector<size_t> offsets = split_lines(log.data(), log.size(), threads);
+    std::vector<LogResults> chunks(threads);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.emplace_back(analyze_chunk, log.data() + offsets[t], log.data() + offsets[t + 1], std::cref(reference), payload_len, fec, tx_timestamp, std::ref(chunks[t]));
+    }
+    for (auto &worker : workers) {
+        worker.join();
+    }
+
+    // merge the chunks (in order of the log)
+    LogResults results;
+    size_t total = 0;
+    for (auto &chunk : chunks) total += chunk.packets.size();
+    results.packets.reserve(total);
+    for (auto &chunk : chunks) {
+        results.packets.insert(results.packets.end(), chunk.packets.begin(), chunk.packets.end());
+        results.overflows += chunk.overflows;
+        results.skipped += chunk.skipped;
+        chunk.packets.clear();
+        chunk.packets.shrink_to_fit();
+    }
+    return results;
+}
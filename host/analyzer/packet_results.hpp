@@ -0,0 +1,46 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Per-packet evaluation of a receiver log: the log is split into chunks at line boundaries, each
+ * chunk is parsed by its own thread and the bit errors of each packet are computed against the
+ * reference. Used by log_analyzer and experiment_store.
+ * A frame with a corrupted length byte is evaluated at the expected frame length if it has been received at
+ * least up to it (salvage mode of the firmware or a length byte which is too large): the bytes beyond are dropped.
+ *
+ */
+
+#ifndef PACKET_RESULTS_HPP
+#define PACKET_RESULTS_HPP
+
+#include <cstdint>
+#include <vector>
+
+#include "log_parser.hpp"
+#include "reference.hpp"
+
+struct PacketResult {
+  uint64_t time_ms;
+  uint64_t time_us;
+  uint32_t latency_us;      // receive time - TX timestamp trailer (tx_timestamp only)
+  uint16_t file_index;
+  uint8_t  seq;
+  uint8_t  len;             // payload bytes (file index and data)
+  uint32_t bit_errors;      // bit errors in the data (valid length only)
+  int16_t  rssi;
+  bool     crc;
+  bool     valid_len;       // payload of the expected length (evaluated for the BER)
+  bool     salvaged;        // corrupted length byte: evaluated at the expected frame length
+};
+
+struct LogResults {
+  std::vector<PacketResult> packets;  // in order of the log
+  uint64_t overflows = 0;
+  uint64_t skipped = 0;     // lines which are not packets (e.g. '#' statistics)
+};
+
+/* evaluate all packets of a log with the given number of threads (fec: the frames are encoded with fec.h,
+ * tx_timestamp: the frames end with the TX timestamp trailer of packet_generation.h) */
+LogResults analyze_log(const MappedFile &log, const Reference &reference, uint8_t payload_len, bool fec, unsigned threads,
+                       bool tx_timestamp = false);
+
+#endif
@@ -0,0 +1,59 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Reference file: the data transmitted by the tag (see reference.hpp).
+ *
+ */
+
+#include "reference.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+extern "C" {
+#include "packet_generation.h"
+#include "reference_file.h"
+}
+#undef max
+#undef min
+
+Reference::Reference(uint32_t seed) : generated_(FILE_PERIOD + REFERENCE_PADDING), seed_(seed){
+    struct data_generator gen;
+    generator_init(&gen, seed);
+    for (size_t i = 0; i < FILE_PERIOD; i += 2) {
+        uint16_t sample = generator_sample(&gen);
+        generated_[i]     = (uint8_t) (sample >> 8);
+        generated_[i + 1] = (uint8_t) (sample & 0x00FF);
+    }
+    std::memcpy(generated_.data() + FILE_PERIOD, generated_.data(), REFERENCE_PADDING);
+    data_ = generated_.data();
+}
+
+Reference::Reference(const std::string &path) : file_(new MappedFile(path)){
+    struct reference_header header;
+    if (file_->size() != sizeof(header) + FILE_PERIOD + REFERENCE_PADDING) {
+        throw std::runtime_error(path + ": invalid reference file size");
+    }
+    std::memcpy(&header, file_->data(), sizeof(header));
+    if (std::memcmp(header.magic, REFERENCE_MAGIC, sizeof(header.magic)) != 0 || header.period != FILE_PERIOD) {
+        throw std::runtime_error(path + ": not a reference file");
+    }
+    seed_ = header.seed;
+    payload_size_ = header.payload_size;
+    data_ = reinterpret_cast<const uint8_t *>(file_->data()) + sizeof(header);
+}
+
+uint32_t bit_errors(const uint8_t *a, const uint8_t *b, size_t len){
+    uint32_t errors = 0;
+    size_t i = 0;
+    for (; i + 8 <= len; i += 8) {
+        uint64_t x, y;
+        std::memcpy(&x, a + i, 8);
+        std::memcpy(&y, b + i, 8);
+        errors += __builtin_popcountll(x ^ y);
+    }
+    for (; i < len; i++) {
+        errors += __builtin_popcount(a[i] ^ b[i]);
+    }
+    return errors;
+}
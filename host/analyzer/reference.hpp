@@ -0,0 +1,45 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Reference file: the data transmitted by the tag (generate_data() in packet_generation.c).
+ *
+ * The file position is a 16-bit counter and the seed is reset when it wraps, thus the file is
+ * periodic with 65536 bytes: the data of a packet with file index i starts at byte i.
+ * The data is either memory-mapped from a reference file (see reference_file.h) or regenerated.
+ *
+ */
+
+#ifndef REFERENCE_HPP
+#define REFERENCE_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "log_parser.hpp"
+
+class Reference {
+public:
+  /* regenerate the data with the given initial seed */
+  explicit Reference(uint32_t seed);
+  /* memory-map a reference file generated with make_reference */
+  explicit Reference(const std::string &path);
+  /* expected data starting at the given file position (at least 256 contiguous bytes, wrapping is resolved) */
+  const uint8_t *at(uint16_t position) const { return data_ + position; }
+  uint32_t seed() const { return seed_; }
+  uint32_t payload_size() const { return payload_size_; } // 0 if unknown
+
+private:
+  std::vector<uint8_t> generated_;   // one period followed by the first 256 bytes
+  std::unique_ptr<MappedFile> file_;
+  const uint8_t *data_ = nullptr;
+  uint32_t seed_ = 0;
+  uint32_t payload_size_ = 0;
+};
+
+/* number of differing bits (XOR and popcount, 64 bits at a time) */
+uint32_t bit_errors(const uint8_t *a, const uint8_t *b, size_t len);
+
+#endif
@@ -0,0 +1,33 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Binary reference file: the data transmitted by the tag for one (seed, payload size).
+ *
+ * layout (little endian):
+ * - header (struct reference_header, 24 bytes)
+ * - FILE_PERIOD data bytes: the byte at file offset i is the data byte at file position i
+ * - REFERENCE_PADDING bytes: the first bytes repeated, such that a packet starting at any
+ *   file offset can be read contiguously (the file position wraps after FILE_PERIOD bytes)
+ *
+ * The file is generated with make_reference (using packet_generation.c) and memory-mapped by
+ * log_analyzer and stats/functions.py.
+ *
+ */
+
+#ifndef REFERENCE_FILE_H
+#define REFERENCE_FILE_H
+
+#include <stdint.h>
+
+#define REFERENCE_MAGIC   "PBREF001"
+#define REFERENCE_PADDING 256
+
+struct reference_header {
+  char     magic[8];
+  uint32_t seed;          // initial seed of the generator
+  uint32_t period;        // FILE_PERIOD
+  uint32_t payload_size;  // payload per packet (file index and data) the file has been generated for
+  uint32_t reserved;
+};
+
+#endif
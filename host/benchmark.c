@@ -0,0 +1,182 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host benchmark of project_pico_libs: times the functions of the TX/RX hot path and the
+ * register calculators over many iterations (see host/README.md).
+ *
+ * usage: ./benchmark [iterations]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "backscatter.h"
+#include "receiver_CC2500.h"
+#include "carrier_CC2500.h"
+#include "packet_generation.h"
+#include "fec.h"
+#include "cc2500_regs.h"
+#include "host_hal.h"
+
+#define FRAME_LEN (PAYLOADSIZE + CRC_LEN)
+
+static FILE *out;                // results (stdout is muted: the libraries print their settings)
+static volatile uint32_t sink;   // keeps the results alive
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec)*1000000000 + ts.tv_nsec;
+}
+
+static void report(const char *name, uint32_t iterations, uint64_t elapsed_ns){
+    fprintf(out, "%-28s %10u %12.1f %12.3f\n", name, iterations, ((double) elapsed_ns)/iterations, ((double) elapsed_ns)/1e6);
+}
+
+/* header, payload, CRC and byte swap into 32-bit words as in carrier-receiver-baseband/main.c */
+static uint8_t assemble_frame(uint8_t *message, uint32_t *buffer, uint8_t seq, uint8_t *header_template, struct frame_format *format, uint8_t *payload){
+    uint8_t header_len = add_header_format(message, seq, header_template, format, PAYLOADSIZE);
+    memcpy(&message[header_len], payload, PAYLOADSIZE);
+    uint8_t frame_len = header_len + PAYLOADSIZE;
+    uint8_t crc_start = format->preamble_len + format->sync_len;
+    add_crc(&message[crc_start], frame_len - crc_start);
+    frame_len += CRC_LEN;
+    uint8_t frame_words = buffer_size(frame_len, 0);
+    for (uint8_t i = 0; i < frame_words; i++) {
+        buffer[i] = ((uint32_t) message[4*i+3]) | (((uint32_t) message[4*i+2]) << 8) | (((uint32_t) message[4*i+1]) << 16) | (((uint32_t) message[4*i]) << 24);
+    }
+    return frame_words;
+}
+
+int main(int argc, char **argv){
+    uint32_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 100000;
+    if (iterations == 0) {
+        fprintf(stderr, "usage: %s [iterations]\n", argv[0]);
+        return 1;
+    }
+    out = fdopen(dup(STDOUT_FILENO), "w");
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "could not mute stdout\n");
+    }
+    fprintf(out, "%-28s %10s %12s %12s\n", "benchmark", "iterations", "ns/iteration", "total [ms]");
+
+    /* state-machine generation */
+    uint16_t instructionBuffer[32] = {0};
+    struct pio_program program;
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sink += generatePIOprogram(20 + 2*(i % 4), 18, 100000, instructionBuffer, &program, true);
+    }
+    report("generatePIOprogram", iterations, now_ns() - start);
+
+    struct backscatter_config config;
+    uint32_t init_iterations = max(1, iterations/10);
+    start = now_ns();
+    for (uint32_t i = 0; i < init_iterations; i++) {
+        sink += backscatter_program_init(pio0, 0, 6, 27, 20 + 2*(i % 4), 18, 100000, &config, instructionBuffer, true);
+    }
+    report("backscatter_program_init", init_iterations, now_ns() - start);
+
+    /* payload and frame */
+    uint8_t payload[PAYLOADSIZE];
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        generate_data(payload, PAYLOADSIZE, true);
+        sink += payload[2];
+    }
+    report("generate_data", iterations, now_ns() - start);
+
+    struct data_generator gen;
+    generator_init(&gen, DEFAULT_SEED);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        generator_seek(&gen, (uint16_t) (i*0x9E36)); // even positions all over the file
+        sink += gen.seed;
+    }
+    report("generator_seek", iterations, now_ns() - start);
+
+    uint8_t message[buffer_size(FRAME_LEN, HEADER_LEN)*4] = {0};
+    uint32_t buffer[buffer_size(FRAME_LEN, HEADER_LEN)] = {0};
+    struct frame_format format = DEFAULT_FRAME_FORMAT;
+    uint8_t *header_template = packet_hdr_template(2500);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sink += assemble_frame(message, buffer, (uint8_t) i, header_template, &format, payload);
+        sink += buffer[3];
+    }
+    report("frame assembly", iterations, now_ns() - start);
+
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        message[10] = (uint8_t) i;
+        sink += crc16_cc2500(&message[8], 1 + 1 + PAYLOADSIZE);
+    }
+    report("crc16_cc2500", iterations, now_ns() - start);
+
+    /* forward error correction of seq and payload */
+    uint8_t coded[FEC_ENCODED_LEN(1 + PAYLOADSIZE)];
+    uint8_t decoded[1 + PAYLOADSIZE];
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        message[10] = (uint8_t) i;
+        sink += fec_encode(&message[9], 1 + PAYLOADSIZE, coded);
+    }
+    report("fec_encode", iterations, now_ns() - start);
+
+    uint32_t fec_iterations = max(1, iterations/10);
+    start = now_ns();
+    for (uint32_t i = 0; i < fec_iterations; i++) {
+        coded[i % sizeof(coded)] ^= 0x10; // one bit error
+        sink += fec_decode(coded, 1 + PAYLOADSIZE, decoded);
+        coded[i % sizeof(coded)] ^= 0x10;
+    }
+    report("fec_decode", fec_iterations, now_ns() - start);
+
+    /* register solvers (integer search of the exponent/mantissa pairs) */
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) {
+        sink += cc2500_datarate_regs(50000 + 100*(i % 1000)).m;
+        sink += cc2500_bandwidth_regs(300000 + 500*(i % 1000)).m;
+        sink += cc2500_deviation_regs(100000 + 100*(i % 1000)).m;
+    }
+    report("cc2500_regs (3 solvers)", iterations, now_ns() - start);
+
+    /* register calculators (SPI transfers to the CC2500 model, sleeps are skipped) */
+    gpio_init(RX_CSN);
+    gpio_put(RX_CSN, 1);
+    select_receiver_rx(0);
+    setupReceiver();
+    uint32_t rx_iterations = max(1, iterations/10);
+    start = now_ns();
+    for (uint32_t i = 0; i < rx_iterations; i++) {
+        set_frecuency_rx(2450000000 + 1000*(i % 1000));
+    }
+    report("set_frecuency_rx", rx_iterations, now_ns() - start);
+
+    start = now_ns();
+    for (uint32_t i = 0; i < rx_iterations; i++) {
+        set_frequency_deviation_rx(100000 + 100*(i % 1000));
+    }
+    report("set_frequency_deviation_rx", rx_iterations, now_ns() - start);
+
+    start = now_ns();
+    for (uint32_t i = 0; i < rx_iterations; i++) {
+        set_datarate_rx(50000 + 100*(i % 1000));
+    }
+    report("set_datarate_rx", rx_iterations, now_ns() - start);
+
+    start = now_ns();
+    for (uint32_t i = 0; i < rx_iterations; i++) {
+        set_filter_bandwidth_rx(300000 + 500*(i % 1000));
+    }
+    report("set_filter_bandwidth_rx", rx_iterations, now_ns() - start);
+
+    fprintf(out, "SPI bytes: %llu, skipped sleeps: %llu ms\n", (unsigned long long) host_spi_bytes(), (unsigned long long) host_slept_us()/1000);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,17 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for hardware/clocks.h (system clock of 125 MHz).
+ *
+ */
+
+#ifndef _HARDWARE_CLOCKS_H
+#define _HARDWARE_CLOCKS_H
+
+#include <stdint.h>
+
+enum clock_index { clk_sys = 5 };
+
+static inline uint32_t clock_get_hz(enum clock_index clk_index){ (void) clk_index; return 125000000; }
+
+#endif
@@ -0,0 +1,27 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for hardware/flash.h: the flash is an array (host_flash, zero at start), read through XIP_BASE
+ * as on the Pico. Erasing sets the bytes to 0xFF, programming can only clear bits.
+ *
+ */
+
+#ifndef _HARDWARE_FLASH_H
+#define _HARDWARE_FLASH_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define FLASH_PAGE_SIZE   (1u << 8)
+#define FLASH_SECTOR_SIZE (1u << 12)
+#ifndef PICO_FLASH_SIZE_BYTES
+#define PICO_FLASH_SIZE_BYTES (2*1024*1024)
+#endif
+
+extern uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+#define XIP_BASE ((uintptr_t) host_flash)
+
+void flash_range_erase(uint32_t flash_offs, size_t count);
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count);
+
+#endif
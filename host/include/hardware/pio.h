@@ -0,0 +1,101 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for hardware/pio.h.
+ *
+ * The loaded instructions and the state-machine configurations are stored in pio0/pio1,
+ * the state-machines are not executed: words put into the TX FIFO are counted and
+ * captured (host_pio_tx_words()), i.e., a message is sent instantly. The RX FIFOs are always empty
+ * (read as 0).
+ *
+ */
+
+#ifndef _HARDWARE_PIO_H
+#define _HARDWARE_PIO_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+#define PIO_INSTRUCTION_COUNT 32
+#define NUM_PIO_STATE_MACHINES 4
+#define PIO_FDEBUG_TXSTALL_LSB 24
+#define PIO_FDEBUG_RXSTALL_LSB 0
+
+enum pio_fifo_join { PIO_FIFO_JOIN_NONE = 0, PIO_FIFO_JOIN_TX = 1, PIO_FIFO_JOIN_RX = 2 };
+
+typedef struct {
+  uint8_t  wrap_target;
+  uint8_t  wrap;
+  uint8_t  set_base;
+  uint8_t  set_count;
+  uint8_t  sideset_base;
+  uint8_t  sideset_bits;       // including the optional bit
+  bool     sideset_optional;
+  bool     out_shift_right;
+  bool     autopull;
+  uint8_t  pull_threshold;
+  uint8_t  in_base;
+  bool     in_shift_right;
+  bool     autopush;
+  uint8_t  push_threshold;
+  enum pio_fifo_join fifo_join;
+  uint16_t clkdiv_int;
+  uint8_t  clkdiv_frac;
+} pio_sm_config;
+
+typedef struct {
+  uint32_t ctrl;
+  uint32_t fdebug;
+  uint16_t instr_mem[PIO_INSTRUCTION_COUNT];
+  uint32_t used_instruction_space;        // bit mask of the occupied instruction memory
+  pio_sm_config sm_config[NUM_PIO_STATE_MACHINES];
+  uint32_t sm_pc[NUM_PIO_STATE_MACHINES];
+  uint64_t tx_words[NUM_PIO_STATE_MACHINES]; // words put into the TX FIFO
+  uint32_t rxf[NUM_PIO_STATE_MACHINES];      // RX FIFO (always 0)
+} pio_hw_t;
+
+typedef pio_hw_t *PIO;
+extern pio_hw_t pio0_hw_inst, pio1_hw_inst;
+#define pio0 (&pio0_hw_inst)
+#define pio1 (&pio1_hw_inst)
+
+typedef struct pio_program {
+  const uint16_t *instructions;
+  uint8_t length;
+  int8_t origin;
+} pio_program_t;
+
+static inline pio_sm_config pio_get_default_sm_config(void){
+    pio_sm_config c;
+    memset(&c, 0, sizeof(c)); // all fields (C and C++ without missing initializers)
+    c.wrap = PIO_INSTRUCTION_COUNT - 1;
+    c.pull_threshold = 32;
+    c.out_shift_right = true;
+    c.push_threshold = 32;
+    c.in_shift_right = true;
+    c.clkdiv_int = 1;
+    return c;
+}
+static inline void sm_config_set_wrap(pio_sm_config *c, unsigned int wrap_target, unsigned int wrap){ c->wrap_target = wrap_target; c->wrap = wrap; }
+static inline void sm_config_set_set_pins(pio_sm_config *c, unsigned int base, unsigned int count){ c->set_base = base; c->set_count = count; }
+static inline void sm_config_set_sideset(pio_sm_config *c, unsigned int bit_count, bool optional, bool pindirs){ (void) pindirs; c->sideset_bits = bit_count; c->sideset_optional = optional; }
+static inline void sm_config_set_sideset_pins(pio_sm_config *c, unsigned int base){ c->sideset_base = base; }
+static inline void sm_config_set_fifo_join(pio_sm_config *c, enum pio_fifo_join join){ c->fifo_join = join; }
+static inline void sm_config_set_out_shift(pio_sm_config *c, bool shift_right, bool autopull, unsigned int threshold){ c->out_shift_right = shift_right; c->autopull = autopull; c->pull_threshold = threshold; }
+static inline void sm_config_set_in_pins(pio_sm_config *c, unsigned int in_base){ c->in_base = in_base; }
+static inline void sm_config_set_in_shift(pio_sm_config *c, bool shift_right, bool autopush, unsigned int threshold){ c->in_shift_right = shift_right; c->autopush = autopush; c->push_threshold = threshold; }
+static inline unsigned int pio_get_dreq(PIO pio, unsigned int sm, bool is_tx){ return ((pio == pio1) ? 8 : 0) + (is_tx ? 0 : 4) + sm; }
+static inline void sm_config_set_clkdiv_int_frac(pio_sm_config *c, uint16_t div_int, uint8_t div_frac){ c->clkdiv_int = div_int; c->clkdiv_frac = div_frac; }
+
+bool pio_can_add_program_at_offset(PIO pio, const pio_program_t *program, unsigned int offset);
+void pio_add_program_at_offset(PIO pio, const pio_program_t *program, unsigned int offset);
+void pio_clear_instruction_memory(PIO pio);
+void pio_gpio_init(PIO pio, unsigned int pin);
+int pio_sm_set_consecutive_pindirs(PIO pio, unsigned int sm, unsigned int pin_base, unsigned int pin_count, bool is_out);
+void pio_sm_init(PIO pio, unsigned int sm, unsigned int initial_pc, const pio_sm_config *config);
+void pio_sm_set_enabled(PIO pio, unsigned int sm, bool enabled);
+void pio_enable_sm_mask_in_sync(PIO pio, uint32_t mask);
+void pio_sm_put_blocking(PIO pio, unsigned int sm, uint32_t data);
+
+#endif
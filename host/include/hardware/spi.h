@@ -0,0 +1,25 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for hardware/spi.h.
+ *
+ * The bytes are exchanged with a register model of the CC2500 selected by its chip select
+ * (GPIO driven low, see host_hal.h).
+ *
+ */
+
+#ifndef _HARDWARE_SPI_H
+#define _HARDWARE_SPI_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef struct spi_inst spi_inst_t;
+extern spi_inst_t *spi0_inst;
+#define spi0 spi0_inst
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate);
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len);
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len);
+
+#endif
@@ -0,0 +1,16 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for hardware/sync.h (no interrupts on the host).
+ *
+ */
+
+#ifndef _HARDWARE_SYNC_H
+#define _HARDWARE_SYNC_H
+
+#include <stdint.h>
+
+static inline uint32_t save_and_disable_interrupts(void){ return 0; }
+static inline void restore_interrupts(uint32_t status){ (void) status; }
+
+#endif
@@ -0,0 +1,44 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host (Linux) stand-ins for the Pico SDK: access to the simulated peripherals.
+ *
+ * SPI: each chip select (GPIO driven low) addresses its own CC2500 register model. It supports
+ * single and burst register access, the command strobes (SIDLE, SRX, STX change MARCSTATE) and
+ * the status registers RSSI and MARCSTATE. The RX FIFO is always empty.
+ *
+ * PIO: the words put into the TX FIFO are captured, such that a state-machine interpreter can
+ * replay them (host/sim/pio_sim.hpp).
+ *
+ */
+
+#ifndef HOST_HAL_LIB
+#define HOST_HAL_LIB
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "hardware/pio.h"
+
+/* register value of the CC2500 model with the given chip select pin */
+uint8_t host_cc2500_register(unsigned int csn, uint8_t address);
+
+/* main radio control state machine state (MARCSTATE) of the CC2500 model */
+uint8_t host_cc2500_marcstate(unsigned int csn);
+
+/* RSSI register value returned by all CC2500 models */
+void host_cc2500_set_rssi(uint8_t rssi_dec);
+
+/* SPI transactions since start-up (bytes exchanged) */
+uint64_t host_spi_bytes(void);
+
+/* call the GPIO interrupt callback (if enabled for the pin and events) */
+void host_gpio_irq(unsigned int gpio, uint32_t events);
+
+/* copy the words put into the TX FIFO of the state-machine since the last call (at most max_words, the first 64 are kept) */
+size_t host_pio_tx_words(PIO pio, unsigned int sm, uint32_t *words, size_t max_words);
+
+/* time spent in sleep_us()/sleep_ms() since start-up [us] */
+uint64_t host_slept_us(void);
+
+#endif
@@ -0,0 +1,15 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for pico/binary_info.h (no binary info on the host).
+ *
+ */
+
+#ifndef _PICO_BINARY_INFO_H
+#define _PICO_BINARY_INFO_H
+
+#define bi_decl(...)
+#define bi_3pins_with_func(...) 0
+#define bi_1pin_with_name(...) 0
+
+#endif
@@ -0,0 +1,17 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for pico/multicore.h: core 1 is not started on the host (its loop can be called directly,
+ * e.g. usb_logger_poll()).
+ *
+ */
+
+#ifndef _PICO_MULTICORE_H
+#define _PICO_MULTICORE_H
+
+static inline void multicore_launch_core1(void (*entry)(void)){ (void) entry; }
+static inline void multicore_lockout_victim_init(void){}
+static inline void multicore_lockout_start_blocking(void){}
+static inline void multicore_lockout_end_blocking(void){}
+
+#endif
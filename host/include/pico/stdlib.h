@@ -0,0 +1,31 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for pico/stdlib.h (see host/README.md).
+ *
+ */
+
+#ifndef _PICO_STDLIB_H
+#define _PICO_STDLIB_H
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdio.h>
+#include "pico/time.h"
+#include "hardware/gpio.h"
+
+typedef unsigned int uint;
+
+#define PICO_ERROR_TIMEOUT -1
+
+static inline void stdio_init_all(void){}
+static inline void tight_loop_contents(void){}
+
+/* no CR/LF translation on the host */
+static inline int putchar_raw(int c){ return putchar(c); }
+
+/* no USB input on the host: always returns PICO_ERROR_TIMEOUT */
+int getchar_timeout_us(uint32_t timeout_us);
+
+#endif
@@ -0,0 +1,51 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for pico/time.h.
+ *
+ * The time is the monotonic clock of the host plus the time of all sleeps: sleeping returns
+ * immediately and advances the clock instead, such that timeouts expire as on the Pico while
+ * the libraries run at full speed. Alarms and repeating timers are accepted but never fire.
+ *
+ */
+
+#ifndef _PICO_TIME_H
+#define _PICO_TIME_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef uint64_t absolute_time_t;
+
+uint64_t time_us_64(void);
+static inline uint32_t time_us_32(void){ return (uint32_t) time_us_64(); }
+static inline absolute_time_t get_absolute_time(void){ return time_us_64(); }
+static inline uint64_t to_us_since_boot(absolute_time_t t){ return t; }
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to){ return (int64_t) (to - from); }
+static inline absolute_time_t delayed_by_us(absolute_time_t t, uint64_t us){ return t + us; }
+static inline absolute_time_t make_timeout_time_us(uint64_t us){ return time_us_64() + us; }
+static inline absolute_time_t make_timeout_time_ms(uint32_t ms){ return time_us_64() + 1000ull*ms; }
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+void busy_wait_us(uint64_t us);
+void sleep_until(absolute_time_t t);
+
+typedef int32_t alarm_id_t;
+typedef int64_t (*alarm_callback_t)(alarm_id_t id, void *user_data);
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past);
+bool cancel_alarm(alarm_id_t alarm_id);
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t *rt);
+struct repeating_timer {
+  int64_t delay_us;
+  alarm_id_t alarm_id;
+  repeating_timer_callback_t callback;
+  void *user_data;
+};
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out);
+static inline bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out){ return add_repeating_timer_us(delay_ms*1000ll, callback, user_data, out); }
+bool cancel_repeating_timer(repeating_timer_t *timer);
+
+#endif
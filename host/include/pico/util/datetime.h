@@ -0,0 +1,11 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for pico/util/datetime.h (not used by the libraries).
+ *
+ */
+
+#ifndef _PICO_UTIL_DATETIME_H
+#define _PICO_UTIL_DATETIME_H
+
+#endif
@@ -0,0 +1,31 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host stand-in for pico/util/queue.h: ring buffer of fixed size elements (single-threaded).
+ *
+ */
+
+#ifndef _PICO_UTIL_QUEUE_H
+#define _PICO_UTIL_QUEUE_H
+
+#include <stdint.h>
+#include <stdbool.h>
+
+typedef struct {
+  uint8_t *data;
+  uint16_t wptr;
+  uint16_t rptr;
+  uint16_t element_size;
+  uint16_t element_count;
+} queue_t;
+
+void queue_init(queue_t *q, unsigned int element_size, unsigned int element_count);
+void queue_free(queue_t *q);
+bool queue_try_add(queue_t *q, const void *data);
+bool queue_try_remove(queue_t *q, void *data);
+bool queue_try_peek(queue_t *q, void *data);
+unsigned int queue_get_level(queue_t *q);
+static inline bool queue_is_empty(queue_t *q){ return queue_get_level(q) == 0; }
+static inline bool queue_is_full(queue_t *q){ return queue_get_level(q) == q->element_count; }
+
+#endif
@@ -0,0 +1,129 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host front-end of the backscatter configuration search (project_pico_libs/backscatter_optimizer.c):
+ * prints the best (d0, d1, baud) for a receiver, carrier frequency and antenna mode. Each printed
+ * configuration is loaded with backscatter_program_init() into the PIO model to confirm that the
+ * program fits and that the computed settings match. The time of one search is reported at the end.
+ *
+ * usage: ./optimizer [--receiver 2500|1352] [--carrier 2450000000] [--antennas 1|2] [--bauds 50000,100000,...]
+ *                    [--max-divider 256] [--min-offset 1500000] [--min-index 50] [--top 10]
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "backscatter.h"
+#include "backscatter_optimizer.h"
+
+#define MAX_BAUDS 32
+#define MAX_TOP  256
+
+static void usage(const char *name){
+    fprintf(stderr, "usage: %s [--receiver 2500|1352] [--carrier 2450000000] [--antennas 1|2] [--bauds 50000,100000,...]\n"
+                    "       [--max-divider 256] [--min-offset 1500000] [--min-index 50] [--top 10]\n", name);
+}
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec)*1000000000 + ts.tv_nsec;
+}
+
+int main(int argc, char **argv){
+    uint16_t receiver = 2500;
+    uint32_t f_carrier = 2450000000u;
+    bool two_antennas = true;
+    static uint32_t bauds[MAX_BAUDS];
+    uint8_t n_bauds = 0;
+    uint16_t max_divider = OPT_MAX_DIVIDER;
+    uint32_t min_offset = OPT_MIN_OFFSET;
+    uint8_t min_index = OPT_MIN_INDEX_PCT;
+    uint16_t top = 10;
+    for (int i = 1; i < argc; i++) {
+        bool has_value = i + 1 < argc;
+        if (strcmp(argv[i], "--receiver") == 0 && has_value) {
+            receiver = (uint16_t) strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--carrier") == 0 && has_value) {
+            f_carrier = (uint32_t) strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--antennas") == 0 && has_value) {
+            two_antennas = strtoul(argv[++i], NULL, 0) == 2;
+        } else if (strcmp(argv[i], "--bauds") == 0 && has_value) {
+            for (char *s = strtok(argv[++i], ","); s != NULL && n_bauds < MAX_BAUDS; s = strtok(NULL, ",")) {
+                bauds[n_bauds++] = (uint32_t) strtod(s, NULL);
+            }
+        } else if (strcmp(argv[i], "--max-divider") == 0 && has_value) {
+            max_divider = (uint16_t) strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--min-offset") == 0 && has_value) {
+            min_offset = (uint32_t) strtod(argv[++i], NULL);
+        } else if (strcmp(argv[i], "--min-index") == 0 && has_value) {
+            min_index = (uint8_t) strtoul(argv[++i], NULL, 0);
+        } else if (strcmp(argv[i], "--top") == 0 && has_value) {
+            top = (uint16_t) strtoul(argv[++i], NULL, 0);
+            top = (top > MAX_TOP) ? MAX_TOP : top;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (receiver != 2500 && receiver != 1352) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    struct opt_search search = opt_default_search(receiver, f_carrier, two_antennas);
+    search.bauds = n_bauds ? bauds : NULL;
+    search.n_bauds = n_bauds;
+    search.max_divider = max_divider;
+    search.min_offset = min_offset;
+    search.min_index_pct = min_index;
+    static struct opt_candidate best[MAX_TOP];
+    uint32_t feasible = opt_find_best(&search, best, top);
+
+    // time of one search (repeated for at least 0.2 s)
+    uint32_t runs = 0;
+    uint64_t start = now_ns(), elapsed;
+    do {
+        opt_find_best(&search, best, top);
+        runs++;
+        elapsed = now_ns() - start;
+    } while (elapsed < 200000000);
+
+    // stdout is muted while loading the programs: the library prints its settings
+    FILE *out = fdopen(dup(STDOUT_FILENO), "w");
+    if (out == NULL || freopen("/dev/null", "w", stdout) == NULL) {
+        fprintf(stderr, "could not mute stdout\n");
+        return 1;
+    }
+    fprintf(out, "# receiver CC%u, carrier %u Hz, %s, %u feasible configurations\n",
+            receiver, f_carrier, two_antennas ? "two antennas" : "one antenna", feasible);
+    fprintf(out, "%4s %4s %4s %8s %9s %9s %9s %9s %9s %6s %6s\n",
+            "rank", "d0", "d1", "baud", "center", "deviation", "minRxBw", "filter", "guard", "index", "instr");
+    uint16_t found = (feasible < top) ? feasible : top;
+    int failures = 0;
+    for (uint16_t k = 0; k < found; k++) {
+        const struct opt_candidate *c = &best[k];
+        fprintf(out, "%4u %4u %4u %8u %9u %9u %9u %9u %9u %6.2f %6u",
+                k + 1, c->d0, c->d1, c->baud, c->center_offset, c->deviation, c->min_rx_bw, c->filter_bw, c->guard,
+                2.0*c->deviation/c->baud, c->program_length);
+        // the firmware has to accept the configuration with the same settings
+        struct backscatter_config config;
+        uint16_t instructionBuffer[32] = {0};
+        bool loaded = backscatter_program_init(pio0, 0, 6, 27, c->d0, c->d1, c->baud, &config, instructionBuffer, two_antennas);
+        bool match = loaded && config.baudrate == c->baud && config.center_offset == c->center_offset
+                     && config.deviation + 1 >= c->deviation && config.deviation <= c->deviation + 1;
+        if (!match) {
+            fprintf(out, "  MISMATCH with backscatter_program_init");
+            failures++;
+        }
+        fprintf(out, "\n");
+    }
+    fprintf(out, "# search: %.1f us (%u runs)\n", elapsed/1e3/runs, runs);
+    fclose(out);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,214 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host check of the CC2500 register solvers (project_pico_libs/cc2500_regs.c):
+ * - exhaustive: every input of the usable range is compared with a floating point reference, which
+ *   knows all settings of the register pair (sorted table, nearest or next larger value)
+ * - the previous floating point formulas (floor/log2) are evaluated on the same inputs: how often
+ *   they select a worse setting and how often the bandwidth falls below the requested one
+ * - timing of the solvers and of the previous formulas
+ *
+ * usage: ./register_check [iterations]
+ *
+ */
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "cc2500_regs.h"
+
+#define F_XOSC ((double) CC2500_XOSC)
+
+static volatile uint32_t sink;  // keeps the results alive
+
+static uint64_t now_ns(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec)*1000000000 + ts.tv_nsec;
+}
+
+static int compare_double(const void *a, const void *b){
+    double x = *(const double *) a, y = *(const double *) b;
+    return (x > y) - (x < y);
+}
+
+/* all settings of a register pair, sorted */
+struct table {
+  double values[4096];
+  unsigned n;
+};
+
+static void table_sort(struct table *t){
+    qsort(t->values, t->n, sizeof(double), compare_double);
+}
+
+/* distance of the nearest setting */
+static double table_nearest(const struct table *t, double x){
+    unsigned lo = 0, hi = t->n;
+    while (lo < hi) {
+        unsigned mid = (lo + hi)/2;
+        if (t->values[mid] < x) lo = mid + 1; else hi = mid;
+    }
+    double best = INFINITY;
+    if (lo < t->n) best = fabs(t->values[lo] - x);
+    if (lo > 0 && fabs(t->values[lo - 1] - x) < best) best = fabs(t->values[lo - 1] - x);
+    return best;
+}
+
+/* previous implementation of receiver_CC2500.c (resulting value) */
+static double legacy_datarate(uint32_t r_data){
+    uint8_t drate_e = floor(log2(((double) r_data * (1 << 20)) / F_XOSC));
+    uint8_t drate_m = floor(((double) r_data * (1 << 28)) / (F_XOSC * (1 << drate_e)) - 256.0);
+    return ((256.0 + drate_m)*(1 << drate_e)*F_XOSC)/((double) (1 << 28));
+}
+
+static double legacy_bandwidth(uint32_t bw){
+    uint8_t chanbw_e = floor(log2(F_XOSC/((double) (1 << 5) * bw)/log2(2.0)));
+    uint8_t chanbw_m = floor(F_XOSC/((double) 8.0 * bw * (1 << chanbw_e)) - 4.0);
+    return F_XOSC/(8.0*(4.0 + (chanbw_m & 0x03))*(1 << (chanbw_e & 0x03)));
+}
+
+static double legacy_deviation(uint32_t f_dev){
+    uint8_t deviation_e = floor(log2(((double) f_dev) * (1 << 14) / F_XOSC));
+    uint8_t deviation_m = floor((((double) f_dev) * (1 << 17)) / ((double) (1 << deviation_e) * F_XOSC) - 8.0);
+    return F_XOSC*(8.0 + (deviation_m & 0x07))*(1 << (deviation_e & 0x07))/((double) (1 << 17));
+}
+
+static double legacy_frequency(uint32_t f_carrier){
+    uint32_t freq = floor(f_carrier*((double) (1 << 16))/F_XOSC);
+    return F_XOSC*freq/((double) (1 << 16));
+}
+
+/* result of one solver over its input range */
+struct check {
+  uint64_t inputs, mismatches, legacy_worse, legacy_below;
+  double max_error, legacy_max_error;
+};
+
+static void report(const char *name, uint32_t from, uint32_t to, uint32_t step, struct check *c){
+    printf("%-10s %10u..%-10u step %-5u %9llu inputs %6llu mismatches | max error %9.1f Hz, previous: %9.1f Hz, worse for %llu inputs",
+           name, from, to, step, (unsigned long long) c->inputs, (unsigned long long) c->mismatches, c->max_error,
+           c->legacy_max_error, (unsigned long long) c->legacy_worse);
+    if (c->legacy_below) {
+        printf(", below the request for %llu inputs", (unsigned long long) c->legacy_below);
+    }
+    printf("\n");
+}
+
+static void update(struct check *c, double error, double reference, double legacy_error){
+    c->inputs++;
+    c->mismatches += (error > reference*(1 + 1e-12) + 1e-6);
+    c->max_error = fmax(c->max_error, error);
+    c->legacy_max_error = fmax(c->legacy_max_error, legacy_error);
+    c->legacy_worse += (legacy_error > error*(1 + 1e-12) + 1e-6);
+}
+
+int main(int argc, char **argv){
+    uint32_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 0) : 1000000;
+    static struct table t;
+    uint64_t failures = 0;
+
+    /* data rate: nearest of (256 + m) * 2^e * F_XOSC / 2^28 */
+    struct check c = {0};
+    t.n = 0;
+    for (unsigned e = 0; e < 16; e++)
+        for (unsigned m = 0; m < 256; m++)
+            t.values[t.n++] = (256.0 + m)*(1 << e)*F_XOSC/((double) (1 << 28));
+    table_sort(&t);
+    for (uint32_t r = 25; r <= 1600000; r++) {
+        struct cc2500_em s = cc2500_datarate_regs(r);
+        double value = (256.0 + s.m)*(1 << s.e)*F_XOSC/((double) (1 << 28));
+        update(&c, fabs(value - r), table_nearest(&t, r), fabs(legacy_datarate(r) - r));
+    }
+    report("data rate", 25, 1600000, 1, &c);
+    failures += c.mismatches;
+
+    /* bandwidth: narrowest F_XOSC / (8 * (4 + m) * 2^e) not below the request */
+    struct check b = {0};
+    t.n = 0;
+    for (unsigned e = 0; e < 4; e++)
+        for (unsigned m = 0; m < 4; m++)
+            t.values[t.n++] = F_XOSC/(8.0*(4 + m)*(1 << e));
+    table_sort(&t);
+    for (uint32_t bw = 1; bw <= F_XOSC/32; bw++) {
+        struct cc2500_em s = cc2500_bandwidth_regs(bw);
+        double value = F_XOSC/(8.0*(4 + s.m)*(1 << s.e));
+        double reference = t.values[t.n - 1];
+        for (unsigned k = 0; k < t.n; k++) {
+            if (t.values[k] >= bw) {
+                reference = t.values[k];
+                break;
+            }
+        }
+        double legacy = legacy_bandwidth(bw);
+        b.legacy_below += (legacy < bw);
+        update(&b, value - bw, reference - bw, fabs(legacy - bw));
+        b.mismatches += (value < bw);
+    }
+    report("bandwidth", 1, CC2500_XOSC/32, 1, &b);
+    failures += b.mismatches;
+
+    /* deviation: nearest of F_XOSC * (8 + m) * 2^e / 2^17 */
+    struct check d = {0};
+    t.n = 0;
+    for (unsigned e = 0; e < 8; e++)
+        for (unsigned m = 0; m < 8; m++)
+            t.values[t.n++] = F_XOSC*(8.0 + m)*(1 << e)/((double) (1 << 17));
+    table_sort(&t);
+    for (uint32_t f_dev = 1587; f_dev <= 380859; f_dev++) {
+        struct cc2500_em s = cc2500_deviation_regs(f_dev);
+        double value = F_XOSC*(8.0 + s.m)*(1 << s.e)/((double) (1 << 17));
+        update(&d, fabs(value - f_dev), table_nearest(&t, f_dev), fabs(legacy_deviation(f_dev) - f_dev));
+    }
+    report("deviation", 1587, 380859, 1, &d);
+    failures += d.mismatches;
+
+    /* frequency: nearest F_XOSC * freq / 2^16 (the 2400-2483.5 MHz band) */
+    struct check f = {0};
+    for (uint32_t f_carrier = 2400000000u; f_carrier <= 2483500000u; f_carrier += 7) {
+        uint32_t calculated;
+        uint32_t freq = cc2500_frequency_word(f_carrier, &calculated);
+        double value = F_XOSC*freq/((double) (1 << 16));
+        double step = F_XOSC/((double) (1 << 16));
+        double reference = fabs(round(f_carrier/step)*step - f_carrier);
+        update(&f, fabs(value - f_carrier), reference, fabs(legacy_frequency(f_carrier) - f_carrier));
+        f.mismatches += (fabs(calculated - value) > 0.5 + 1e-6);
+    }
+    report("frequency", 2400000000u, 2483500000u, 7, &f);
+    failures += f.mismatches;
+
+    /* timing */
+    printf("%-28s %10s %12s\n", "benchmark", "iterations", "ns/iteration");
+    uint64_t start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink += cc2500_datarate_regs(50000 + (i % 1000)*100).m;
+    printf("%-28s %10u %12.1f\n", "cc2500_datarate_regs", iterations, (double) (now_ns() - start)/iterations);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink += (uint32_t) legacy_datarate(50000 + (i % 1000)*100);
+    printf("%-28s %10u %12.1f\n", "previous data rate", iterations, (double) (now_ns() - start)/iterations);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink += cc2500_bandwidth_regs(300000 + (i % 1000)*500).m;
+    printf("%-28s %10u %12.1f\n", "cc2500_bandwidth_regs", iterations, (double) (now_ns() - start)/iterations);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink += (uint32_t) legacy_bandwidth(300000 + (i % 1000)*500);
+    printf("%-28s %10u %12.1f\n", "previous bandwidth", iterations, (double) (now_ns() - start)/iterations);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink += cc2500_deviation_regs(100000 + (i % 1000)*100).m;
+    printf("%-28s %10u %12.1f\n", "cc2500_deviation_regs", iterations, (double) (now_ns() - start)/iterations);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink += (uint32_t) legacy_deviation(100000 + (i % 1000)*100);
+    printf("%-28s %10u %12.1f\n", "previous deviation", iterations, (double) (now_ns() - start)/iterations);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink += cc2500_frequency_word(2450000000u + (i % 1000)*1000, NULL);
+    printf("%-28s %10u %12.1f\n", "cc2500_frequency_word", iterations, (double) (now_ns() - start)/iterations);
+    start = now_ns();
+    for (uint32_t i = 0; i < iterations; i++) sink += (uint32_t) legacy_frequency(2450000000u + (i % 1000)*1000);
+    printf("%-28s %10u %12.1f\n", "previous frequency", iterations, (double) (now_ns() - start)/iterations);
+
+    if (failures) {
+        printf("FAILED: %llu inputs without the best setting\n", (unsigned long long) failures);
+        return 1;
+    }
+    printf("all solvers select the best setting\n");
+    return 0;
+}
@@ -0,0 +1,508 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * End-to-end simulation of the backscatter link: BER/PER over Eb/N0 for many tag configurations.
+ *
+ * - tag: the frames are built by packet_generation.c (and fec.c) as in carrier-receiver-baseband/main.c,
+ *   the subcarrier waveform is obtained by executing the program of backscatter_program_init() with
+ *   the PIO interpreter (pio_sim.hpp) at the 125 MHz system clock
+ * - carrier: frequency error, Wiener phase noise and the side lobes at +-1 MHz of the CC2500 carrier
+ *   (carrier-characteristics/README.md), direct carrier leakage into the receiver
+ * - channel: AWGN and continuous-wave interferers
+ * - receiver: non-coherent 2-FSK receiver (dsp.hpp) with the data rate and channel filter bandwidth
+ *   read back from the registers of the CC2500 model (set_datarate_rx, set_filter_bandwidth_rx), after the
+ *   frequency offset compensation of the CC2500 (up to FOC_LIMIT of FOCCFG, converged on the preamble)
+ *
+ * Eb/N0 is given per channel bit and for the sideband power of a single antenna (two antennas add 6 dB).
+ * Each (configuration, frame) is simulated by its own task on all threads.
+ *
+ * usage: ./backscatter_sim [--config d0,d1,baud,antennas,fec]... [--snr 0:14:2] [--frames 100] [--threads N]
+ *                          [--freq-error 120e3] [--linewidth 1e3] [--sidelobe -20] [--leak 30]
+ *                          [--interferer offset_hz:power_db]... [--seed 1] [--csv results.csv]
+ *
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+#include "dsp.hpp"
+#include "pio_sim.hpp"
+
+extern "C" {
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "backscatter.h"
+#include "receiver_CC2500.h"
+#include "packet_generation.h"
+#include "fec.h"
+#include "host_hal.h"
+}
+#undef max
+#undef min
+
+#define SIM_RATE      25000000  // waveform: 5 cycles of the 125 MHz PIO clock per sample
+#define SIM_CYCLES          5
+#define CHANNEL_RATE   5000000  // after the first decimation (noise and receiver)
+#define LEAD_SYMBOLS        48  // idle tag before the frame (offset compensation and noise estimate)
+#define TAIL_SYMBOLS        16
+
+/* grid of the parameter sweep of carrier-receiver-baseband/main.c */
+static const uint16_t sweep_dividers[][2] = {{20, 18}, {26, 24}, {32, 30}, {40, 36}};
+static const uint32_t sweep_bauds[] = {50000, 100000, 250000};
+static const bool sweep_antennas[] = {true, false};
+static const bool sweep_fec[] = {false, true};
+
+struct TagSetting {
+  uint16_t d0, d1;
+  uint32_t baud;
+  bool     two_antennas;
+  bool     fec;
+};
+
+struct Frame {
+  std::vector<uint32_t> words;  // PIO FIFO words (preamble to CRC)
+  std::vector<uint8_t>  rx;     // bytes after the sync word as received by the CC2500 (length byte to CRC)
+  std::vector<uint8_t>  plain;  // seq and payload
+};
+
+/* a feasible tag setting with the matching receiver settings and its frames */
+struct Scenario {
+  TagSetting tag;
+  struct backscatter_config conf;
+  uint16_t instr[PIO_INSTRUCTION_COUNT];
+  pio_sm_config sm_config;
+  uint8_t initial_pc;
+  std::vector<uint32_t> init_words;  // reps0 and reps1
+  FskConfig rx;
+  double rx_deviation;
+  double rx_foc_limit;               // largest frequency offset compensation of the receiver [Hz]
+  std::vector<Frame> frames;
+};
+
+struct Interferer {
+  double offset_hz;  // relative to the receiver frequency
+  double power_db;   // relative to the sideband power of one antenna
+};
+
+struct ChannelModel {
+  double freq_error = 120e3;  // carrier frequency error [Hz]
+  double linewidth = 1e3;     // Wiener phase noise (Lorentzian -3 dB linewidth) [Hz]
+  double sidelobe_db = -20;   // side lobes at +-1 MHz [dBc]
+  double leak_db = 30;        // direct carrier at the receiver over the sideband power [dB]
+  std::vector<Interferer> interferers;
+};
+
+struct Accumulator {
+  uint64_t frames = 0, detected = 0, crc = 0, data_ok = 0, bit_errors = 0, bits = 0;
+  double snr = 0, eye_snr = 0, freq_offset = 0, timing = 0;
+
+  void add(const Accumulator &o){
+    frames += o.frames; detected += o.detected; crc += o.crc; data_ok += o.data_ok;
+    bit_errors += o.bit_errors; bits += o.bits;
+    snr += o.snr; eye_snr += o.eye_snr; freq_offset += o.freq_offset; timing += o.timing;
+  }
+};
+
+static FILE *out;  // results (stdout is muted: the libraries print their settings)
+
+static void usage(const char *name){
+    std::fprintf(stderr, "usage: %s [--config d0,d1,baud,antennas,fec]... [--snr 0:14:2] [--frames 100] [--threads N]\n"
+                         "       [--freq-error 120e3] [--linewidth 1e3] [--sidelobe -20] [--leak 30] [--interferer offset_hz:power_db]...\n"
+                         "       [--seed 1] [--csv results.csv]\n", name);
+}
+
+/* receiver settings from the registers of the CC2500 model */
+static void receiver_settings(Scenario &s){
+    set_frequency_deviation_rx(s.conf.deviation);
+    set_datarate_rx(s.conf.baudrate);
+    set_filter_bandwidth_rx(s.conf.minRxBw);
+    uint8_t mdmcfg4 = host_cc2500_register(RX_CSN, 0x10);
+    uint8_t mdmcfg3 = host_cc2500_register(RX_CSN, 0x11);
+    uint8_t deviatn = host_cc2500_register(RX_CSN, 0x15);
+    uint8_t foccfg  = host_cc2500_register(RX_CSN, 0x19);
+    s.rx.sample_rate = CHANNEL_RATE;
+    s.rx.center = 0;  // mixed by the simulator
+    s.rx.bandwidth = 26e6/(8.0*(4 + ((mdmcfg4 >> 4) & 0x03))*(1u << (mdmcfg4 >> 6)));
+    s.rx.baud = (256.0 + mdmcfg3)*std::ldexp(1.0, mdmcfg4 & 0x0F)*26e6/std::ldexp(1.0, 28);
+    s.rx_deviation = (8.0 + (deviatn & 0x07))*std::ldexp(1.0, (deviatn >> 4) & 0x07)*26e6/std::ldexp(1.0, 17);
+    // FOC_LIMIT: 0, +-BW/8, +-BW/4 or +-BW/2 (datasheet, FOCCFG)
+    static const double foc_limit[4] = {0, 1.0/8, 1.0/4, 1.0/2};
+    s.rx_foc_limit = foc_limit[foccfg & 0x03]*s.rx.bandwidth;
+}
+
+/* frames as assembled by main.c (DEFAULT_FRAME_FORMAT, CRC) */
+static void build_frames(Scenario &s, unsigned count){
+    struct frame_format format = DEFAULT_FRAME_FORMAT;
+    uint8_t *header_template = packet_hdr_template(2500);
+    uint8_t body_len = s.tag.fec ? FEC_ENCODED_LEN(1 + PAYLOADSIZE) : 1 + PAYLOADSIZE;
+    struct data_generator gen;
+    generator_init(&gen, DEFAULT_SEED);
+    uint8_t sync_len = format.sync_len;
+    s.rx.sync_word = 0;
+    for (uint8_t i = HEADER_LEN - 2 - sync_len; i < HEADER_LEN - 2; i++) {
+        s.rx.sync_word = (s.rx.sync_word << 8) | header_template[i];
+    }
+    s.rx.sync_bits = 8*sync_len;
+    s.rx.sync_errors = (sync_len == 4) ? 2 : 1;  // SYNC_MODE 30/32 or 15/16
+    s.rx.preamble_bits = 8*format.preamble_len;
+    s.rx.fixed_length = 0;
+    s.rx.crc = true;
+    for (unsigned f = 0; f < count; f++) {
+        uint8_t message[buffer_size(FEC_ENCODED_LEN(1 + PAYLOADSIZE) + CRC_LEN, HEADER_LEN)*4] = {0};
+        uint8_t payload[PAYLOADSIZE];
+        uint8_t seq = (uint8_t) f;
+        generator_data(&gen, payload, PAYLOADSIZE, true);
+        uint8_t header_len = add_header_format(message, seq, header_template, &format, body_len - 1);
+        uint8_t frame_len;
+        Frame frame;
+        frame.plain.push_back(seq);
+        frame.plain.insert(frame.plain.end(), payload, payload + PAYLOADSIZE);
+        if (s.tag.fec) {
+            frame_len = header_len - 1 + fec_encode(frame.plain.data(), 1 + PAYLOADSIZE, &message[header_len - 1]);
+        } else {
+            std::memcpy(&message[header_len], payload, PAYLOADSIZE);
+            frame_len = header_len + PAYLOADSIZE;
+        }
+        uint8_t crc_start = format.preamble_len + format.sync_len;
+        add_crc(&message[crc_start], frame_len - crc_start);
+        frame_len += CRC_LEN;
+        frame.rx.assign(&message[crc_start], &message[frame_len]);
+        uint8_t frame_words = buffer_size(frame_len, 0);
+        for (uint8_t i = 0; i < frame_words; i++) {
+            frame.words.push_back(((uint32_t) message[4*i+3]) | (((uint32_t) message[4*i+2]) << 8) | (((uint32_t) message[4*i+1]) << 16) | (((uint32_t) message[4*i]) << 24));
+        }
+        s.frames.push_back(std::move(frame));
+    }
+}
+
+/* program, configuration and receiver settings of a tag setting (false: the program does not fit) */
+static bool prepare(Scenario &s, unsigned frames){
+    if (!backscatter_program_init(pio0, 0, 6, 27, s.tag.d0, s.tag.d1, s.tag.baud, &s.conf, s.instr, s.tag.two_antennas)) {
+        return false;
+    }
+    std::memcpy(s.instr, pio0->instr_mem, sizeof(s.instr));
+    s.sm_config = pio0->sm_config[0];
+    s.initial_pc = (uint8_t) pio0->sm_pc[0];
+    uint32_t words[8];
+    size_t n = host_pio_tx_words(pio0, 0, words, 8);
+    s.init_words.assign(words, words + n);
+    receiver_settings(s);
+    build_frames(s, frames);
+    return true;
+}
+
+/* reflection of the tag (antenna levels +-1, both antennas in phase) averaged over SIM_CYCLES */
+static void waveform(const std::vector<PinRun> &runs, bool two_antennas, std::vector<float> &gamma){
+    gamma.clear();
+    float acc = 0;
+    uint32_t fill = 0;
+    for (const PinRun &run : runs) {
+        float level = ((run.pins & 1) ? 1.0f : -1.0f) + (two_antennas ? ((run.pins & 2) ? 1.0f : -1.0f) : 0.0f);
+        uint32_t cycles = run.cycles;
+        while (cycles > 0) {
+            uint32_t take = std::min(cycles, SIM_CYCLES - fill);
+            acc += level*take;
+            fill += take;
+            cycles -= take;
+            if (fill == SIM_CYCLES) {
+                gamma.push_back(acc/SIM_CYCLES);
+                acc = 0;
+                fill = 0;
+            }
+        }
+    }
+}
+
+/* per-thread state */
+struct Worker {
+  std::vector<Accumulator> results;
+  std::vector<PinRun> runs;
+  std::vector<float> gamma, phase_noise, dummy;
+  ComplexBuffer wave, channel, noisy;
+  std::vector<DecodedFrame> decoded;
+};
+
+static void simulate(const Scenario &s, size_t config_idx, size_t frame_idx, const ChannelModel &model,
+                     const std::vector<double> &snrs, uint64_t seed, Worker &w, FskReceiver &receiver, DecimatingFir &decimator){
+    const Frame &frame = s.frames[frame_idx];
+    NoiseGenerator rng(seed ^ (config_idx << 40) ^ (frame_idx << 8));
+
+    // tag: execute the PIO program, idle tag (pins high) before and after the frame
+    uint32_t cycles_per_symbol = 125000000/s.conf.baudrate;
+    w.runs.clear();
+    w.runs.push_back({LEAD_SYMBOLS*cycles_per_symbol + rng.next() % cycles_per_symbol, 0x03});
+    PioStateMachine sm(s.instr, s.sm_config, s.initial_pc);
+    for (uint32_t word : s.init_words) sm.put(word);
+    for (uint32_t word : frame.words) sm.put(word);
+    sm.run(w.runs, 1ull << 32);
+    w.runs.push_back({TAIL_SYMBOLS*cycles_per_symbol, sm.pins()});
+    waveform(w.runs, s.tag.two_antennas, w.gamma);
+    size_t n = w.gamma.size();
+
+    // carrier (frequency error, phase noise, side lobes, leakage) mixed to the receiver frequency
+    w.phase_noise.assign(n, 0.0f);
+    w.dummy.assign(n, 0.0f);
+    rng.add(w.phase_noise.data(), w.dummy.data(), n, (float) std::sqrt(TWO_PI*model.linewidth/SIM_RATE));
+    // frequency offset compensation (FOCCFG) converged on the preamble: the receiver is retuned by the frequency error
+    // up to +-FOC_LIMIT before its channel filter, the remaining error is left to the FSK receiver
+    double foc = std::min(s.rx_foc_limit, std::max(-s.rx_foc_limit, model.freq_error));
+    double phase = TWO_PI*rng.uniform();
+    double step = TWO_PI*(model.freq_error - foc - (double) s.conf.center_offset)/SIM_RATE;
+    double lobe_phase = TWO_PI*rng.uniform(), lobe_step = TWO_PI*1e6/SIM_RATE;
+    float lobe = (float) (2*std::pow(10.0, model.sidelobe_db/20));
+    float sideband = (float) (2/M_PI);  // fundamental of the +-1 square wave
+    float leak = (float) (sideband*std::pow(10.0, model.leak_db/20));
+    w.wave.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        phase += step + w.phase_noise[k];
+        float envelope = (w.gamma[k] + leak)*(1.0f + lobe*(float) std::cos(lobe_phase + lobe_step*k));
+        w.wave.i[k] = envelope*(float) std::cos(phase);
+        w.wave.q[k] = envelope*(float) std::sin(phase);
+    }
+    w.channel.clear();
+    decimator.reset();
+    decimator.process(w.wave.i.data(), w.wave.q.data(), n, w.channel);
+    size_t m = w.channel.size();
+
+    // AWGN and interferers per Eb/N0
+    double signal = sideband*sideband;
+    for (size_t p = 0; p < snrs.size(); p++) {
+        w.noisy.i = w.channel.i;
+        w.noisy.q = w.channel.q;
+        for (const Interferer &inter : model.interferers) {
+            float amplitude = (float) std::sqrt(signal*std::pow(10.0, inter.power_db/10));
+            Nco tone(inter.offset_hz, CHANNEL_RATE);
+            w.dummy.assign(m, 0.0f);
+            w.phase_noise.assign(m, amplitude);
+            tone.mix(w.phase_noise.data(), w.dummy.data(), m);
+            for (size_t k = 0; k < m; k++) {
+                w.noisy.i[k] += w.phase_noise[k];
+                w.noisy.q[k] += w.dummy[k];
+            }
+        }
+        double ebn0 = std::pow(10.0, snrs[p]/10);
+        float sigma = (float) std::sqrt(signal*CHANNEL_RATE/(2*s.conf.baudrate*ebn0));
+        rng.add(w.noisy.i.data(), w.noisy.q.data(), m, sigma);
+        w.decoded.clear();
+        receiver.reset();
+        receiver.process(w.noisy.i.data(), w.noisy.q.data(), m, w.decoded);
+
+        // best decoded frame of the expected length
+        Accumulator &acc = w.results[config_idx*snrs.size() + p];
+        acc.frames++;
+        const DecodedFrame *best = nullptr;
+        uint32_t best_errors = 0;
+        for (const DecodedFrame &d : w.decoded) {
+            if (d.overflow || d.data.size() != frame.rx.size()) {
+                continue;
+            }
+            uint32_t errors = 0;
+            for (size_t b = 0; b < d.data.size(); b++) {
+                errors += __builtin_popcount(d.data[b] ^ frame.rx[b]);
+            }
+            if (best == nullptr || errors < best_errors) {
+                best = &d;
+                best_errors = errors;
+            }
+        }
+        if (best == nullptr) {
+            continue;
+        }
+        acc.detected++;
+        acc.crc += best->crc_ok;
+        acc.bit_errors += best_errors;
+        acc.bits += 8*best->data.size();
+        if (s.tag.fec) {
+            uint8_t decoded[1 + PAYLOADSIZE];
+            fec_decode(&best->data[1], 1 + PAYLOADSIZE, decoded);
+            acc.data_ok += (std::memcmp(decoded, frame.plain.data(), 1 + PAYLOADSIZE) == 0);
+        } else {
+            acc.data_ok += (best_errors == 0);
+        }
+        acc.snr += best->snr_db;
+        acc.eye_snr += best->eye_snr_db;
+        acc.freq_offset += foc + best->freq_offset_hz;
+        acc.timing += std::fabs(best->timing_error);
+    }
+}
+
+static bool parse_range(const char *arg, std::vector<double> &values){
+    double a, b, step;
+    if (std::sscanf(arg, "%lf:%lf:%lf", &a, &b, &step) == 3 && step > 0 && b >= a) {
+        values.clear();
+        for (double v = a; v <= b + 1e-9; v += step) values.push_back(v);
+        return true;
+    }
+    if (std::sscanf(arg, "%lf", &a) == 1) {
+        values.assign(1, a);
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv){
+    std::vector<TagSetting> settings;
+    std::vector<double> snrs;
+    parse_range("0:14:2", snrs);
+    unsigned frames = 100;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t seed = 1;
+    ChannelModel model;
+    std::string csv_path;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--config" && has_value) {
+            unsigned d0, d1, baud, antennas, fec = 0;
+            if (std::sscanf(argv[++i], "%u,%u,%u,%u,%u", &d0, &d1, &baud, &antennas, &fec) < 4) {
+                usage(argv[0]);
+                return 1;
+            }
+            settings.push_back({(uint16_t) d0, (uint16_t) d1, baud, antennas == 2, fec != 0});
+        } else if (arg == "--snr" && has_value) {
+            if (!parse_range(argv[++i], snrs)) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--frames" && has_value) {
+            frames = std::max(1ul, std::strtoul(argv[++i], nullptr, 0));
+        } else if (arg == "--threads" && has_value) {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 0));
+        } else if (arg == "--freq-error" && has_value) {
+            model.freq_error = std::atof(argv[++i]);
+        } else if (arg == "--linewidth" && has_value) {
+            model.linewidth = std::atof(argv[++i]);
+        } else if (arg == "--sidelobe" && has_value) {
+            model.sidelobe_db = std::atof(argv[++i]);
+        } else if (arg == "--leak" && has_value) {
+            model.leak_db = std::atof(argv[++i]);
+        } else if (arg == "--interferer" && has_value) {
+            Interferer inter;
+            if (std::sscanf(argv[++i], "%lf:%lf", &inter.offset_hz, &inter.power_db) != 2 || std::fabs(inter.offset_hz) >= CHANNEL_RATE/2) {
+                usage(argv[0]);
+                return 1;
+            }
+            model.interferers.push_back(inter);
+        } else if (arg == "--seed" && has_value) {
+            seed = std::strtoull(argv[++i], nullptr, 0);
+        } else if (arg == "--csv" && has_value) {
+            csv_path = argv[++i];
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (settings.empty()) {
+        for (auto &d : sweep_dividers)
+            for (uint32_t baud : sweep_bauds)
+                for (bool antennas : sweep_antennas)
+                    for (bool fec : sweep_fec)
+                        settings.push_back({d[0], d[1], baud, antennas, fec});
+    }
+
+    out = fdopen(dup(STDOUT_FILENO), "w");
+    if (freopen("/dev/null", "w", stdout) == NULL) {
+        std::fprintf(stderr, "could not mute stdout\n");
+    }
+    auto start = std::chrono::steady_clock::now();
+
+    // stage 1 (sequential, the libraries share the PIO and CC2500 models): programs, receiver settings and frames
+    gpio_init(RX_CSN);
+    gpio_put(RX_CSN, 1);
+    select_receiver_rx(0);
+    setupReceiver();
+    std::vector<Scenario> scenarios;
+    for (const TagSetting &tag : settings) {
+        Scenario s;
+        s.tag = tag;
+        if (!prepare(s, frames)) {
+            std::fprintf(out, "# %3u %3u %7u %u %u not feasible\n", tag.d0, tag.d1, tag.baud, tag.two_antennas ? 2 : 1, tag.fec);
+            continue;
+        }
+        std::fprintf(out, "# %3u %3u %7u %u %u: center %u Hz, deviation %u Hz, receiver %.0f Baud, deviation %.0f Hz, bandwidth %.0f Hz\n",
+                     tag.d0, tag.d1, tag.baud, tag.two_antennas ? 2 : 1, tag.fec, s.conf.center_offset, s.conf.deviation,
+                     s.rx.baud, s.rx_deviation, s.rx.bandwidth);
+        scenarios.push_back(std::move(s));
+    }
+    if (scenarios.empty()) {
+        std::fprintf(stderr, "no feasible configuration\n");
+        return 1;
+    }
+
+    // stage 2 (all threads): one task per (configuration, frame) for all Eb/N0
+    size_t tasks = scenarios.size()*frames;
+    std::atomic<size_t> next(0);
+    std::vector<Worker> workers(threads);
+    std::vector<std::thread> pool;
+    for (unsigned t = 0; t < threads; t++) {
+        pool.emplace_back([&, t](){
+            Worker &w = workers[t];
+            w.results.resize(scenarios.size()*snrs.size());
+            DecimatingFir decimator(design_lowpass(101, 2.2e6/SIM_RATE), SIM_RATE/CHANNEL_RATE);
+            std::vector<std::unique_ptr<FskReceiver>> receivers(scenarios.size());
+            for (size_t task; (task = next.fetch_add(1)) < tasks; ) {
+                size_t c = task/frames, f = task % frames;
+                if (!receivers[c]) {
+                    receivers[c].reset(new FskReceiver(scenarios[c].rx));
+                }
+                simulate(scenarios[c], c, f, model, snrs, seed, w, *receivers[c], decimator);
+            }
+        });
+    }
+    for (std::thread &t : pool) t.join();
+    std::vector<Accumulator> results(scenarios.size()*snrs.size());
+    for (const Worker &w : workers)
+        for (size_t k = 0; k < results.size(); k++)
+            results[k].add(w.results[k]);
+
+    // BER, PER (error-free data after decoding) and goodput of back-to-back frames
+    FILE *csv = nullptr;
+    if (!csv_path.empty()) {
+        csv = std::fopen(csv_path.c_str(), "w");
+        if (csv == nullptr) {
+            std::fprintf(stderr, "cannot write %s\n", csv_path.c_str());
+            return 1;
+        }
+        std::fprintf(csv, "d0,d1,baud,antennas,fec,ebn0_db,frames,detected,crc_pass,ber,per,goodput,snr_db,eye_snr_db,freq_offset_hz,timing_error\n");
+    }
+    std::fprintf(out, "#  d0  d1    baud a f  Eb/N0 detected  CRC pass        BER      PER  goodput [bit/s]  SNR  eye SNR  offset [Hz] timing\n");
+    for (size_t c = 0; c < scenarios.size(); c++) {
+        const Scenario &s = scenarios[c];
+        double airtime = 8.0*(8 + s.frames[0].rx.size())/s.conf.baudrate;  // preamble and sync word (DEFAULT_FRAME_FORMAT)
+        for (size_t p = 0; p < snrs.size(); p++) {
+            const Accumulator &a = results[c*snrs.size() + p];
+            double detected = std::max<uint64_t>(1, a.detected);
+            double ber = a.bits ? (double) a.bit_errors/a.bits : 0.5;
+            double per = 1.0 - (double) a.data_ok/a.frames;
+            double goodput = (1 - per)*8*(PAYLOADSIZE - 2)/airtime;
+            std::fprintf(out, "  %3u %3u %7u %u %u %6.1f %8.4f %9.4f %10.3e %8.4f %16.1f %5.1f %8.1f %12.0f %6.3f\n",
+                         s.tag.d0, s.tag.d1, s.conf.baudrate, s.tag.two_antennas ? 2 : 1, s.tag.fec, snrs[p],
+                         (double) a.detected/a.frames, (double) a.crc/a.frames, ber, per, goodput,
+                         a.snr/detected, a.eye_snr/detected, a.freq_offset/detected, a.timing/detected);
+            if (csv) {
+                std::fprintf(csv, "%u,%u,%u,%u,%u,%.2f,%llu,%llu,%llu,%.6e,%.6f,%.2f,%.3f,%.3f,%.1f,%.4f\n",
+                             s.tag.d0, s.tag.d1, s.conf.baudrate, s.tag.two_antennas ? 2 : 1, s.tag.fec, snrs[p],
+                             (unsigned long long) a.frames, (unsigned long long) a.detected, (unsigned long long) a.crc,
+                             ber, per, goodput, a.snr/detected, a.eye_snr/detected, a.freq_offset/detected, a.timing/detected);
+            }
+        }
+    }
+    if (csv) {
+        std::fclose(csv);
+    }
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    std::fprintf(stderr, "simulated %zu configurations x %zu Eb/N0 x %u frames with %u threads in %.1f s\n",
+                 scenarios.size(), snrs.size(), frames, threads, elapsed);
+    fclose(out);
+    return 0;
+}
@@ -0,0 +1,427 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * DSP blocks and FSK receiver (see dsp.hpp).
+ *
+ */
+
+#include "dsp.hpp"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+extern "C" {
+#include "packet_generation.h"
+}
+#undef max
+#undef min
+
+std::vector<float> design_lowpass(unsigned taps, double cutoff){
+    std::vector<float> h(taps);
+    double sum = 0;
+    double mid = (taps - 1)/2.0;
+    for (unsigned n = 0; n < taps; n++) {
+        double t = n - mid;
+        double sinc = (t == 0) ? 2*cutoff : std::sin(TWO_PI*cutoff*t)/(M_PI*t);
+        double w = (taps > 1) ? 0.42 - 0.5*std::cos(TWO_PI*n/(taps - 1)) + 0.08*std::cos(2*TWO_PI*n/(taps - 1)) : 1.0;
+        h[n] = (float) (sinc*w);
+        sum += h[n];
+    }
+    for (float &v : h) {
+        v = (float) (v/sum);
+    }
+    return h;
+}
+
+float fast_atan2(float y, float x){
+    // octant reduction with selects, minimax polynomial of atan on [0, 1]
+    float ax = std::fabs(x), ay = std::fabs(y);
+    float mx = std::max(ax, ay), mn = std::min(ax, ay);
+    float a = mn/(mx + 1e-30f);
+    float s = a*a;
+    float r = ((((-0.0046496475f*s + 0.0241390751f)*s - 0.0622092155f)*s + 0.1056051035f)*s - 0.1413809695f)*s;
+    r = ((r + 0.1997542489f)*s - 0.3333096504f)*s*a + a;
+    r = (ay > ax) ? 1.57079637f - r : r;
+    r = (x < 0) ? 3.14159274f - r : r;
+    return (y < 0) ? -r : r;
+}
+
+// ------------- //
+// mixer and FIR //
+// ------------- //
+
+Nco::Nco(double freq, double sample_rate) : step_(TWO_PI*freq/sample_rate), rot_i_(BLOCK), rot_q_(BLOCK){
+    for (size_t k = 0; k < BLOCK; k++) {
+        rot_i_[k] = (float) std::cos(step_*k);
+        rot_q_[k] = (float) std::sin(step_*k);
+    }
+}
+
+void Nco::mix(float *i, float *q, size_t n){
+    for (size_t start = 0; start < n; start += BLOCK) {
+        size_t len = std::min(BLOCK, n - start);
+        // phasor of the block start (double precision), rotated by the table
+        float pi = (float) std::cos(phase_), pq = (float) std::sin(phase_);
+        float *bi = i + start, *bq = q + start;
+        for (size_t k = 0; k < len; k++) {
+            float ci = pi*rot_i_[k] - pq*rot_q_[k];
+            float cq = pi*rot_q_[k] + pq*rot_i_[k];
+            float si = bi[k], sq = bq[k];
+            bi[k] = si*ci - sq*cq;
+            bq[k] = si*cq + sq*ci;
+        }
+        phase_ = std::fmod(phase_ + step_*len, TWO_PI);
+    }
+}
+
+DecimatingFir::DecimatingFir(const std::vector<float> &taps, unsigned decimation)
+    : taps_(taps.rbegin(), taps.rend()), decimation_(std::max(1u, decimation)){
+    reset();
+}
+
+void DecimatingFir::reset(){
+    hist_i_.assign(taps_.size() - 1, 0.0f);
+    hist_q_.assign(taps_.size() - 1, 0.0f);
+    next_ = taps_.size() - 1;
+}
+
+void DecimatingFir::process(const float *i, const float *q, size_t n, ComplexBuffer &out){
+    size_t history = taps_.size() - 1;
+    hist_i_.insert(hist_i_.end(), i, i + n);
+    hist_q_.insert(hist_q_.end(), q, q + n);
+    const float *h = taps_.data();
+    size_t taps = taps_.size();
+    for (; next_ < hist_i_.size(); next_ += decimation_) {
+        const float *xi = &hist_i_[next_ - history];
+        const float *xq = &hist_q_[next_ - history];
+        float acc_i = 0, acc_q = 0;
+        for (size_t t = 0; t < taps; t++) {
+            acc_i += h[t]*xi[t];
+            acc_q += h[t]*xq[t];
+        }
+        out.i.push_back(acc_i);
+        out.q.push_back(acc_q);
+    }
+    // keep the last taps - 1 samples
+    size_t drop = hist_i_.size() - history;
+    hist_i_.erase(hist_i_.begin(), hist_i_.begin() + drop);
+    hist_q_.erase(hist_q_.begin(), hist_q_.begin() + drop);
+    next_ -= drop;
+}
+
+// ----- //
+// noise //
+// ----- //
+
+static inline uint32_t rotl(uint32_t x, int k){
+    return (x << k) | (x >> (32 - k));
+}
+
+NoiseGenerator::NoiseGenerator(uint64_t seed){
+    // splitmix64 to seed the state
+    for (int k = 0; k < 2; k++) {
+        uint64_t z = (seed += 0x9E3779B97F4A7C15ull);
+        z = (z ^ (z >> 30))*0xBF58476D1CE4E5B9ull;
+        z = (z ^ (z >> 27))*0x94D049BB133111EBull;
+        z ^= z >> 31;
+        s_[2*k] = (uint32_t) z;
+        s_[2*k + 1] = (uint32_t) (z >> 32);
+    }
+}
+
+uint32_t NoiseGenerator::next(){
+    uint32_t result = s_[0] + s_[3];
+    uint32_t t = s_[1] << 9;
+    s_[2] ^= s_[0];
+    s_[3] ^= s_[1];
+    s_[1] ^= s_[2];
+    s_[0] ^= s_[3];
+    s_[2] ^= t;
+    s_[3] = rotl(s_[3], 11);
+    return result;
+}
+
+void NoiseGenerator::add(float *i, float *q, size_t n, float sigma){
+    u1_.resize(n);
+    u2_.resize(n);
+    for (size_t k = 0; k < n; k++) {
+        u1_[k] = ((next() >> 8) + 1)*(1.0f/16777216.0f);  // (0, 1]
+        u2_[k] = (next() >> 8)*(float) (TWO_PI/16777216.0);
+    }
+    // Box-Muller: both outputs of a pair are used for I and Q
+    for (size_t k = 0; k < n; k++) {
+        float r = sigma*std::sqrt(-2.0f*std::log(u1_[k]));
+        i[k] += r*std::cos(u2_[k]);
+        q[k] += r*std::sin(u2_[k]);
+    }
+}
+
+// ------------ //
+// FSK receiver //
+// ------------ //
+
+static unsigned odd_taps(double taps){
+    unsigned n = (unsigned) std::ceil(taps);
+    return n | 1;
+}
+
+/* decimation of the channel filter: at least 8 samples per symbol and twice the bandwidth */
+static unsigned total_decimation(const FskConfig &c){
+    double min_rate = std::max(2*c.bandwidth, 8*c.baud);
+    return std::max(1u, (unsigned) std::floor(c.sample_rate/min_rate));
+}
+
+static unsigned stage1_decimation(const FskConfig &c){
+    unsigned m = total_decimation(c);
+    return (m >= 4) ? m/2 : 1;
+}
+
+static std::vector<float> stage1_taps(const FskConfig &c){
+    unsigned m = stage1_decimation(c);
+    if (m == 1) {
+        return {1.0f};
+    }
+    // pass-band up to 0.4 of the intermediate rate (well beyond the channel), aliases stay outside the channel
+    return design_lowpass(12*m + 1, 0.4/m);
+}
+
+static std::vector<float> stage2_taps(const FskConfig &c){
+    double rate = c.sample_rate/stage1_decimation(c);
+    // Blackman transition (about 5.5/taps) within a quarter of the bandwidth
+    unsigned taps = std::min(4095u, odd_taps(22*rate/c.bandwidth));
+    return design_lowpass(taps, 0.5*c.bandwidth/rate);
+}
+
+FskReceiver::FskReceiver(const FskConfig &config)
+    : config_(config),
+      nco_(-config.center, config.sample_rate),
+      stage1_(stage1_taps(config), stage1_decimation(config)),
+      stage2_(stage2_taps(config), std::max(1u, total_decimation(config)/stage1_decimation(config))){
+    channel_rate_ = config_.sample_rate/stage1_.decimation()/stage2_.decimation();
+    step_ = channel_rate_/(SAMPLES_PER_SYMBOL*config_.baud);
+    config_.sync_bits = std::min(32u, std::max(8u, config_.sync_bits));
+    sync_mask_ = (config_.sync_bits == 32) ? 0xFFFFFFFFu : ((1u << config_.sync_bits) - 1);
+    sync_ = config_.sync_word & sync_mask_;
+    reset();
+}
+
+void FskReceiver::reset(){
+    nco_.reset();
+    stage1_.reset();
+    stage2_.reset();
+    last_i_ = last_q_ = 0;
+    t_ = 0;
+    prev_freq_ = prev_power_ = 0;
+    n_ = 0;
+    std::fill(std::begin(raw_), std::end(raw_), 0.0f);
+    std::fill(std::begin(mf_), std::end(mf_), 0.0f);
+    std::fill(std::begin(pow_), std::end(pow_), 0.0f);
+    mf_sum_ = dc_sum_ = 0;
+    std::fill(std::begin(regs_), std::end(regs_), 0u);
+    candidate_ = false;
+    receiving_ = false;
+}
+
+void FskReceiver::process(const float *i, const float *q, size_t n, std::vector<DecodedFrame> &frames){
+    // mixer and channel filter
+    block_.i.assign(i, i + n);
+    block_.q.assign(q, q + n);
+    nco_.mix(block_.i.data(), block_.q.data(), n);
+    stage1_out_.clear();
+    stage1_.process(block_.i.data(), block_.q.data(), n, stage1_out_);
+    channel_.clear();
+    stage2_.process(stage1_out_.i.data(), stage1_out_.q.data(), stage1_out_.size(), channel_);
+
+    // discriminator: angle between consecutive samples
+    size_t m = channel_.size();
+    if (m == 0) {
+        return;
+    }
+    freq_.resize(m);
+    power_.resize(m);
+    const float *ci = channel_.i.data(), *cq = channel_.q.data();
+    float scale = (float) (channel_rate_/TWO_PI);
+    freq_[0] = fast_atan2(cq[0]*last_i_ - ci[0]*last_q_, ci[0]*last_i_ + cq[0]*last_q_)*scale;
+    for (size_t k = 1; k < m; k++) {
+        freq_[k] = fast_atan2(cq[k]*ci[k - 1] - ci[k]*cq[k - 1], ci[k]*ci[k - 1] + cq[k]*cq[k - 1])*scale;
+    }
+    for (size_t k = 0; k < m; k++) {
+        power_[k] = ci[k]*ci[k] + cq[k]*cq[k];
+    }
+    last_i_ = ci[m - 1];
+    last_q_ = cq[m - 1];
+
+    // linear interpolation to SAMPLES_PER_SYMBOL (t_: position relative to the previous sample)
+    for (size_t k = 0; k < m; k++) {
+        while (t_ < 1.0) {
+            float f = (float) t_;
+            symbol_stream(prev_freq_ + f*(freq_[k] - prev_freq_), prev_power_ + f*(power_[k] - prev_power_), frames);
+            t_ += step_;
+        }
+        t_ -= 1.0;
+        prev_freq_ = freq_[k];
+        prev_power_ = power_[k];
+    }
+}
+
+/* correlation of the matched filter output with the sync word, ending at n */
+float FskReceiver::eye_metric(uint64_t n) const {
+    float dc = (float) (dc_sum_/(DC_SYMBOLS*SAMPLES_PER_SYMBOL));
+    float sum = 0;
+    for (unsigned k = 0; k < config_.sync_bits; k++) {
+        float v = mf(n - k*SAMPLES_PER_SYMBOL) - dc;
+        sum += ((sync_ >> k) & 1) ? v : -v;
+    }
+    return sum;
+}
+
+void FskReceiver::symbol_stream(float freq, float power, std::vector<DecodedFrame> &frames){
+    const unsigned sps = SAMPLES_PER_SYMBOL;
+    uint64_t n = n_++;
+    unsigned idx = n & (RING - 1);
+    // matched filter (boxcar over one symbol) and running mean (offset compensation while searching)
+    mf_sum_ += freq - raw_[(n - sps) & (RING - 1)];
+    raw_[idx] = freq;
+    pow_[idx] = power;
+    float out = (float) (mf_sum_/sps);
+    dc_sum_ += out - mf_[(n - DC_SYMBOLS*sps) & (RING - 1)];
+    mf_[idx] = out;
+    if ((n & 0xFFFF) == 0) {
+        // limit the accumulated rounding errors of the running sums
+        double a = 0, b = 0;
+        for (unsigned k = 0; k < sps; k++) a += raw_[(n - k) & (RING - 1)];
+        for (unsigned k = 0; k < DC_SYMBOLS*sps; k++) b += mf_[(n - k) & (RING - 1)];
+        mf_sum_ = a;
+        dc_sum_ = b;
+    }
+    if (n < (config_.sync_bits + DC_SYMBOLS)*sps) {
+        return;
+    }
+
+    if (receiving_) {
+        if (n == next_symbol_) {
+            next_symbol_ += sps;
+            receive_bit(out > dc_frame_, frames);
+        }
+        return;
+    }
+
+    // one shift register per sampling phase
+    float dc = (float) (dc_sum_/(DC_SYMBOLS*sps));
+    uint32_t &reg = regs_[n % sps];
+    reg = (reg << 1) | (out > dc ? 1u : 0u);
+    if (!candidate_ && __builtin_popcount((reg ^ sync_) & sync_mask_) <= (int) config_.sync_errors) {
+        candidate_ = true;
+        first_match_ = n;
+        candidate_end_ = n + sps/2;
+    }
+    if (candidate_ && n == candidate_end_) {
+        // best sampling instant within +-half a symbol of the first match
+        uint64_t best = first_match_;
+        float best_metric = -1e30f, metric[sps + 1];
+        for (unsigned k = 0; k <= sps; k++) {
+            metric[k] = eye_metric(first_match_ - sps/2 + k);
+            if (metric[k] > best_metric) {
+                best_metric = metric[k];
+                best = first_match_ - sps/2 + k;
+            }
+        }
+        candidate_ = false;
+        start_frame(best);
+        unsigned b = (unsigned) (best - (first_match_ - sps/2));
+        float timing = 0;
+        if (b > 0 && b < sps) {
+            float l = metric[b - 1], c = metric[b], r = metric[b + 1];
+            float denom = l - 2*c + r;
+            timing = (denom < 0) ? 0.5f*(l - r)/denom : 0.0f;
+        }
+        frame_.timing_error = timing/sps;
+        if (next_symbol_ == n) {
+            next_symbol_ += sps;
+            receive_bit(out > dc_frame_, frames);
+        }
+    }
+}
+
+void FskReceiver::start_frame(uint64_t n){
+    const unsigned sps = SAMPLES_PER_SYMBOL;
+    unsigned bits = config_.sync_bits;
+    // least-squares fit of offset and deviation on the sync word: mf = offset + deviation*(2b - 1)
+    double sum_s = 0, sum_v = 0, sum_sv = 0, sum_vv = 0, sum_p = 0;
+    for (unsigned k = 0; k < bits; k++) {
+        double s = ((sync_ >> k) & 1) ? 1.0 : -1.0;
+        double v = mf(n - k*sps);
+        sum_s += s;
+        sum_v += v;
+        sum_sv += s*v;
+        sum_vv += v*v;
+        for (unsigned j = 0; j < sps; j++) {
+            sum_p += pow_[(n - k*sps - j) & (RING - 1)];
+        }
+    }
+    double det = bits*(double) bits - sum_s*sum_s;
+    double deviation = (bits*sum_sv - sum_s*sum_v)/det;
+    double offset = (sum_v - deviation*sum_s)/bits;
+    // residual: sum (v - offset - deviation*s)^2
+    double sum_ss = bits;
+    double residual = sum_vv + offset*offset*bits + deviation*deviation*sum_ss
+                      - 2*offset*sum_v - 2*deviation*sum_sv + 2*offset*deviation*sum_s;
+    double variance = std::max(residual/bits, 1e-3);
+    double signal = sum_p/(bits*sps);
+    // noise: power before the preamble
+    uint64_t lead = (bits + config_.preamble_bits + 8)*sps;
+    uint64_t noise_end = n - lead;
+    double noise = 0;
+    unsigned noise_len = (n > lead) ? std::min<uint64_t>({NOISE_SYMBOLS*sps, RING - lead - 1, noise_end}) : 0;
+    for (unsigned j = 0; j < noise_len; j++) {
+        noise += pow_[(noise_end - j) & (RING - 1)];
+    }
+    noise = std::max(noise/std::max(1u, noise_len), 1e-20);
+
+    frame_ = DecodedFrame();
+    frame_.sample = (uint64_t) ((n + sps)/(sps*config_.baud)*config_.sample_rate);
+    frame_.power_db = (float) (10*std::log10(std::max(signal, 1e-20)));
+    frame_.snr_db = (float) (10*std::log10(std::max(signal - noise, 1e-20)/noise));
+    frame_.eye_snr_db = (float) (10*std::log10(deviation*deviation/variance));
+    frame_.freq_offset_hz = (float) offset;
+    frame_.deviation_hz = (float) deviation;
+    dc_frame_ = (float) offset;
+    receiving_ = true;
+    std::fill(std::begin(regs_), std::end(regs_), 0u);
+    next_symbol_ = n + sps;
+    byte_ = bits_ = 0;
+    expected_ = config_.fixed_length ? config_.fixed_length + (config_.crc ? CRC_LEN : 0) : 1;
+}
+
+void FskReceiver::receive_bit(bool bit, std::vector<DecodedFrame> &frames){
+    byte_ = (uint8_t) ((byte_ << 1) | bit);
+    if (++bits_ < 8) {
+        return;
+    }
+    frame_.data.push_back(byte_);
+    byte_ = bits_ = 0;
+    if (!config_.fixed_length && frame_.data.size() == 1) {
+        if (frame_.data[0] > config_.max_length) {
+            frame_.overflow = true;
+            frame_.crc_ok = false;
+            frames.push_back(std::move(frame_));
+            receiving_ = false;
+            return;
+        }
+        expected_ = 1 + frame_.data[0] + (config_.crc ? CRC_LEN : 0);
+    }
+    if (frame_.data.size() < expected_) {
+        return;
+    }
+    frame_.overflow = false;
+    if (config_.crc) {
+        size_t len = frame_.data.size() - CRC_LEN;
+        uint16_t crc = crc16_cc2500(frame_.data.data(), (uint8_t) len);
+        frame_.crc_ok = (frame_.data[len] == (crc >> 8)) && (frame_.data[len + 1] == (crc & 0xFF));
+    } else {
+        frame_.crc_ok = true;
+    }
+    frames.push_back(std::move(frame_));
+    receiving_ = false;
+}
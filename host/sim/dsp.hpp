@@ -0,0 +1,168 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * DSP of the host simulator and the IQ demodulator: mixer, decimating channel filter, FM
+ * discriminator and a non-coherent 2-FSK receiver similar to the CC2500 (channel filter bandwidth,
+ * frequency offset compensation on the preamble, sync word detection with bit errors).
+ *
+ * The complex signals are stored as separate I and Q arrays and the inner loops are plain loops
+ * over contiguous floats, such that the compiler vectorizes them (see host/CMakeLists.txt).
+ * All blocks are streaming: a signal can be processed in blocks of any size.
+ *
+ */
+
+#ifndef DSP_HPP
+#define DSP_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+constexpr double TWO_PI = 6.283185307179586;
+
+/* complex signal as structure of arrays */
+struct ComplexBuffer {
+  std::vector<float> i, q;
+  size_t size() const { return i.size(); }
+  void resize(size_t n) { i.resize(n); q.resize(n); }
+  void clear() { i.clear(); q.clear(); }
+};
+
+/* windowed-sinc (Blackman) low-pass with unity DC gain, cutoff relative to the sample rate (0 ... 0.5) */
+std::vector<float> design_lowpass(unsigned taps, double cutoff);
+
+/* atan2 approximation (max. error 1e-5 rad) without branches */
+float fast_atan2(float y, float x);
+
+/* multiply by exp(j 2 pi freq n / sample_rate) */
+class Nco {
+public:
+  Nco(double freq, double sample_rate);
+  void mix(float *i, float *q, size_t n);
+  void reset() { phase_ = 0; }
+
+private:
+  static constexpr size_t BLOCK = 256;
+  double step_;
+  double phase_ = 0;
+  std::vector<float> rot_i_, rot_q_;   // exp(j step k), k < BLOCK
+};
+
+/* FIR low-pass filter with decimation (streaming) */
+class DecimatingFir {
+public:
+  DecimatingFir(const std::vector<float> &taps, unsigned decimation);
+  /* filter n samples, the outputs are appended to out */
+  void process(const float *i, const float *q, size_t n, ComplexBuffer &out);
+  void reset();
+  unsigned decimation() const { return decimation_; }
+
+private:
+  std::vector<float> taps_;            // reversed
+  unsigned decimation_;
+  std::vector<float> hist_i_, hist_q_; // taps - 1 samples of history followed by the current block
+  size_t next_;                        // index of the next output (last input sample of its window)
+};
+
+/* complex Gaussian noise (xoshiro128+ and Box-Muller) */
+class NoiseGenerator {
+public:
+  explicit NoiseGenerator(uint64_t seed);
+  /* add noise with the given variance per real dimension */
+  void add(float *i, float *q, size_t n, float sigma);
+  uint32_t next();
+  float uniform() { return (next() >> 8) * (1.0f/16777216.0f); }
+
+private:
+  uint32_t s_[4];
+  std::vector<float> u1_, u2_;
+};
+
+/* setting of the FSK receiver */
+struct FskConfig {
+  double   sample_rate = 5e6;      // input [Hz]
+  double   center = 0;             // subcarrier center frequency in the input, mixed to 0 [Hz]
+  double   baud = 100000;
+  double   bandwidth = 812500;     // channel filter bandwidth (two-sided) [Hz]
+  uint32_t sync_word = 0xd391d391; // the last sync_bits bits are used (MSB first)
+  unsigned sync_bits = 32;
+  unsigned sync_errors = 2;        // accepted bit errors in the sync word (CC2500: 30/32 or 15/16)
+  unsigned preamble_bits = 32;
+  uint8_t  fixed_length = 0;       // bytes after the sync word in fixed length mode (0: length byte)
+  bool     crc = true;             // CRC-16 of the CC2500 after the payload
+  uint8_t  max_length = 61;        // larger length bytes are reported as overflow
+};
+
+/* received frame */
+struct DecodedFrame {
+  uint64_t sample;             // input sample of the first symbol after the sync word
+  std::vector<uint8_t> data;   // length byte (variable length), payload and CRC as received
+  bool     overflow;           // corrupted length byte (> max_length)
+  bool     crc_ok;
+  float    power_db;           // signal power in the channel [dB] (relative to full scale)
+  float    snr_db;             // channel power during the sync word over the power before the preamble
+  float    eye_snr_db;         // deviation^2 over the variance of the soft symbols of the sync word
+  float    freq_offset_hz;     // frequency offset estimated on the sync word
+  float    deviation_hz;       // deviation estimated on the sync word
+  float    timing_error;       // offset of the eye center from the sampling instant [symbols]
+};
+
+/*
+ * non-coherent 2-FSK receiver: mixer, channel filter (two decimation stages), discriminator,
+ * resampling to SAMPLES_PER_SYMBOL, matched filter and one sync word correlator per sampling phase
+ */
+class FskReceiver {
+public:
+  static constexpr unsigned SAMPLES_PER_SYMBOL = 8;
+
+  explicit FskReceiver(const FskConfig &config);
+  /* process n input samples, decoded frames are appended */
+  void process(const float *i, const float *q, size_t n, std::vector<DecodedFrame> &frames);
+  void reset();
+  double channel_rate() const { return channel_rate_; }
+
+private:
+  static constexpr unsigned RING = 4096;          // history of the symbol-rate stream (power of 2)
+  static constexpr unsigned DC_SYMBOLS = 8;       // window of the offset compensation while searching
+  static constexpr unsigned NOISE_SYMBOLS = 32;   // window of the noise power before the preamble
+
+  void symbol_stream(float freq, float power, std::vector<DecodedFrame> &frames);
+  float eye_metric(uint64_t n) const;
+  void start_frame(uint64_t n);
+  void receive_bit(bool bit, std::vector<DecodedFrame> &frames);
+  float mf(uint64_t n) const { return mf_[n & (RING - 1)]; }
+
+  FskConfig config_;
+  Nco nco_;
+  DecimatingFir stage1_, stage2_;
+  double channel_rate_;
+  ComplexBuffer block_, stage1_out_, channel_;
+  std::vector<float> freq_, power_;
+  float last_i_ = 0, last_q_ = 0;
+
+  // resampler (channel rate -> SAMPLES_PER_SYMBOL * baud)
+  double step_;
+  double t_ = 0;
+  float prev_freq_ = 0, prev_power_ = 0;
+
+  // symbol-rate stream
+  uint64_t n_ = 0;                       // resampled samples
+  float raw_[RING], mf_[RING], pow_[RING];
+  double mf_sum_ = 0, dc_sum_ = 0;
+  uint32_t regs_[SAMPLES_PER_SYMBOL] = {0};
+  uint32_t sync_mask_;
+  uint32_t sync_;
+  bool candidate_ = false;
+  uint64_t candidate_end_ = 0;
+  uint64_t first_match_ = 0;
+
+  // frame
+  bool receiving_ = false;
+  uint64_t next_symbol_ = 0;
+  float dc_frame_ = 0;
+  DecodedFrame frame_;
+  uint8_t byte_ = 0, bits_ = 0;
+  unsigned expected_ = 0;
+};
+
+#endif
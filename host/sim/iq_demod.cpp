@@ -0,0 +1,229 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Streaming demodulator of IQ recordings of the backscatter signal: decodes the frames with the
+ * FSK receiver of the simulator (dsp.hpp) and prints them in the log format of printPacket()
+ * (readable by serial-capture.py, the stats scripts and log_analyzer), each followed by a '#' line
+ * with the SNR, frequency offset, deviation and symbol timing error of the frame.
+ *
+ * The recording (interleaved int16 or float32 I/Q) is memory-mapped and split into chunks, each
+ * chunk is decoded by its own thread. A chunk starts early enough (preamble, sync word and filter
+ * settling) and ends late enough (longest frame) to decode every frame whose sync word ends in it.
+ *
+ * usage: ./iq_demod <recording> --rate 20e6 [--format int16|float32] [--center 3.3e6 | --dividers 40,36 [--tune 0]]
+ *                   [--baud 100000] [--bandwidth 464e3] [--receiver 2500|1352] [--sync 32|16] [--fixed N] [--no-crc]
+ *                   [--rssi-offset 0] [--threads N]
+ *
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "dsp.hpp"
+#include "log_parser.hpp"
+
+extern "C" {
+#include "pico/stdlib.h"
+#include "receiver_CC2500.h"
+#include "packet_generation.h"
+}
+#undef max
+#undef min
+
+#define BLOCK_SAMPLES  (1 << 16)  // samples converted and filtered at once
+#define PIO_CLOCK     125e6
+
+static void usage(const char *name){
+    std::fprintf(stderr, "usage: %s <recording> --rate 20e6 [--format int16|float32] [--center 3.3e6 | --dividers 40,36 [--tune 0]]\n"
+                         "       [--baud 100000] [--bandwidth 464e3] [--receiver 2500|1352] [--sync 32|16] [--fixed N] [--no-crc]\n"
+                         "       [--rssi-offset 0] [--threads N]\n", name);
+}
+
+/* decode the samples [begin, end) of the recording, keep the frames whose sync word ends in [keep_begin, keep_end) */
+static void decode_chunk(const char *data, bool int16, size_t begin, size_t end, size_t keep_begin, size_t keep_end,
+                         const FskConfig &config, std::vector<DecodedFrame> &frames){
+    FskReceiver receiver(config);
+    std::vector<float> i(BLOCK_SAMPLES), q(BLOCK_SAMPLES);
+    std::vector<DecodedFrame> decoded;
+    for (size_t pos = begin; pos < end; pos += BLOCK_SAMPLES) {
+        size_t n = std::min<size_t>(BLOCK_SAMPLES, end - pos);
+        if (int16) {
+            const int16_t *s = reinterpret_cast<const int16_t *>(data) + 2*pos;
+            for (size_t k = 0; k < n; k++) {
+                i[k] = s[2*k]*(1.0f/32768);
+                q[k] = s[2*k + 1]*(1.0f/32768);
+            }
+        } else {
+            const float *s = reinterpret_cast<const float *>(data) + 2*pos;
+            for (size_t k = 0; k < n; k++) {
+                i[k] = s[2*k];
+                q[k] = s[2*k + 1];
+            }
+        }
+        decoded.clear();
+        receiver.process(i.data(), q.data(), n, decoded);
+        for (DecodedFrame &f : decoded) {
+            f.sample += begin;
+            if (f.sample >= keep_begin && f.sample < keep_end) {
+                frames.push_back(std::move(f));
+            }
+        }
+    }
+}
+
+int main(int argc, char **argv){
+    if (argc < 2) {
+        usage(argv[0]);
+        return 1;
+    }
+    std::string path = argv[1];
+    FskConfig config;
+    config.sample_rate = 0;
+    bool int16 = true;
+    bool center_given = false, bandwidth_given = false;
+    unsigned d0 = 0, d1 = 0;
+    double tune = 0;
+    uint16_t receiver_type = 2500;
+    unsigned sync_bits = 32;
+    double rssi_offset = 0;
+    unsigned threads = std::max(1u, std::thread::hardware_concurrency());
+    for (int i = 2; i < argc; i++) {
+        std::string arg = argv[i];
+        bool has_value = i + 1 < argc;
+        if (arg == "--rate" && has_value) {
+            config.sample_rate = std::atof(argv[++i]);
+        } else if (arg == "--format" && has_value) {
+            std::string format = argv[++i];
+            if (format != "int16" && format != "float32") {
+                usage(argv[0]);
+                return 1;
+            }
+            int16 = (format == "int16");
+        } else if (arg == "--center" && has_value) {
+            config.center = std::atof(argv[++i]);
+            center_given = true;
+        } else if (arg == "--dividers" && has_value) {
+            if (std::sscanf(argv[++i], "%u,%u", &d0, &d1) != 2 || d0 == 0 || d1 == 0) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--tune" && has_value) {
+            tune = std::atof(argv[++i]);
+        } else if (arg == "--baud" && has_value) {
+            config.baud = std::atof(argv[++i]);
+        } else if (arg == "--bandwidth" && has_value) {
+            config.bandwidth = std::atof(argv[++i]);
+            bandwidth_given = true;
+        } else if (arg == "--receiver" && has_value) {
+            receiver_type = (uint16_t) std::strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--sync" && has_value) {
+            sync_bits = std::strtoul(argv[++i], nullptr, 0);
+            if (sync_bits != 16 && sync_bits != 32) {
+                usage(argv[0]);
+                return 1;
+            }
+        } else if (arg == "--fixed" && has_value) {
+            config.fixed_length = (uint8_t) std::strtoul(argv[++i], nullptr, 0);
+        } else if (arg == "--no-crc") {
+            config.crc = false;
+        } else if (arg == "--rssi-offset" && has_value) {
+            rssi_offset = std::atof(argv[++i]);
+        } else if (arg == "--threads" && has_value) {
+            threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 0));
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+    if (config.sample_rate <= 0 || (!center_given && d0 == 0)) {
+        std::fprintf(stderr, "the sample rate (--rate) and the subcarrier (--center or --dividers) are required\n");
+        usage(argv[0]);
+        return 1;
+    }
+    if (d0 != 0) {
+        // subcarrier of the tag as computed by backscatter_program_init() (tune: recording center - carrier)
+        double f0 = PIO_CLOCK/d0, f1 = PIO_CLOCK/d1;
+        if (!center_given) {
+            config.center = (f0 + f1)/2 - tune;
+        }
+        if (!bandwidth_given) {
+            config.bandwidth = config.baud + std::fabs(f1 - f0);  // minRxBw: baud + 2 deviation
+        }
+    }
+    if (std::fabs(config.center) + config.bandwidth/2 > config.sample_rate/2) {
+        std::fprintf(stderr, "the channel (center %.0f Hz, bandwidth %.0f Hz) is not within the recording (%.0f Hz)\n",
+                     config.center, config.bandwidth, config.sample_rate);
+        return 1;
+    }
+    // sync word: the last sync_bits of packet_hdr_2500/packet_hdr_1352 (SYNC_MODE 30/32 or 15/16)
+    uint8_t *header_template = packet_hdr_template(receiver_type);
+    config.sync_word = 0;
+    for (uint8_t i = HEADER_LEN - 2 - sync_bits/8; i < HEADER_LEN - 2; i++) {
+        config.sync_word = (config.sync_word << 8) | header_template[i];
+    }
+    config.sync_bits = sync_bits;
+    config.sync_errors = (sync_bits == 32) ? 2 : 1;
+
+    std::unique_ptr<MappedFile> file;
+    try {
+        file.reset(new MappedFile(path));
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    size_t samples = file->size()/(int16 ? 2*sizeof(int16_t) : 2*sizeof(float));
+    auto start = std::chrono::steady_clock::now();
+
+    // chunks: warm-up before (filters, noise window, preamble and sync word) and the longest frame after the chunk
+    double samples_per_symbol = config.sample_rate/config.baud;
+    size_t warmup = (size_t) ((128 + config.sync_bits + config.preamble_bits)*samples_per_symbol) + 16384;
+    size_t longest = (size_t) (8.0*(1 + 255 + CRC_LEN + 1)*samples_per_symbol) + 16384;
+    size_t chunk = std::max<size_t>((samples + threads - 1)/threads, 4*(warmup + longest));
+    size_t chunks = (samples + chunk - 1)/chunk;
+    std::vector<std::vector<DecodedFrame>> frames(chunks);
+    std::vector<std::thread> pool;
+    for (size_t c = 0; c < chunks; c++) {
+        size_t keep_begin = c*chunk, keep_end = std::min(samples, keep_begin + chunk);
+        size_t begin = (keep_begin > warmup) ? keep_begin - warmup : 0;
+        size_t end = std::min(samples, keep_end + longest);
+        pool.emplace_back(decode_chunk, file->data(), int16, begin, end, (c == 0) ? 0 : keep_begin, keep_end,
+                          std::cref(config), std::ref(frames[c]));
+    }
+    for (std::thread &t : pool) t.join();
+
+    // output in the log format (time since the start of the recording)
+    static char buffer[1 << 20];
+    std::setvbuf(stdout, buffer, _IOFBF, sizeof(buffer));
+    size_t total = 0, crc_pass = 0;
+    for (const std::vector<DecodedFrame> &chunk_frames : frames) {
+        for (const DecodedFrame &f : chunk_frames) {
+            Packet_status status{};
+            uint8_t packet[256 + CRC_LEN] = {0};
+            size_t len = f.data.size() - ((config.crc && !f.overflow) ? CRC_LEN : 0);
+            std::memcpy(packet, f.data.data(), std::min(len, sizeof(packet)));
+            status.overflowed = f.overflow;
+            status.len = (uint8_t) len;
+            status.RSSI = (int32_t) std::lround(f.power_db + rssi_offset);
+            status.CRCcheck = f.crc_ok;
+            printPacket(packet, status, (uint64_t) (f.sample/config.sample_rate*1e6));
+            std::printf("# iq snr %.1f dB eye snr %.1f dB offset %.0f Hz deviation %.0f Hz timing %+.3f symbols\n",
+                        f.snr_db, f.eye_snr_db, f.freq_offset_hz, f.deviation_hz, f.timing_error);
+            total++;
+            crc_pass += f.crc_ok;
+        }
+    }
+    std::fflush(stdout);
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double duration = samples/config.sample_rate;
+    std::fprintf(stderr, "%zu frames (%zu CRC pass) in %.3f s of recording, decoded with %u threads in %.3f s (%.2f Msamples/s, %.1fx real-time)\n",
+                 total, crc_pass, duration, (unsigned) chunks, elapsed, samples/elapsed/1e6, duration/elapsed);
+    return 0;
+}
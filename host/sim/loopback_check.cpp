@@ -0,0 +1,161 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host check of the analysis of the on-chip self-test (loopback_analyze() of project_pico_libs/pio_loopback.c):
+ * - the program of backscatter_program_init() sends the test message on the PIO interpreter (pio_sim.hpp),
+ *   PIN_TX1 and PIN_TX2 are sampled as by the sampler state-machines of loopback_selftest() (one sample every
+ *   div cycles, 32 samples per word, first sample in the MSB) and the capture has to pass
+ * - faults are injected into the same capture (a missing period, a wrong symbol length, a wrong antenna phase)
+ *   and have to be reported as MISMATCH
+ * The GPIO output override of PIN_TX2 (PHASE_INVERTED, PHASE_SINGLE) is applied to the interpreted side-set pin.
+ *
+ * usage: ./loopback_check (exit code 1 if a case fails)
+ *
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <vector>
+
+#include "pio_sim.hpp"
+
+extern "C" {
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "backscatter.h"
+#include "pio_loopback.h"
+#include "host_hal.h"
+}
+#undef max
+#undef min
+#undef abs
+
+#define F_PIO ((uint32_t) CLKFREQ*1000000)
+
+/* test message of pio_loopback.c */
+static const uint32_t message[LOOPBACK_MESSAGE_WORDS] = {0xF0F0CCAA, 0x5533FF00};
+
+struct Capture {
+  uint16_t div;
+  uint32_t symbol_cycles;
+  std::vector<uint32_t> pin1, pin2;
+};
+
+/* level of PIN_TX1 (bit 0) and PIN_TX2 (bit 1) of the runs at a cycle (the last level is held) */
+static uint8_t level_at(const std::vector<PinRun> &runs, uint64_t cycle){
+    for (const PinRun &run : runs) {
+        if (cycle < run.cycles) {
+            return run.pins;
+        }
+        cycle -= run.cycles;
+    }
+    return runs.empty() ? 0 : runs.back().pins;
+}
+
+static uint8_t apply_override(uint8_t pins, enum antenna_phase phase){
+    if (phase == PHASE_INVERTED) {
+        return pins ^ 0x02;
+    }
+    return (phase == PHASE_SINGLE) ? (pins & 0x01) : pins;
+}
+
+/* send the message with the program of the tag setting and sample both pins (false: the program does not fit) */
+static bool capture(uint16_t d0, uint16_t d1, uint32_t baud, bool two_antennas, enum antenna_phase phase, Capture &c){
+    static uint16_t instructions[32];
+    struct backscatter_config config;
+    setAntennaPhase(phase);
+    if (!backscatter_program_init(pio0, 0, 6, 27, d0, d1, baud, &config, instructions, two_antennas)) {
+        return false;
+    }
+    uint16_t instr[PIO_INSTRUCTION_COUNT];
+    std::memcpy(instr, pio0->instr_mem, sizeof(instr));
+    uint32_t init[8];
+    size_t n = host_pio_tx_words(pio0, 0, init, 8);
+    PioStateMachine sm(instr, pio0->sm_config[0], (uint8_t) pio0->sm_pc[0]);
+    std::vector<PinRun> runs;
+    for (size_t i = 0; i < n; i++) sm.put(init[i]);
+    sm.run(runs, 1ull << 32);
+    // the samplers start before the message (idle pins, not aligned to the sampling step)
+    runs.clear();
+    runs.push_back({1000 + 37, sm.pins()});
+    for (uint32_t word : message) sm.put(word);
+    sm.run(runs, 1ull << 32);
+
+    // sampling step of loopback_selftest()
+    c.symbol_cycles = F_PIO/config.baudrate;
+    c.div = (uint16_t) std::min<uint32_t>((LOOPBACK_SYMBOLS + 2)*c.symbol_cycles/(32*LOOPBACK_WORDS) + 1, std::max(1, std::min(d0, d1)/4));
+    c.pin1.assign(LOOPBACK_WORDS, 0);
+    c.pin2.assign(LOOPBACK_WORDS, 0);
+    for (uint32_t i = 0; i < 32*LOOPBACK_WORDS; i++) {
+        uint8_t pins = apply_override(level_at(runs, ((uint64_t) i)*c.div), phase);
+        c.pin1[i/32] |= ((uint32_t) (pins & 1)) << (31 - i%32);
+        c.pin2[i/32] |= ((uint32_t) ((pins >> 1) & 1)) << (31 - i%32);
+    }
+    return true;
+}
+
+static bool analyze(const Capture &c, bool two_antennas, uint16_t d0, uint16_t d1, uint32_t symbol_cycles, enum antenna_phase phase){
+    struct loopback_result result;
+    loopback_analyze(c.pin1.data(), two_antennas ? c.pin2.data() : NULL, LOOPBACK_WORDS, c.div, message, LOOPBACK_SYMBOLS,
+                     d0, d1, symbol_cycles, phase, &result);
+    print_loopback(&result);
+    return result.pass;
+}
+
+/* clear the samples of the first high pulse of PIN_TX1 after an eighth of the capture (a missing period) */
+static void drop_period(std::vector<uint32_t> &pin){
+    uint32_t samples = 32*LOOPBACK_WORDS;
+    auto get = [&](uint32_t i) { return (pin[i/32] >> (31 - i%32)) & 1; };
+    uint32_t i = samples/8;
+    while (i < samples && !(get(i) && !get(i - 1))) i++;
+    while (i < samples && get(i)) {
+        pin[i/32] &= ~(1u << (31 - i%32));
+        i++;
+    }
+}
+
+static unsigned failures = 0;
+
+static void expect(bool pass, bool expected, const char *name){
+    std::printf("%s: %s\n", name, (pass == expected) ? "ok" : "FAILED");
+    failures += (pass != expected);
+}
+
+int main(){
+    struct Setting { uint16_t d0, d1; uint32_t baud; };
+    const Setting settings[] = {{20, 18, 100000}, {26, 24, 100000}, {32, 30, 50000}};
+    const enum antenna_phase phases[] = {PHASE_IN_PHASE, PHASE_INVERTED, PHASE_QUARTER, PHASE_SINGLE};
+    char name[128];
+    for (const Setting &s : settings) {
+        Capture c;
+        if (!capture(s.d0, s.d1, s.baud, false, PHASE_IN_PHASE, c)) {
+            std::printf("d0 %u d1 %u baud %u: program does not fit\n", s.d0, s.d1, s.baud);
+            failures++;
+            continue;
+        }
+        std::snprintf(name, sizeof(name), "d0 %u d1 %u baud %u one antenna", s.d0, s.d1, s.baud);
+        expect(analyze(c, false, s.d0, s.d1, c.symbol_cycles, PHASE_IN_PHASE), true, name);
+        for (enum antenna_phase phase : phases) {
+            if (!capture(s.d0, s.d1, s.baud, true, phase, c)) {
+                continue; // e.g. PHASE_QUARTER does not fit: the program falls back to in-phase
+            }
+            std::snprintf(name, sizeof(name), "d0 %u d1 %u baud %u %s", s.d0, s.d1, s.baud, antennaPhaseName(getAntennaPhase()));
+            expect(analyze(c, true, s.d0, s.d1, c.symbol_cycles, getAntennaPhase()), true, name);
+        }
+
+        // faults
+        capture(s.d0, s.d1, s.baud, true, PHASE_IN_PHASE, c);
+        Capture missing = c;
+        drop_period(missing.pin1);
+        std::snprintf(name, sizeof(name), "d0 %u d1 %u baud %u missing period", s.d0, s.d1, s.baud);
+        expect(analyze(missing, true, s.d0, s.d1, c.symbol_cycles, PHASE_IN_PHASE), false, name);
+        std::snprintf(name, sizeof(name), "d0 %u d1 %u baud %u symbol length +1%%", s.d0, s.d1, s.baud);
+        expect(analyze(c, true, s.d0, s.d1, c.symbol_cycles + c.symbol_cycles/100, PHASE_IN_PHASE), false, name);
+        std::snprintf(name, sizeof(name), "d0 %u d1 %u baud %u wrong antenna phase", s.d0, s.d1, s.baud);
+        expect(analyze(c, true, s.d0, s.d1, c.symbol_cycles, PHASE_INVERTED), false, name);
+    }
+    setAntennaPhase(PHASE_IN_PHASE);
+    std::printf("%u failures\n", failures);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,147 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * PIO state-machine interpreter (see pio_sim.hpp).
+ *
+ */
+
+#include "pio_sim.hpp"
+
+#include <cstring>
+#include <stdexcept>
+
+PioStateMachine::PioStateMachine(const uint16_t *instr_mem, const pio_sm_config &config, uint8_t initial_pc)
+    : config_(config), pc_(initial_pc){
+    std::memcpy(instr_, instr_mem, sizeof(instr_));
+}
+
+bool PioStateMachine::out(uint8_t bits, uint32_t &value){
+    uint8_t threshold = config_.pull_threshold ? config_.pull_threshold : 32;
+    if (osr_count_ >= threshold) {
+        // autopull (a manual PULL is not used by the backscatter program)
+        if (fifo_.empty()) {
+            return false;
+        }
+        osr_ = fifo_.front();
+        fifo_.pop_front();
+        osr_count_ = 0;
+    }
+    if (bits == 32) {
+        value = osr_;
+        osr_ = 0;
+    } else if (config_.out_shift_right) {
+        value = osr_ & ((1u << bits) - 1);
+        osr_ >>= bits;
+    } else {
+        value = osr_ >> (32 - bits);
+        osr_ <<= bits;
+    }
+    osr_count_ = (uint8_t) (osr_count_ + bits);
+    return true;
+}
+
+void PioStateMachine::emit(std::vector<PinRun> &runs, uint32_t cycles){
+    if (!runs.empty() && runs.back().pins == pins_) {
+        runs.back().cycles += cycles;
+    } else {
+        runs.push_back({cycles, pins_});
+    }
+}
+
+uint64_t PioStateMachine::run(std::vector<PinRun> &runs, uint64_t max_cycles){
+    uint8_t sideset_bits = config_.sideset_bits;
+    uint8_t delay_bits = 5 - sideset_bits;
+    uint64_t cycles = 0;
+    while (cycles < max_cycles) {
+        uint16_t instr = instr_[pc_ & 0x1F];
+        uint8_t field = (instr >> 8) & 0x1F;
+        uint8_t delay = field & ((1u << delay_bits) - 1);
+        // side-set is applied at the start of the instruction (also when it stalls)
+        if (sideset_bits > 0) {
+            uint8_t side = field >> delay_bits;
+            bool enabled = true;
+            if (config_.sideset_optional) {
+                enabled = side >> (sideset_bits - 1);
+                side &= (1u << (sideset_bits - 1)) - 1;
+            }
+            if (enabled) {
+                pins_ = (uint8_t) ((pins_ & 0x01) | ((side & 1) << 1));
+            }
+        }
+        uint8_t opcode = instr >> 13;
+        uint8_t arg1 = (instr >> 5) & 0x07;
+        uint8_t arg2 = instr & 0x1F;
+        bool jumped = false;
+        switch (opcode) {
+            case 0: { // JMP
+                bool take;
+                switch (arg1) {
+                    case 0: take = true; break;
+                    case 1: take = (x_ == 0); break;
+                    case 2: take = (x_ != 0); x_--; break;
+                    case 3: take = (y_ == 0); break;
+                    case 4: take = (y_ != 0); y_--; break;
+                    case 5: take = (x_ != y_); break;
+                    default: throw std::runtime_error("pio_sim: unsupported JMP condition");
+                }
+                if (take) {
+                    pc_ = arg2;
+                    jumped = true;
+                }
+            }
+            break;
+            case 3: { // OUT
+                uint32_t value;
+                uint8_t bits = arg2 ? arg2 : 32;
+                if (!out(bits, value)) {
+                    return cycles; // stalled on the empty FIFO: the message has been sent
+                }
+                switch (arg1) {
+                    case 1: x_ = value; break;
+                    case 2: y_ = value; break;
+                    case 3: break;
+                    case 6: isr_ = value; break;
+                    default: throw std::runtime_error("pio_sim: unsupported OUT destination");
+                }
+            }
+            break;
+            case 5: { // MOV
+                uint8_t src = instr & 0x07;
+                uint8_t op = (instr >> 3) & 0x03;
+                uint32_t value;
+                switch (src) {
+                    case 1: value = x_; break;
+                    case 2: value = y_; break;
+                    case 3: value = 0; break;
+                    case 6: value = isr_; break;
+                    case 7: value = osr_; break;
+                    default: throw std::runtime_error("pio_sim: unsupported MOV source");
+                }
+                if (op == 1) value = ~value;
+                switch (arg1) {
+                    case 1: x_ = value; break;
+                    case 2: y_ = value; break;
+                    case 6: isr_ = value; break;
+                    default: throw std::runtime_error("pio_sim: unsupported MOV destination");
+                }
+            }
+            break;
+            case 7: // SET
+                switch (arg1) {
+                    case 0: pins_ = (uint8_t) ((pins_ & 0x02) | (arg2 & 0x01)); break;
+                    case 1: x_ = arg2; break;
+                    case 2: y_ = arg2; break;
+                    default: throw std::runtime_error("pio_sim: unsupported SET destination");
+                }
+            break;
+            default:
+                throw std::runtime_error("pio_sim: unsupported instruction");
+        }
+        emit(runs, 1u + delay);
+        cycles += 1u + delay;
+        if (!jumped) {
+            pc_ = (pc_ == config_.wrap) ? config_.wrap_target : (uint8_t) ((pc_ + 1) & 0x1F);
+        }
+    }
+    return cycles;
+}
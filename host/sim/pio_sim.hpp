@@ -0,0 +1,53 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Cycle-accurate interpreter of one PIO state-machine (the subset used by backscatter.c):
+ * JMP (always, !x, x--), OUT (x, y, isr, null) with autopull, MOV (x, y, isr), SET (pins, x, y),
+ * delays, optional side-set and wrap.
+ *
+ * The program and configuration are taken from the host stand-in of the PIO (pio0/pio1 after
+ * backscatter_program_init()), the TX FIFO words from host_pio_tx_words(). The output is the
+ * level of the SET pin and the side-set pin over time (run-length encoded, 1 cycle = 8 ns at 125 MHz).
+ *
+ */
+
+#ifndef PIO_SIM_HPP
+#define PIO_SIM_HPP
+
+#include <cstdint>
+#include <deque>
+#include <vector>
+
+extern "C" {
+#include "hardware/pio.h"
+}
+
+/* pins: bit 0 SET pin (antenna 1), bit 1 side-set pin (antenna 2) */
+struct PinRun {
+  uint32_t cycles;
+  uint8_t  pins;
+};
+
+class PioStateMachine {
+public:
+  PioStateMachine(const uint16_t *instr_mem, const pio_sm_config &config, uint8_t initial_pc);
+  void put(uint32_t word) { fifo_.push_back(word); }
+  /* execute until the state-machine stalls on the empty TX FIFO (or max_cycles), returns the executed cycles */
+  uint64_t run(std::vector<PinRun> &runs, uint64_t max_cycles);
+  uint8_t pins() const { return pins_; }
+
+private:
+  bool out(uint8_t bits, uint32_t &value);  // false: stalled
+  void emit(std::vector<PinRun> &runs, uint32_t cycles);
+
+  uint16_t instr_[PIO_INSTRUCTION_COUNT];
+  pio_sm_config config_;
+  std::deque<uint32_t> fifo_;
+  uint8_t  pc_;
+  uint32_t x_ = 0, y_ = 0, isr_ = 0;
+  uint32_t osr_ = 0;
+  uint8_t  osr_count_ = 32;  // shifted bits (32: empty)
+  uint8_t  pins_ = 0;
+};
+
+#endif
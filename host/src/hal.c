@@ -0,0 +1,448 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Host (Linux) stand-ins for the Pico SDK (see host/README.md and host_hal.h).
+ *
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include "pico/stdlib.h"
+#include "pico/util/queue.h"
+#include "hardware/gpio.h"
+#include "hardware/spi.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "hardware/flash.h"
+#include "host_hal.h"
+
+/* time: monotonic clock + slept time */
+static uint64_t slept_us = 0;
+
+uint64_t time_us_64(void){
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t) ts.tv_sec)*1000000 + ts.tv_nsec/1000 + slept_us;
+}
+
+void sleep_us(uint64_t us){
+    slept_us += us;
+}
+
+void sleep_ms(uint32_t ms){
+    slept_us += 1000ull*ms;
+}
+
+void busy_wait_us(uint64_t us){
+    slept_us += us;
+}
+
+void sleep_until(absolute_time_t t){
+    uint64_t now = time_us_64();
+    if (t > now) {
+        slept_us += t - now;
+    }
+}
+
+uint64_t host_slept_us(void){
+    return slept_us;
+}
+
+alarm_id_t add_alarm_in_us(uint64_t us, alarm_callback_t callback, void *user_data, bool fire_if_past){
+    (void) us; (void) callback; (void) user_data; (void) fire_if_past;
+    return 1;
+}
+
+bool cancel_alarm(alarm_id_t alarm_id){
+    (void) alarm_id;
+    return true;
+}
+
+bool add_repeating_timer_us(int64_t delay_us, repeating_timer_callback_t callback, void *user_data, repeating_timer_t *out){
+    out->delay_us  = delay_us;
+    out->alarm_id  = 1;
+    out->callback  = callback;
+    out->user_data = user_data;
+    return true;
+}
+
+bool cancel_repeating_timer(repeating_timer_t *timer){
+    timer->alarm_id = 0;
+    return true;
+}
+
+int getchar_timeout_us(uint32_t timeout_us){
+    sleep_us(timeout_us);
+    return PICO_ERROR_TIMEOUT;
+}
+
+/* GPIO */
+static bool gpio_level[NUM_BANK0_GPIOS];
+static uint32_t gpio_irq_events[NUM_BANK0_GPIOS];
+static gpio_irq_callback_t gpio_callback = NULL;
+
+void gpio_init(unsigned int gpio){
+    gpio_level[gpio % NUM_BANK0_GPIOS] = false;
+}
+
+void gpio_set_dir(unsigned int gpio, bool out){
+    (void) gpio; (void) out;
+}
+
+static void spi_select(unsigned int csn, bool selected);
+
+void gpio_put(unsigned int gpio, bool value){
+    gpio = gpio % NUM_BANK0_GPIOS;
+    if (gpio_level[gpio] != value) {
+        spi_select(gpio, !value); // chip selects are active low
+    }
+    gpio_level[gpio] = value;
+}
+
+bool gpio_get(unsigned int gpio){
+    return gpio_level[gpio % NUM_BANK0_GPIOS];
+}
+
+void gpio_set_function(unsigned int gpio, enum gpio_function fn){
+    (void) gpio; (void) fn;
+}
+
+void gpio_pull_up(unsigned int gpio){
+    (void) gpio;
+}
+
+void gpio_set_outover(unsigned int gpio, unsigned int value){
+    (void) gpio; (void) value;
+}
+
+void gpio_set_irq_enabled(unsigned int gpio, uint32_t events, bool enabled){
+    gpio = gpio % NUM_BANK0_GPIOS;
+    gpio_irq_events[gpio] = enabled ? (gpio_irq_events[gpio] | events) : (gpio_irq_events[gpio] & ~events);
+}
+
+void gpio_set_irq_enabled_with_callback(unsigned int gpio, uint32_t events, bool enabled, gpio_irq_callback_t callback){
+    gpio_set_irq_enabled(gpio, events, enabled);
+    gpio_callback = callback;
+}
+
+void host_gpio_irq(unsigned int gpio, uint32_t events){
+    events &= gpio_irq_events[gpio % NUM_BANK0_GPIOS];
+    if (gpio_callback != NULL && events != 0) {
+        gpio_callback(gpio, events);
+    }
+}
+
+/* SPI: CC2500 register model per chip select */
+#define CC2500_MARCSTATE_IDLE 0x01
+#define CC2500_MARCSTATE_RX   0x0D
+#define CC2500_MARCSTATE_TX   0x13
+
+struct cc2500_model {
+  uint8_t regs[0x30];
+  uint8_t marcstate;
+  bool    header;        // the next byte is a header byte
+  bool    read;
+  bool    burst;
+  uint8_t address;
+};
+
+static struct spi_inst { int unused; } spi0_hw;
+spi_inst_t *spi0_inst = &spi0_hw;
+static struct cc2500_model cc2500[NUM_BANK0_GPIOS];
+static int spi_selected = -1;
+static uint8_t cc2500_rssi = 196; // -100 dBm
+static uint64_t spi_bytes = 0;
+
+static void cc2500_strobe(struct cc2500_model *chip, uint8_t strobe){
+    switch (strobe) {
+        case 0x30: // SRES
+            memset(chip->regs, 0, sizeof(chip->regs));
+            chip->marcstate = CC2500_MARCSTATE_IDLE;
+            break;
+        case 0x34: // SRX
+            chip->marcstate = CC2500_MARCSTATE_RX;
+            break;
+        case 0x35: // STX
+            chip->marcstate = CC2500_MARCSTATE_TX;
+            break;
+        case 0x36: // SIDLE
+            chip->marcstate = CC2500_MARCSTATE_IDLE;
+            break;
+    }
+}
+
+static uint8_t cc2500_status_register(struct cc2500_model *chip, uint8_t address){
+    switch (address) {
+        case 0x30: return 0x80;            // PARTNUM
+        case 0x31: return 0x03;            // VERSION
+        case 0x34: return cc2500_rssi;     // RSSI
+        case 0x35: return chip->marcstate; // MARCSTATE
+        default:   return 0x00;            // e.g. RXBYTES: empty RX FIFO
+    }
+}
+
+static uint8_t cc2500_exchange(struct cc2500_model *chip, uint8_t tx){
+    uint8_t state = (chip->marcstate == CC2500_MARCSTATE_RX) ? 1 : (chip->marcstate == CC2500_MARCSTATE_TX) ? 2 : 0;
+    if (chip->header) {
+        chip->address = tx & 0x3F;
+        chip->read    = tx & 0x80;
+        chip->burst   = tx & 0x40;
+        // command strobe: header only (status registers are accessed with the burst bit)
+        if (chip->address >= 0x30 && chip->address <= 0x3D && !(chip->read && chip->burst)) {
+            cc2500_strobe(chip, chip->address);
+        } else {
+            chip->header = false;
+        }
+        return state << 4; // chip status byte
+    }
+    uint8_t rx = 0;
+    if (chip->address >= 0x30 && chip->address <= 0x3D) {
+        rx = cc2500_status_register(chip, chip->address);
+        chip->header = true;
+        return rx;
+    }
+    if (chip->address < 0x30) {
+        if (chip->read) {
+            rx = chip->regs[chip->address];
+        } else {
+            chip->regs[chip->address] = tx;
+        }
+    }
+    if (chip->burst) {
+        chip->address = (chip->address < 0x2F) ? chip->address + 1 : chip->address; // PATABLE and FIFO keep their address
+    } else {
+        chip->header = true;
+    }
+    return rx;
+}
+
+static void spi_select(unsigned int csn, bool selected){
+    if (selected) {
+        spi_selected = csn;
+        cc2500[csn].header = true;
+        if (cc2500[csn].marcstate == 0) {
+            cc2500[csn].marcstate = CC2500_MARCSTATE_IDLE;
+        }
+    } else if (spi_selected == (int) csn) {
+        spi_selected = -1;
+    }
+}
+
+static uint8_t spi_exchange(uint8_t tx){
+    spi_bytes++;
+    if (spi_selected < 0) {
+        return 0xFF;
+    }
+    return cc2500_exchange(&cc2500[spi_selected], tx);
+}
+
+unsigned int spi_init(spi_inst_t *spi, unsigned int baudrate){
+    (void) spi;
+    return baudrate;
+}
+
+int spi_write_blocking(spi_inst_t *spi, const uint8_t *src, size_t len){
+    (void) spi;
+    for (size_t i = 0; i < len; i++) {
+        spi_exchange(src[i]);
+    }
+    return (int) len;
+}
+
+int spi_read_blocking(spi_inst_t *spi, uint8_t repeated_tx_data, uint8_t *dst, size_t len){
+    (void) spi;
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = spi_exchange(repeated_tx_data);
+    }
+    return (int) len;
+}
+
+uint8_t host_cc2500_register(unsigned int csn, uint8_t address){
+    return cc2500[csn % NUM_BANK0_GPIOS].regs[address % 0x30];
+}
+
+uint8_t host_cc2500_marcstate(unsigned int csn){
+    return cc2500[csn % NUM_BANK0_GPIOS].marcstate;
+}
+
+void host_cc2500_set_rssi(uint8_t rssi_dec){
+    cc2500_rssi = rssi_dec;
+}
+
+uint64_t host_spi_bytes(void){
+    return spi_bytes;
+}
+
+/* queue */
+void queue_init(queue_t *q, unsigned int element_size, unsigned int element_count){
+    q->data = calloc(element_count + 1, element_size);
+    q->wptr = 0;
+    q->rptr = 0;
+    q->element_size  = element_size;
+    q->element_count = element_count;
+}
+
+void queue_free(queue_t *q){
+    free(q->data);
+    q->data = NULL;
+}
+
+unsigned int queue_get_level(queue_t *q){
+    return (q->wptr + q->element_count + 1 - q->rptr) % (q->element_count + 1);
+}
+
+bool queue_try_add(queue_t *q, const void *data){
+    if (queue_get_level(q) == q->element_count) {
+        return false;
+    }
+    memcpy(q->data + q->wptr*q->element_size, data, q->element_size);
+    q->wptr = (q->wptr + 1) % (q->element_count + 1);
+    return true;
+}
+
+bool queue_try_peek(queue_t *q, void *data){
+    if (queue_get_level(q) == 0) {
+        return false;
+    }
+    memcpy(data, q->data + q->rptr*q->element_size, q->element_size);
+    return true;
+}
+
+bool queue_try_remove(queue_t *q, void *data){
+    if (!queue_try_peek(q, data)) {
+        return false;
+    }
+    q->rptr = (q->rptr + 1) % (q->element_count + 1);
+    return true;
+}
+
+/* PIO: instruction memory and state-machine configurations */
+pio_hw_t pio0_hw_inst, pio1_hw_inst;
+
+bool pio_can_add_program_at_offset(PIO pio, const pio_program_t *program, unsigned int offset){
+    if (offset + program->length > PIO_INSTRUCTION_COUNT) {
+        return false;
+    }
+    uint32_t mask = ((program->length < 32) ? ((1u << program->length) - 1) : 0xFFFFFFFF) << offset;
+    return (pio->used_instruction_space & mask) == 0;
+}
+
+void pio_add_program_at_offset(PIO pio, const pio_program_t *program, unsigned int offset){
+    if (!pio_can_add_program_at_offset(pio, program, offset)) {
+        fprintf(stderr, "pio_add_program_at_offset: no program space\n");
+        abort();
+    }
+    for (uint8_t i = 0; i < program->length; i++) {
+        pio->instr_mem[offset + i] = program->instructions[i];
+        pio->used_instruction_space |= 1u << (offset + i);
+    }
+}
+
+void pio_clear_instruction_memory(PIO pio){
+    memset(pio->instr_mem, 0, sizeof(pio->instr_mem));
+    pio->used_instruction_space = 0;
+}
+
+void pio_gpio_init(PIO pio, unsigned int pin){
+    gpio_set_function(pin, (pio == pio0) ? GPIO_FUNC_PIO0 : GPIO_FUNC_PIO1);
+}
+
+int pio_sm_set_consecutive_pindirs(PIO pio, unsigned int sm, unsigned int pin_base, unsigned int pin_count, bool is_out){
+    (void) pio; (void) sm; (void) pin_base; (void) pin_count; (void) is_out;
+    return 0;
+}
+
+void pio_sm_init(PIO pio, unsigned int sm, unsigned int initial_pc, const pio_sm_config *config){
+    pio->sm_config[sm] = *config;
+    pio->sm_pc[sm] = initial_pc;
+    pio->tx_words[sm] = 0;
+}
+
+void pio_sm_set_enabled(PIO pio, unsigned int sm, bool enabled){
+    pio->ctrl = enabled ? (pio->ctrl | (1u << sm)) : (pio->ctrl & ~(1u << sm));
+}
+
+void pio_enable_sm_mask_in_sync(PIO pio, uint32_t mask){
+    pio->ctrl |= mask & ((1u << NUM_PIO_STATE_MACHINES) - 1);
+}
+
+/* words put into the TX FIFO since the last host_pio_tx_words() (the first HOST_PIO_CAPTURE words are kept) */
+#define HOST_PIO_CAPTURE 64
+static uint32_t pio_capture[2][NUM_PIO_STATE_MACHINES][HOST_PIO_CAPTURE];
+static size_t pio_captured[2][NUM_PIO_STATE_MACHINES];
+
+size_t host_pio_tx_words(PIO pio, unsigned int sm, uint32_t *words, size_t max_words){
+    size_t n = (pio_captured[pio == pio1][sm] < max_words) ? pio_captured[pio == pio1][sm] : max_words;
+    memcpy(words, pio_capture[pio == pio1][sm], n*sizeof(uint32_t));
+    pio_captured[pio == pio1][sm] = 0;
+    return n;
+}
+
+void pio_sm_put_blocking(PIO pio, unsigned int sm, uint32_t data){
+    if (pio_captured[pio == pio1][sm] < HOST_PIO_CAPTURE) {
+        pio_capture[pio == pio1][sm][pio_captured[pio == pio1][sm]++] = data;
+    }
+    pio->tx_words[sm]++;
+    // the message is sent instantly: the state-machine stalls on the empty FIFO
+    pio->fdebug |= 1u << (PIO_FDEBUG_TXSTALL_LSB + sm);
+}
+
+/* DMA: a triggered transfer completes at once */
+static uint16_t dma_claimed = 0;
+
+int dma_claim_unused_channel(bool required){
+    for (int channel = 0; channel < NUM_DMA_CHANNELS; channel++) {
+        if (!(dma_claimed & (1u << channel))) {
+            dma_claimed |= 1u << channel;
+            return channel;
+        }
+    }
+    if (required) {
+        fprintf(stderr, "dma_claim_unused_channel: no free channel\n");
+        abort();
+    }
+    return -1;
+}
+
+void dma_channel_unclaim(unsigned int channel){
+    dma_claimed &= ~(1u << channel);
+}
+
+dma_channel_config dma_channel_get_default_config(unsigned int channel){
+    dma_channel_config c = {.size = DMA_SIZE_32, .read_increment = true, .write_increment = false, .dreq = 0x3f};
+    (void) channel;
+    return c;
+}
+
+void dma_channel_configure(unsigned int channel, const dma_channel_config *config, volatile void *write_addr, const volatile void *read_addr, unsigned int transfer_count, bool trigger){
+    (void) channel;
+    if (!trigger) {
+        return;
+    }
+    unsigned int size = 1u << config->size;
+    volatile uint8_t *write = (volatile uint8_t *) write_addr;
+    const volatile uint8_t *read = (const volatile uint8_t *) read_addr;
+    for (unsigned int i = 0; i < transfer_count; i++) {
+        for (unsigned int b = 0; b < size; b++) {
+            write[b] = read[b];
+        }
+        write += config->write_increment ? size : 0;
+        read  += config->read_increment ? size : 0;
+    }
+}
+
+/* flash: array read through XIP_BASE */
+
+uint8_t host_flash[PICO_FLASH_SIZE_BYTES];
+
+void flash_range_erase(uint32_t flash_offs, size_t count){
+    memset(&host_flash[flash_offs], 0xFF, count);
+}
+
+void flash_range_program(uint32_t flash_offs, const uint8_t *data, size_t count){
+    for (size_t i = 0; i < count; i++) {
+        host_flash[flash_offs + i] &= data[i];
+    }
+}
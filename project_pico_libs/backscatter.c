@@ -6,6 +6,12 @@
  */
 
 #include "backscatter.h"
+#include "lib_output.h"
+
+static enum antenna_phase antenna_phase = PHASE_IN_PHASE;
+static bool loaded_two_antennas = false;
+static bool loaded_quarter = false;   // the loaded program shifts PIN_TX2 by a quarter period
+static struct backscatter_image loaded_image; // program, loop counts and settings of the state-machine
 
 // repeat the instruction until the desired delay has past
 int16_t repeat(uint16_t* instructionBuffer, int16_t delay, uint32_t asm_instr, uint8_t *length, uint16_t max_delay){
@@ -15,6 +21,7 @@ int16_t repeat(uint16_t* instructionBuffer, int16_t delay, uint32_t asm_instr, u
         delay = delay - (delay_part + 1);
         (*length)++;
     }
+    return delay;
 }
 
 // how many instructions are needed to create this delay?
@@ -26,6 +33,49 @@ uint8_t instructionCount(uint16_t delay, uint16_t max_delay){
     }
 }
 
+// instructions of a half period whose side-set changes after split cycles (quarter phase)
+static uint8_t halfCount(uint16_t delay, uint16_t split, uint16_t max_delay){
+    split = min(split, delay);
+    return instructionCount(split, max_delay) + instructionCount(delay - split, max_delay);
+}
+
+// half period with the pins at value: side-set side_first for split cycles, then side_second
+static void half(uint16_t* instructionBuffer, uint16_t delay, uint16_t value, uint16_t split, uint16_t side_first, uint16_t side_second, uint8_t *length, uint16_t max_delay){
+    split = min(split, delay);
+    repeat(instructionBuffer, split,         ASM_SET_PINS | side_first  | value, length, max_delay);
+    repeat(instructionBuffer, delay - split, ASM_SET_PINS | side_second | value, length, max_delay);
+}
+
+// number of instructions of the program generated by generatePIOprogram()
+uint8_t programLength(uint16_t d0, uint16_t d1, uint32_t baud, bool twoAntennas){
+    uint16_t MAX_ASMDELAY = twoAntennas ? 0x0008 : 0x0020; // 8 : 32
+    bool quarter = twoAntennas && antenna_phase == PHASE_QUARTER;
+    uint16_t q1 = quarter ? d1/4 : 0;
+    uint16_t q0 = quarter ? d0/4 : 0;
+    int16_t lastPeriodCycles1 = (((uint32_t) CLKFREQ*1000000)/baud - 4) % ((uint32_t) d1);
+    int16_t lastPeriodCycles0 = (((uint32_t) CLKFREQ*1000000)/baud - 4) % ((uint32_t) d0);
+    int16_t tmp1 = min(lastPeriodCycles1, d1/2);
+    int16_t tmp0 = min(lastPeriodCycles0, d0/2);
+    // header (6), symbol 1: full periods (pull high, pull low, jmp), remaining period (high, low, jmp)
+    uint8_t symbol1 = 6 + halfCount(d1/2, q1, MAX_ASMDELAY) + halfCount(d1/2 - 1, q1, MAX_ASMDELAY) + 1 + halfCount(tmp1, q1, MAX_ASMDELAY) + halfCount(max(0,lastPeriodCycles1-tmp1), q1, MAX_ASMDELAY) + 1;
+    // symbol 0: mov, full periods (pull high, pull low, jmp), remaining period (high, low, jmp)
+    return symbol1 + 1 + halfCount(d0/2, q0, MAX_ASMDELAY) + halfCount(d0/2 - 1, q0, MAX_ASMDELAY) + 1 + halfCount(tmp0, q0, MAX_ASMDELAY) + halfCount(max(0,lastPeriodCycles0-tmp0), q0, MAX_ASMDELAY) + 1;
+}
+
+void setAntennaPhase(enum antenna_phase phase){
+    antenna_phase = phase;
+}
+
+enum antenna_phase getAntennaPhase(void){
+    // the quarter phase falls back to in-phase if its program does not fit
+    return (antenna_phase == PHASE_QUARTER && loaded_two_antennas && !loaded_quarter) ? PHASE_IN_PHASE : antenna_phase;
+}
+
+const char *antennaPhaseName(enum antenna_phase phase){
+    static const char *names[ANTENNA_PHASES] = {"in-phase", "inverted", "quarter", "single"};
+    return (phase < ANTENNA_PHASES) ? names[phase] : "unknown";
+}
+
 bool generatePIOprogram(uint16_t d0,uint16_t d1, uint32_t baud, uint16_t* instructionBuffer, struct pio_program *backscatter_program, bool twoAntennas){
     // compute label positions
     uint16_t MAX_ASMDELAY = 0x0020; // 32
@@ -36,6 +86,12 @@ bool generatePIOprogram(uint16_t d0,uint16_t d1, uint32_t baud, uint16_t* instru
         OPT_SIDE_1   = 0x1800;
         OPT_SIDE_0   = 0x1000;
     }
+    // quarter phase: the side-set follows the pins a quarter period later (changes within each half period)
+    bool quarter = twoAntennas && antenna_phase == PHASE_QUARTER;
+    uint16_t q1 = quarter ? d1/4 : 0;
+    uint16_t q0 = quarter ? d0/4 : 0;
+    uint16_t SIDE_HIGH_FIRST = quarter ? OPT_SIDE_0 : OPT_SIDE_1; // side-set at the start of the high half period
+    uint16_t SIDE_LOW_FIRST  = quarter ? OPT_SIDE_1 : OPT_SIDE_0; // side-set at the start of the low half period
     uint8_t get_symbol_label = 3;
     uint8_t send_1_label = 5;
     uint8_t loop_1_label = send_1_label + 1;
@@ -44,13 +100,12 @@ bool generatePIOprogram(uint16_t d0,uint16_t d1, uint32_t baud, uint16_t* instru
     int16_t tmp1 = min(lastPeriodCycles1, d1/2);
     int16_t tmp0 = min(lastPeriodCycles0, d0/2);
     /*                                           pull high                 pull low            jmp                 high                                      low                            jmp  */
-    uint8_t send_0_label = loop_1_label + instructionCount(d1/2, MAX_ASMDELAY) + instructionCount(d1/2 - 1, MAX_ASMDELAY) + 1 + instructionCount(tmp1, MAX_ASMDELAY) + instructionCount(max(0,lastPeriodCycles1-tmp1), MAX_ASMDELAY) + 1;
+    uint8_t send_0_label = loop_1_label + halfCount(d1/2, q1, MAX_ASMDELAY) + halfCount(d1/2 - 1, q1, MAX_ASMDELAY) + 1 + halfCount(tmp1, q1, MAX_ASMDELAY) + halfCount(max(0,lastPeriodCycles1-tmp1), q1, MAX_ASMDELAY) + 1;
     uint8_t loop_0_label = send_0_label + 1;
 
     // check that the program will fit into memory
-    /*                      pull high                pull low            jmp                        high                              low                               jmp  */
-    if(loop_0_label + instructionCount(d0/2, MAX_ASMDELAY) + instructionCount(d0/2 - 1, MAX_ASMDELAY) + 1 + instructionCount(tmp0, MAX_ASMDELAY) + instructionCount(max(0,lastPeriodCycles0-tmp0), MAX_ASMDELAY) + 1 >= 32){
-        printf("ERROR: The clock dividers are too small. The program would not fit into the state-machine instruction memory. Alternatively, you can disable the second antenna. This increaes the maximal delay per instruction from 8 to 32 cycles and thus significanlty reduces the required code space.");
+    if(programLength(d0, d1, baud, twoAntennas) >= 32){
+        lib_printf("ERROR: The clock dividers are too small. The program would not fit into the state-machine instruction memory. Alternatively, you can disable the second antenna. This increaes the maximal delay per instruction from 8 to 32 cycles and thus significanlty reduces the required code space.");
         return false;
     }
 
@@ -64,26 +119,26 @@ bool generatePIOprogram(uint16_t d0,uint16_t d1, uint32_t baud, uint16_t* instru
     instructionBuffer[5] = ASM_MOV | (ASM_X_REG << 5) | ASM_Y_REG;  //  5: mov    x, y                  
     uint8_t length = 6;
     // full periods
-    repeat(instructionBuffer, d1/2,     ASM_SET_PINS | OPT_SIDE_1 | 1, &length, MAX_ASMDELAY);   //    6: set    pins, 1         side 1 [delay] 
-    repeat(instructionBuffer, d1/2 - 1, ASM_SET_PINS | OPT_SIDE_0 | 0, &length, MAX_ASMDELAY);   //  ...: set    pins, 0         side 0 [delay] 
+    half(instructionBuffer, d1/2,     1, q1, SIDE_HIGH_FIRST, OPT_SIDE_1, &length, MAX_ASMDELAY);   //    6: set    pins, 1         side 1 [delay] 
+    half(instructionBuffer, d1/2 - 1, 0, q1, SIDE_LOW_FIRST,  OPT_SIDE_0, &length, MAX_ASMDELAY);   //  ...: set    pins, 0         side 0 [delay] 
     instructionBuffer[length] = ASM_JMP_XMM | (0x1F & loop_1_label);                             //  ...: jmp    x--, loop_1_label
     length++;
     // remaining period to fill symbol time
-    repeat(instructionBuffer,                          tmp1, ASM_SET_PINS | OPT_SIDE_1 | 1, &length, MAX_ASMDELAY); //  ...: set    pins, 1         side 1 [delay] 
-    repeat(instructionBuffer, max(0,lastPeriodCycles1-tmp1), ASM_SET_PINS | OPT_SIDE_0 | 0, &length, MAX_ASMDELAY); //  ...: set    pins, 0         side 0 [delay] 
+    half(instructionBuffer,                          tmp1, 1, q1, SIDE_HIGH_FIRST, OPT_SIDE_1, &length, MAX_ASMDELAY); //  ...: set    pins, 1         side 1 [delay] 
+    half(instructionBuffer, max(0,lastPeriodCycles1-tmp1), 0, q1, SIDE_LOW_FIRST,  OPT_SIDE_0, &length, MAX_ASMDELAY); //  ...: set    pins, 0         side 0 [delay] 
     instructionBuffer[length] = ASM_JMP | get_symbol_label;               // ...: jmp    get_symbol_label
     length++;
     /*       symbol 0       */
     instructionBuffer[length] = ASM_MOV | (ASM_X_REG << 5) | ASM_ISR_REG, // ...: mov    x, isr  
     length++; 
     // full periods
-    repeat(instructionBuffer, d0/2,     ASM_SET_PINS | OPT_SIDE_1 | 1, &length, MAX_ASMDELAY);    // ...: set    pins, 1         side 1 [delay_part] 
-    repeat(instructionBuffer, d0/2 - 1, ASM_SET_PINS | OPT_SIDE_0 | 0, &length, MAX_ASMDELAY);    // ...: set    pins, 0         side 0 [delay_part] 
+    half(instructionBuffer, d0/2,     1, q0, SIDE_HIGH_FIRST, OPT_SIDE_1, &length, MAX_ASMDELAY);    // ...: set    pins, 1         side 1 [delay_part] 
+    half(instructionBuffer, d0/2 - 1, 0, q0, SIDE_LOW_FIRST,  OPT_SIDE_0, &length, MAX_ASMDELAY);    // ...: set    pins, 0         side 0 [delay_part] 
     instructionBuffer[length] = ASM_JMP_XMM | (0x1F & loop_0_label);      //  ...: jmp    x--, loop_0_label
     length++;
     // remaining period to fill symbol time
-    repeat(instructionBuffer,                          tmp0, ASM_SET_PINS | OPT_SIDE_1 | 1, &length, MAX_ASMDELAY);  //  ...: set    pins, 1         side 1 [delay_part] 
-    repeat(instructionBuffer, max(0,lastPeriodCycles0-tmp0), ASM_SET_PINS | OPT_SIDE_0 | 0, &length, MAX_ASMDELAY);  //  ...: set    pins, 0         side 0 [delay_part] 
+    half(instructionBuffer,                          tmp0, 1, q0, SIDE_HIGH_FIRST, OPT_SIDE_1, &length, MAX_ASMDELAY);  //  ...: set    pins, 1         side 1 [delay_part] 
+    half(instructionBuffer, max(0,lastPeriodCycles0-tmp0), 0, q0, SIDE_LOW_FIRST,  OPT_SIDE_0, &length, MAX_ASMDELAY);  //  ...: set    pins, 0         side 0 [delay_part] 
     instructionBuffer[length] = ASM_JMP | get_symbol_label; // ...: jmp    get_symbol_label
 
     // configure program origin and length
@@ -93,29 +148,19 @@ bool generatePIOprogram(uint16_t d0,uint16_t d1, uint32_t baud, uint16_t* instru
     return true;
 }
 
-/* 
-    - based on d0/d1/baud, the modulation parameters will be computed and returned in the struct backscatter_config 
-    - pin2 is ignored if twoAntennas==false
-*/
-void backscatter_program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d0, uint16_t d1, uint32_t baud, struct backscatter_config *config, uint16_t *instructionBuffer, bool twoAntennas){
-    pio_sm_set_enabled(pio, sm, false); // stop state machine if running
-    // print warning at invalid settings
-    if(d0 % 2 != 0){
-        printf("WARNING: the clock divider d0 has to be an even integer. The state-machine may not function correctly");
-    }
-    if(d1 % 2 != 0){
-        printf("WARNING: the clock divider d1 has to be an even integer. The state-machine may not function correctly");
-    }
-    // correct baud-rate
-    if(((uint32_t) (CLKFREQ*pow(10,6))) % baud != 0){
-        uint32_t baud_new = round(((uint32_t) (CLKFREQ*pow(10,6))) / round(((double) CLKFREQ*pow(10,6)) / ((double) baud)));
-        printf("WARNING: a baudrate of %d Baud is not achievable with a %d MHz clock.\nTherefore, the closest achievable baud-rate %d Baud will be used.\n", baud, CLKFREQ, baud_new);
-        baud = baud_new;
+// GPIO output override of PIN_TX2 for the antenna phase (inverted and single do not change the program)
+static uint phaseOverride(enum antenna_phase phase){
+    if(phase == PHASE_INVERTED){
+        return GPIO_OVERRIDE_INVERT;
     }
-    // generate pio-program
-    struct pio_program backscatter_program;
-    generatePIOprogram(d0,d1,baud, instructionBuffer, &backscatter_program, twoAntennas);
+    return (phase == PHASE_SINGLE) ? GPIO_OVERRIDE_LOW : GPIO_OVERRIDE_NORMAL;
+}
+
+// load the program, start the state-machine with the loop counts and set the antenna phase of pin2
+static void load_program(PIO pio, uint sm, uint pin1, uint pin2, const struct backscatter_image *image){
     uint offset = 0;
+    struct pio_program backscatter_program = {.instructions = image->instructions, .length = image->length, .origin = -1};
+    pio_clear_instruction_memory(pio); // the backscatter program occupies the instruction memory of this PIO (allows re-initialization at run-time)
     pio_add_program_at_offset(pio, &backscatter_program, offset); // load program
     /* print state-machine instructions */
     //printf("state-machine length: %d\n", backscatter_program.length);
@@ -125,7 +170,7 @@ void backscatter_program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d
     // configure the state-machine
     pio_gpio_init(pio, pin1);
     pio_sm_set_consecutive_pindirs(pio, sm, pin1, 1, true);
-    if(twoAntennas){
+    if(image->two_antennas){
         pio_gpio_init(pio, pin2);
         pio_sm_set_consecutive_pindirs(pio, sm, pin2, 1, true);    
     }
@@ -134,7 +179,7 @@ void backscatter_program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d
     sm_config_set_wrap(&c, offset, offset + backscatter_program.length-1); 
     // setup specific state-machine config
     sm_config_set_set_pins(&c, pin1, 1);
-    if(twoAntennas){
+    if(image->two_antennas){
         sm_config_set_sideset(&c, 2, true, false);
         sm_config_set_sideset_pins(&c, pin2);
     }
@@ -142,11 +187,59 @@ void backscatter_program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d
     sm_config_set_out_shift(&c, false, true, 32);  // OUT shifts to left (MSB first), autopull after every 32 bit
     pio_sm_init(pio, sm, offset, &c);
     pio_sm_set_enabled(pio, sm, true);
-    uint32_t reps0 = ((CLKFREQ*1000000/baud - 4) / d0) - 1;
-    uint32_t reps1 = ((CLKFREQ*1000000/baud - 4) / d1) - 1;
-    pio_sm_put_blocking(pio, sm, reps0); // -1 is requried since JMP 0-- is still true
-    pio_sm_put_blocking(pio, sm, reps1); // -1 is required since JMP 0-- is still true
+    pio_sm_put_blocking(pio, sm, image->reps0);
+    pio_sm_put_blocking(pio, sm, image->reps1);
+    // antenna phase: pio_gpio_init() has reset the output override of pin2
+    loaded_two_antennas = image->two_antennas;
+    loaded_quarter = image->two_antennas && image->phase == PHASE_QUARTER;
+    if(image->two_antennas){
+        gpio_set_outover(pin2, phaseOverride(image->phase));
+    }
+    loaded_image = *image;
+}
 
+/* 
+    - based on d0/d1/baud, the modulation parameters will be computed and returned in the struct backscatter_config 
+    - pin2 is ignored if twoAntennas==false
+    - verbose: print warnings and the computed settings
+*/
+static bool program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d0, uint16_t d1, uint32_t baud, struct backscatter_config *config, uint16_t *instructionBuffer, bool twoAntennas, bool verbose){
+    pio_sm_set_enabled(pio, sm, false); // stop state machine if running
+    // print warning at invalid settings
+    if(verbose && d0 % 2 != 0){
+        lib_printf("WARNING: the clock divider d0 has to be an even integer. The state-machine may not function correctly");
+    }
+    if(verbose && d1 % 2 != 0){
+        lib_printf("WARNING: the clock divider d1 has to be an even integer. The state-machine may not function correctly");
+    }
+    // correct baud-rate
+    if(((uint32_t) (CLKFREQ*pow(10,6))) % baud != 0){
+        uint32_t baud_new = round(((uint32_t) (CLKFREQ*pow(10,6))) / round(((double) CLKFREQ*pow(10,6)) / ((double) baud)));
+        if(verbose){
+            lib_printf("WARNING: a baudrate of %d Baud is not achievable with a %d MHz clock.\nTherefore, the closest achievable baud-rate %d Baud will be used.\n", baud, CLKFREQ, baud_new);
+        }
+        baud = baud_new;
+    }
+    // the quarter phase needs more instructions: fall back to in-phase instead of failing
+    enum antenna_phase requested = antenna_phase;
+    if(twoAntennas && antenna_phase == PHASE_QUARTER && programLength(d0, d1, baud, true) >= 32){
+        antenna_phase = PHASE_IN_PHASE;
+        if(verbose){
+            lib_printf("WARNING: the program of the quarter antenna phase does not fit into the instruction memory, in-phase is used\n");
+        }
+    }
+    // generate pio-program
+    struct pio_program backscatter_program;
+    bool generated = generatePIOprogram(d0,d1,baud, instructionBuffer, &backscatter_program, twoAntennas);
+    enum antenna_phase loaded_phase = antenna_phase;
+    antenna_phase = requested;
+    if(!generated){
+        return false;
+    }
+    struct backscatter_image image = {.length = backscatter_program.length, .two_antennas = twoAntennas, .phase = loaded_phase};
+    memcpy(image.instructions, instructionBuffer, backscatter_program.length*sizeof(uint16_t));
+    image.reps0 = ((CLKFREQ*1000000/baud - 4) / d0) - 1; // -1 is requried since JMP 0-- is still true
+    image.reps1 = ((CLKFREQ*1000000/baud - 4) / d1) - 1;
     // compute configuration parameters
     uint32_t fcenter    = (CLKFREQ*1000000/d0 + CLKFREQ*1000000/d1)/2;
     uint32_t fdeviation = abs(round((((double) CLKFREQ*1000000)/((double) d1)) - ((double) fcenter)));
@@ -154,18 +247,62 @@ void backscatter_program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d
     config->center_offset = round(fcenter);
     config->deviation   = round(fdeviation);
     config->minRxBw     = round((baud + 2*fdeviation));
-    
+    image.config = *config;
+    load_program(pio, sm, pin1, pin2, &image);
+    if(!verbose){
+        return true;
+    }
+
     if (fdeviation > 380000){
-        printf("WARNING: the deviation is too large for the CC2500\n");
+        lib_printf("WARNING: the deviation is too large for the CC2500\n");
     }
     if (fdeviation > 1000000){
-        printf("WARNING: the deviation is too large for the CC1352\n");
+        lib_printf("WARNING: the deviation is too large for the CC1352\n");
     }
     if (d0 < d1){
-        printf("WARNING: symbol 0 has been assigned to larger frequncy than symbol 1\n");
+        lib_printf("WARNING: symbol 0 has been assigned to larger frequncy than symbol 1\n");
     }
 
-    printf("Computed baseband settings: \n- baudrate: %d\n- Center offset: %d\n- deviation: %d\n- RX Bandwidth: %d\n", config->baudrate, config->center_offset, config->deviation, config->minRxBw);
+    lib_printf("Computed baseband settings: \n- baudrate: %d\n- Center offset: %d\n- deviation: %d\n- RX Bandwidth: %d\n", config->baudrate, config->center_offset, config->deviation, config->minRxBw);
+    if (twoAntennas && loaded_phase != PHASE_IN_PHASE){
+        lib_printf("- antenna phase: %s\n", antennaPhaseName(loaded_phase));
+    }
+    return true;
+}
+
+bool backscatter_program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d0, uint16_t d1, uint32_t baud, struct backscatter_config *config, uint16_t *instructionBuffer, bool twoAntennas){
+    return program_init(pio, sm, pin1, pin2, d0, d1, baud, config, instructionBuffer, twoAntennas, true);
+}
+
+bool backscatter_program_reload(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d0, uint16_t d1, uint32_t baud, struct backscatter_config *config, uint16_t *instructionBuffer, bool twoAntennas){
+    return program_init(pio, sm, pin1, pin2, d0, d1, baud, config, instructionBuffer, twoAntennas, false);
+}
+
+void backscatter_program_image(struct backscatter_image *image){
+    *image = loaded_image;
+}
+
+bool backscatter_program_restore(PIO pio, uint sm, uint pin1, uint pin2, const struct backscatter_image *image){
+    if(image->length < 6 || image->length >= 32 || image->phase >= ANTENNA_PHASES){
+        return false;
+    }
+    pio_sm_set_enabled(pio, sm, false); // stop state machine if running
+    antenna_phase = image->phase;
+    load_program(pio, sm, pin1, pin2, image);
+    return true;
+}
+
+bool backscatter_switch_phase(uint pin2, enum antenna_phase phase){
+    if(loaded_two_antennas && (phase == PHASE_QUARTER) != loaded_quarter){
+        return false; // the program has to be reloaded
+    }
+    antenna_phase = phase;
+    loaded_image.phase = phase;
+    if(loaded_two_antennas){
+        // the override takes effect at once (the state-machine keeps running)
+        gpio_set_outover(pin2, phaseOverride(phase));
+    }
+    return true;
 }
 
 void backscatter_send(PIO pio, uint sm, uint32_t *message, uint32_t len) {
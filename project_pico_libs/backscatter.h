@@ -7,6 +7,7 @@
 
 #if !PICO_NO_HARDWARE
 #include "hardware/pio.h"
+#include "backscatter_fifo.h"
 #endif
 
 #include <stdio.h>
@@ -43,6 +44,33 @@ struct backscatter_config {
 };
 #endif
 
+/* relative phase of the second antenna (PIN_TX2) to the first one (PIN_TX1) */
+#ifndef ANTENNA_PHASE_ENUM
+#define ANTENNA_PHASE_ENUM
+enum antenna_phase {
+  PHASE_IN_PHASE = 0, // PIN_TX2 mirrors PIN_TX1 (side-set)
+  PHASE_INVERTED,     // PIN_TX2 inverted: GPIO output override, same program
+  PHASE_QUARTER,      // PIN_TX2 a quarter period after PIN_TX1: own program (up to 8 more instructions)
+  PHASE_SINGLE,       // PIN_TX2 held low (first antenna only): GPIO output override, same program
+  ANTENNA_PHASES
+};
+#endif
+
+/* loaded program of the state-machine: generated instructions, loop counts put into the FIFO and computed settings
+ * (restored by backscatter_program_restore() without generating the program, e.g. from flash) */
+#ifndef BACKSCATTER_IMAGE_STRUCT
+#define BACKSCATTER_IMAGE_STRUCT
+struct backscatter_image {
+  uint16_t instructions[32];
+  uint8_t  length;
+  bool     two_antennas;
+  uint8_t  phase;   // loaded antenna phase (enum antenna_phase)
+  uint32_t reps0;   // full periods of symbol 0 - 1 (first word of the FIFO)
+  uint32_t reps1;   // full periods of symbol 1 - 1 (second word of the FIFO)
+  struct backscatter_config config;
+};
+#endif
+
 // ----------- //
 // backscatter //
 // ----------- //
@@ -53,9 +81,36 @@ uint8_t instructionCount(uint16_t delay, uint16_t max_delay);
 // repeat the instruction until the desired delay has past
 int16_t repeat(uint16_t* instructionBuffer, int16_t delay, uint32_t asm_instr, uint8_t *length, uint16_t max_delay);
 
+// number of instructions of the generated program for the selected antenna phase (it has to be below 32 to fit)
+uint8_t programLength(uint16_t d0, uint16_t d1, uint32_t baud, bool twoAntennas);
+
+// select the antenna phase of the next generatePIOprogram()/backscatter_program_init() (ignored with one antenna)
+void setAntennaPhase(enum antenna_phase phase);
+
+enum antenna_phase getAntennaPhase(void);
+
+const char *antennaPhaseName(enum antenna_phase phase);
+
 bool generatePIOprogram(uint16_t d0,uint16_t d1, uint32_t baud, uint16_t* instructionBuffer, struct pio_program *backscatter_program, bool twoAntennas);
 
-/* based on d0/d1/baud, the modulation parameters will be computed and returned in the struct backscatter_config */
-void backscatter_program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d0, uint16_t d1, uint32_t baud, struct backscatter_config *config, uint16_t *instructionBuffer, bool twoAntennas);
+/* based on d0/d1/baud, the modulation parameters will be computed and returned in the struct backscatter_config
+ * returns false if the program does not fit into the instruction memory (the state-machine is not started) */
+bool backscatter_program_init(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d0, uint16_t d1, uint32_t baud, struct backscatter_config *config, uint16_t *instructionBuffer, bool twoAntennas);
+
+/* same as backscatter_program_init without printing the settings (e.g. to change the antenna phase between two frames) */
+bool backscatter_program_reload(PIO pio, uint sm, uint pin1, uint pin2, uint16_t d0, uint16_t d1, uint32_t baud, struct backscatter_config *config, uint16_t *instructionBuffer, bool twoAntennas);
+
+// image of the loaded program (after backscatter_program_init/reload/restore)
+void backscatter_program_image(struct backscatter_image *image);
+
+/* load a program image without generating it (no floating point math, no prints), the antenna phase is taken from the image
+ * returns false if the image is not valid (the state-machine is not touched) */
+bool backscatter_program_restore(PIO pio, uint sm, uint pin1, uint pin2, const struct backscatter_image *image);
+
+/* switch the antenna phase of the running state-machine by the GPIO output override of pin2 (in-phase, inverted and single share
+ * one program), returns false if the loaded program does not support the phase (quarter: reload the program) */
+bool backscatter_switch_phase(uint pin2, enum antenna_phase phase);
 
 void backscatter_send(PIO pio, uint sm, uint32_t *message, uint32_t len);
+
+// non-blocking variant of backscatter_send: backscatter_start() and backscatter_wait_sent() of backscatter_fifo.h
@@ -0,0 +1,38 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Sending a message through the FIFO of a backscatter state-machine without waiting a fixed time.
+ *
+ * The functions only use the FIFO and the TXSTALL flag of the state-machine, hence they work with the
+ * program of backscatter.c as well as with the program assembled at compile time (baseband/backscatter.pio).
+ *
+ */
+
+#ifndef BACKSCATTER_FIFO_LIB
+#define BACKSCATTER_FIFO_LIB
+
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+
+/*
+ * send without waiting for the end of the message: put the message into the FIFO and return once its last word is queued
+ * (a message of up to 8 words, the joined TX FIFO, returns immediately; a longer one, e.g. with FEC, blocks while the
+ * first words are backscattered)
+ * backscatter_wait_sent() returns as soon as the state-machine stalled on the empty FIFO (last symbol completed)
+ */
+static inline void backscatter_start(PIO pio, uint sm, uint32_t *message, uint32_t len) {
+    for(uint32_t i = 0; i < len; i++){
+        pio_sm_put_blocking(pio, sm, message[i]);
+    }
+    // the state-machine is no longer stalled: clear the sticky stall flag to detect the end of this message
+    pio->fdebug = 1u << (PIO_FDEBUG_TXSTALL_LSB + sm);
+}
+
+static inline void backscatter_wait_sent(PIO pio, uint sm) {
+    // autopull stalls the OUT instruction after the last symbol of the message
+    while(!(pio->fdebug & (1u << (PIO_FDEBUG_TXSTALL_LSB + sm)))){
+        tight_loop_contents();
+    }
+}
+
+#endif
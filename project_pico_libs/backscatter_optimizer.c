@@ -0,0 +1,205 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Search of the backscatter configuration (see backscatter_optimizer.h).
+ *
+ */
+
+#include "backscatter_optimizer.h"
+#include "backscatter.h"
+#include "cc2500_regs.h"
+
+#define F_PIO ((uint32_t) CLKFREQ*1000000)
+#define OPT_BAUD_TRIES 16 // symbol lengths tried above the bound of a divider pair (rounding of baud-rate and filter)
+
+struct opt_receiver opt_receiver_limits(uint16_t receiver){
+    struct opt_receiver limits;
+    if (receiver == 1352){
+        // specified from 20 to 1000 kBaud (see README.md)
+        limits = (struct opt_receiver) {.max_deviation = 1000000, .max_bandwidth = 2000000, .min_baud = 20000, .max_baud = 1000000, .cc2500_filter = false};
+    } else {
+        // 2-FSK from 1.2 to 500 kBaud, widest channel filter 812.5 kHz
+        limits = (struct opt_receiver) {.max_deviation = 380000, .max_bandwidth = 812500, .min_baud = 1200, .max_baud = 500000, .cc2500_filter = true};
+    }
+    return limits;
+}
+
+struct opt_search opt_default_search(uint16_t receiver, uint32_t f_carrier, bool two_antennas){
+    struct opt_search search = {
+        .receiver = receiver,
+        .f_carrier = f_carrier,
+        .two_antennas = two_antennas,
+        .bauds = NULL,
+        .n_bauds = 0,
+        .max_divider = OPT_MAX_DIVIDER,
+        .min_offset = OPT_MIN_OFFSET,
+        .min_index_pct = OPT_MIN_INDEX_PCT
+    };
+    return search;
+}
+
+/* center offset and deviation as computed by backscatter_program_init() */
+static inline uint32_t center_offset(uint16_t d0, uint16_t d1){
+    return (F_PIO/d0 + F_PIO/d1)/2;
+}
+
+static inline uint32_t deviation(uint16_t d1, uint32_t center){
+    return (F_PIO + d1/2)/d1 - center;
+}
+
+bool opt_evaluate(const struct opt_search *search, uint16_t d0, uint16_t d1, uint32_t baud, struct opt_candidate *candidate){
+    struct opt_receiver limits = opt_receiver_limits(search->receiver);
+    // achievable baud-rate (as corrected by backscatter_program_init)
+    uint32_t cycles = (F_PIO + baud/2)/baud;
+    if (F_PIO % baud != 0){
+        baud = (F_PIO + cycles/2)/cycles;
+    }
+    cycles = F_PIO/baud;
+
+    candidate->d0 = d0;
+    candidate->d1 = d1;
+    candidate->baud = baud;
+    candidate->center_offset = center_offset(d0, d1);
+    candidate->deviation = deviation(d1, candidate->center_offset);
+    candidate->min_rx_bw = baud + 2*candidate->deviation;
+    candidate->filter_bw = limits.cc2500_filter ? cc2500_bandwidth_regs(candidate->min_rx_bw).value : candidate->min_rx_bw;
+    candidate->guard = (candidate->center_offset > candidate->filter_bw/2) ? candidate->center_offset - candidate->filter_bw/2 : 0;
+    candidate->program_length = 0;
+
+    if (d0 % 2 != 0 || d1 % 2 != 0 || d0 <= d1 || d1 < 2 || cycles < 4 + (uint32_t) d0){
+        return false; // odd dividers, symbol 0 above symbol 1 or less than one period per symbol
+    }
+    if (candidate->deviation > limits.max_deviation || baud < limits.min_baud || baud > limits.max_baud || candidate->min_rx_bw > limits.max_bandwidth){
+        return false;
+    }
+    if (((uint64_t) 200)*candidate->deviation < ((uint64_t) search->min_index_pct)*baud){
+        return false;
+    }
+    uint32_t half = candidate->center_offset + candidate->filter_bw/2;
+    if (candidate->guard < search->min_offset || ((uint64_t) search->f_carrier) + half > OPT_ISM_HIGH || search->f_carrier < OPT_ISM_LOW + half){
+        return false; // the receive channel overlaps the carrier or a sideband is outside of the ISM band
+    }
+    candidate->program_length = programLength(d0, d1, baud, search->two_antennas);
+    return candidate->program_length < 32;
+}
+
+bool opt_better(const struct opt_candidate *a, const struct opt_candidate *b){
+    if (a->baud != b->baud){
+        return a->baud > b->baud;
+    }
+    if (a->min_rx_bw != b->min_rx_bw){
+        return a->min_rx_bw < b->min_rx_bw;
+    }
+    if (a->guard != b->guard){
+        return a->guard > b->guard;
+    }
+    return a->program_length < b->program_length;
+}
+
+/* insert into the ranked list best[0 .. *len) of at most n entries */
+static void insert(struct opt_candidate *best, uint16_t *len, uint16_t n, const struct opt_candidate *candidate){
+    if (n == 0 || (*len == n && !opt_better(candidate, &best[n - 1]))){
+        return;
+    }
+    uint16_t pos = (*len < n) ? (*len)++ : n - 1;
+    while (pos > 0 && opt_better(candidate, &best[pos - 1])){
+        best[pos] = best[pos - 1];
+        pos--;
+    }
+    best[pos] = *candidate;
+}
+
+/* widest channel filter of the CC2500 not above bw (0 if there is none) */
+static uint32_t cc2500_filter_below(uint32_t bw){
+    uint32_t widest = 0;
+    for (uint8_t e = 0; e < 4; e++){
+        for (uint8_t m = 0; m < 4; m++){
+            uint32_t divider = (8u*(4 + m)) << e;
+            uint32_t value = (CC2500_XOSC + divider/2)/divider; // rounded as cc2500_bandwidth_regs()
+            if (value <= bw && value > widest){
+                widest = value;
+            }
+        }
+    }
+    return widest;
+}
+
+/* highest baud-rate of the divider pair, returns false if there is none */
+static bool best_baud(const struct opt_search *search, const struct opt_receiver *limits, uint16_t d0, uint16_t d1, struct opt_candidate *candidate){
+    uint32_t center = center_offset(d0, d1);
+    uint32_t dev = deviation(d1, center);
+    // upper bound: receiver, modulation index, one period per symbol
+    uint64_t bound = min(limits->max_baud, F_PIO/(4 + (uint32_t) d0));
+    if (search->min_index_pct > 0){
+        bound = min(bound, ((uint64_t) 200)*dev/search->min_index_pct);
+    }
+    if (search->f_carrier <= OPT_ISM_LOW || search->f_carrier >= OPT_ISM_HIGH){
+        return false;
+    }
+    uint32_t room = min(OPT_ISM_HIGH - search->f_carrier, search->f_carrier - OPT_ISM_LOW); // largest center + bandwidth/2
+    if (center <= search->min_offset || room <= center){
+        return false;
+    }
+    // widest channel filter: receiver, distance from the carrier and ISM band
+    uint32_t filter = min(limits->max_bandwidth, 2*min(center - search->min_offset, room - center));
+    if (limits->cc2500_filter){
+        filter = cc2500_filter_below(filter);
+    }
+    if (filter <= 2*dev){
+        return false;
+    }
+    bound = min(bound, filter - 2*dev);
+    if (bound == 0){
+        return false;
+    }
+    /* longer symbols until the configuration is feasible: except for the program length, the constraints only
+     * get looser. The program length grows with the remainders (cycles - 4) % d0 and (cycles - 4) % d1 of the
+     * last period, hence it can only shrink where one of them wraps to 0 */
+    uint32_t cycles = max(F_PIO/bound, 4 + (uint32_t) d0);
+    uint16_t tries = 0;
+    while (tries++ < OPT_BAUD_TRIES + 2*(d0 + d1) && cycles <= F_PIO/limits->min_baud){
+        if (opt_evaluate(search, d0, d1, (F_PIO + cycles/2)/cycles, candidate)){
+            return true;
+        }
+        // symbol length of the rounded baud-rate (may be one cycle shorter)
+        uint32_t tested = F_PIO/candidate->baud;
+        uint32_t next = cycles + 1; // rejected by the receiver limits (rounding)
+        if (candidate->program_length > 0){
+            next = max(next, tested + min(d0 - (tested - 4) % d0, d1 - (tested - 4) % d1));
+        }
+        cycles = next;
+    }
+    return false;
+}
+
+uint32_t opt_find_best(const struct opt_search *search, struct opt_candidate *best, uint16_t n){
+    struct opt_receiver limits = opt_receiver_limits(search->receiver);
+    uint16_t max_divider = search->max_divider ? search->max_divider : OPT_MAX_DIVIDER;
+    struct opt_candidate candidate;
+    uint32_t feasible = 0;
+    uint16_t len = 0;
+    for (uint16_t d1 = 2; d1 + 2 <= max_divider; d1 += 2){
+        if (F_PIO/d1 <= search->min_offset){
+            break; // the subcarrier is below F_PIO/d1, larger dividers are even closer to the carrier
+        }
+        for (uint16_t d0 = d1 + 2; d0 <= max_divider; d0 += 2){
+            if (deviation(d1, center_offset(d0, d1)) > limits.max_deviation){
+                break; // the deviation grows with d0
+            }
+            if (search->bauds == NULL || search->n_bauds == 0){
+                if (best_baud(search, &limits, d0, d1, &candidate)){
+                    feasible++;
+                    insert(best, &len, n, &candidate);
+                }
+            } else {
+                for (uint8_t b = 0; b < search->n_bauds; b++){
+                    if (opt_evaluate(search, d0, d1, search->bauds[b], &candidate)){
+                        feasible++;
+                        insert(best, &len, n, &candidate);
+                    }
+                }
+            }
+        }
+    }
+    return feasible;
+}
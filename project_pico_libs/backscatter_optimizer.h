@@ -0,0 +1,85 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Search of the backscatter configuration (clock dividers d0/d1 and baud-rate) with the highest
+ * throughput for a receiver, carrier frequency and antenna mode.
+ *
+ * All even divider pairs d0 > d1 are enumerated. A configuration is feasible if
+ * - the program of generatePIOprogram() fits into the instruction memory and each symbol contains at
+ *   least one full period of its frequency
+ * - the receiver supports the deviation, the data rate and the bandwidth (minRxBw, rounded up to the
+ *   channel filter of the CC2500)
+ * - the modulation index (2 * deviation / baud) is at least min_index
+ * - the receive channel keeps min_offset from the carrier (carrier error and side lobes, see
+ *   carrier-characteristics) and both sidebands are within the 2.4 GHz ISM band
+ * The feasible configurations are ranked by data rate (highest first), occupied bandwidth (narrowest
+ * first) and distance of the subcarrier from the carrier (largest first).
+ *
+ * Without a list of baud-rates, the highest feasible baud-rate (125 MHz / n) of each divider pair is
+ * searched: starting at the bound of the receiver limits, the symbol is extended to the next length at
+ * which a remainder of the last period wraps (the only lengths at which the program can get shorter).
+ * The search uses integer arithmetic only and skips the divider pairs beyond the deviation limit, such
+ * that it can run on the Pico at run-time.
+ *
+ */
+
+#ifndef BACKSCATTER_OPTIMIZER_LIB
+#define BACKSCATTER_OPTIMIZER_LIB
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define OPT_ISM_LOW      2400000000u // [Hz]
+#define OPT_ISM_HIGH     2483500000u // [Hz]
+#define OPT_MIN_OFFSET       1500000 // default distance of the receive channel from the carrier [Hz]
+#define OPT_MIN_INDEX_PCT         50 // default minimal modulation index [%]
+#define OPT_MAX_DIVIDER          256 // default largest clock divider
+
+/* limits of the receiver */
+struct opt_receiver {
+  uint32_t max_deviation;  // [Hz]
+  uint32_t max_bandwidth;  // widest channel filter [Hz]
+  uint32_t min_baud;
+  uint32_t max_baud;
+  bool     cc2500_filter;  // channel filter bandwidth rounded up to the settings of the CC2500
+};
+
+struct opt_search {
+  uint16_t receiver;       // 2500 or 1352 (see opt_receiver_limits)
+  uint32_t f_carrier;      // [Hz]
+  bool     two_antennas;
+  const uint32_t *bauds;   // candidate baud-rates (NULL: highest baud-rate of each divider pair)
+  uint8_t  n_bauds;
+  uint16_t max_divider;    // largest clock divider (0: OPT_MAX_DIVIDER)
+  uint32_t min_offset;     // distance of the lower edge of the receive channel from the carrier [Hz]
+  uint8_t  min_index_pct;  // minimal modulation index [%]
+};
+
+struct opt_candidate {
+  uint16_t d0;
+  uint16_t d1;
+  uint32_t baud;           // achievable baud-rate (125 MHz / n)
+  uint32_t center_offset;  // as backscatter_program_init() [Hz]
+  uint32_t deviation;      // [Hz]
+  uint32_t min_rx_bw;      // baud + 2 * deviation [Hz]
+  uint32_t filter_bw;      // channel filter of the receiver [Hz]
+  uint32_t guard;          // center_offset - filter_bw/2 [Hz]
+  uint8_t  program_length; // instructions
+};
+
+/* limits of the receiver CC2500 (2500) or CC1352P7 (1352) */
+struct opt_receiver opt_receiver_limits(uint16_t receiver);
+
+/* default search: OPT_MIN_OFFSET, OPT_MIN_INDEX_PCT, OPT_MAX_DIVIDER, highest baud-rate of each divider pair */
+struct opt_search opt_default_search(uint16_t receiver, uint32_t f_carrier, bool two_antennas);
+
+/* evaluate one configuration, returns false if it is not feasible (candidate is filled anyway) */
+bool opt_evaluate(const struct opt_search *search, uint16_t d0, uint16_t d1, uint32_t baud, struct opt_candidate *candidate);
+
+/* true if a ranks before b */
+bool opt_better(const struct opt_candidate *a, const struct opt_candidate *b);
+
+/* search all feasible configurations, the best n are stored in best (ranked), returns the number of feasible configurations */
+uint32_t opt_find_best(const struct opt_search *search, struct opt_candidate *best, uint16_t n);
+
+#endif
@@ -0,0 +1,87 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * On-device bit error rate of the received file (see stats/statistics.ipynb).
+ *
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "packet_generation.h"
+#include "ber_stats.h"
+
+void ber_stats_reset(struct ber_stats *stats){
+    memset(stats, 0, sizeof(struct ber_stats));
+    generator_init(&stats->reference, file_generator.initial_seed);
+}
+
+static uint8_t popcount8(uint8_t x){
+    uint8_t count = 0;
+    for(; x; count++){
+        x &= x - 1;
+    }
+    return count;
+}
+
+void ber_stats_update(struct ber_stats *stats, uint8_t *payload, uint8_t len, uint64_t time_us){
+    if(len <= 2){
+        return;
+    }
+    uint8_t expected[len];
+    uint16_t index = (((uint16_t) payload[0]) << 8) | payload[1];
+    if(!generator_seek(&stats->reference, index)){
+        // odd file index: not the start of a sample
+        stats->index_errors++;
+        generator_seek(&stats->reference, 0);
+    }
+    generator_data(&stats->reference, expected, len, true);
+
+    uint32_t errors = 0;
+    for(uint8_t i = 2; i < len; i++){
+        errors += popcount8(payload[i] ^ expected[i]);
+    }
+    if(stats->packets == 0){
+        stats->first_rx_us = time_us;
+    }
+    stats->last_rx_us = time_us;
+    stats->packets++;
+    stats->packet_errors += (errors > 0);
+    stats->bit_errors += errors;
+    stats->bits += 8*len; // the file index is counted as received bits (stats/functions.py)
+}
+
+uint64_t ber_stats_file_delay(struct ber_stats *stats){
+    return stats->last_rx_us - stats->first_rx_us;
+}
+
+uint32_t ber_stats_data_rate(struct ber_stats *stats, uint8_t len){
+    uint64_t delay_us = max(1, ber_stats_file_delay(stats));
+    return (uint32_t) ((((uint64_t) stats->packets)*(len - 2)*8*1000000)/delay_us);
+}
+
+uint32_t ber_stats_per(struct ber_stats *stats, uint32_t sent){
+    uint32_t lost = (sent > stats->packets) ? sent - stats->packets : 0;
+    return (10000*(lost + stats->packet_errors))/max(1, sent);
+}
+
+uint32_t ber_stats_goodput(struct ber_stats *stats, uint8_t len){
+    uint64_t delay_us = max(1, ber_stats_file_delay(stats));
+    return (uint32_t) ((((uint64_t) (stats->packets - stats->packet_errors))*(len - 2)*8*1000000)/delay_us);
+}
+
+void print_ber_stats(const char *name, struct ber_stats *stats, uint32_t sent, uint8_t len){
+    char line[BER_STATS_LINE_MAX];
+    format_ber_stats(line, sizeof(line), name, stats, sent, len);
+    printf("%s", line);
+}
+
+int format_ber_stats(char *line, size_t size, const char *name, struct ber_stats *stats, uint32_t sent, uint8_t len){
+    uint64_t ber = (stats->bit_errors*10000000000ull)/max(1, stats->bits); // [1e-8 %]
+    uint32_t per = ber_stats_per(stats, sent);                          // [0.01 %]
+    uint64_t delay_ms = ber_stats_file_delay(stats)/1000;
+    return snprintf(line, size, "# %s: packets %u bit errors %" PRIu64 " of %" PRIu64 " BER %" PRIu64 ".%08" PRIu64 "%% PER %u.%02u%% index errors %u file delay %" PRIu64 ".%03" PRIu64 " s data rate %u bit/s\n",
+           name, stats->packets, stats->bit_errors, stats->bits, ber/100000000, ber%100000000, per/100, per%100,
+           stats->index_errors, delay_ms/1000, delay_ms%1000, ber_stats_data_rate(stats, len));
+}
@@ -0,0 +1,57 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * On-device bit error rate of the received file (see stats/statistics.ipynb).
+ *
+ * The payload starts with the file index (2B) followed by the data generated with generate_data().
+ * Since the file is deterministic, a reference generator replays the expected data of each received
+ * file index and the received data is compared bit by bit. Unlike the stats scripts, any even file
+ * index can be replayed (also after the index wrapped), an odd file index is compared with the
+ * first packet of the file.
+ *
+ */
+
+#ifndef BER_STATS_LIB
+#define BER_STATS_LIB
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "packet_generation.h"
+
+struct ber_stats {
+  struct data_generator reference; // replays the expected data
+  uint32_t packets;                // evaluated packets
+  uint32_t packet_errors;          // packets with at least one bit error
+  uint32_t index_errors;           // packets with an odd file index
+  uint64_t bits;                   // received bits (file index and data)
+  uint64_t bit_errors;             // bit errors in the data
+  uint64_t first_rx_us;            // timestamp of the first evaluated packet
+  uint64_t last_rx_us;             // timestamp of the last evaluated packet
+};
+
+void ber_stats_reset(struct ber_stats *stats);
+
+/* compare the received payload (starting with the file index, length PAYLOADSIZE) with the expected data */
+void ber_stats_update(struct ber_stats *stats, uint8_t *payload, uint8_t len, uint64_t time_us);
+
+/* File Delay = Rx_timestamp[N] - Rx_timestamp[0] [us] */
+uint64_t ber_stats_file_delay(struct ber_stats *stats);
+
+/* data rate [bit/s]: received data (without file index) over the file delay */
+uint32_t ber_stats_data_rate(struct ber_stats *stats, uint8_t len);
+
+/* packet error rate [0.01%]: lost packets and packets with bit errors out of sent packets */
+uint32_t ber_stats_per(struct ber_stats *stats, uint32_t sent);
+
+/* goodput [bit/s]: data (without file index) of the packets without bit errors over the file delay */
+uint32_t ber_stats_goodput(struct ber_stats *stats, uint8_t len);
+
+/* print one summary line starting with '#': BER, PER (sent: number of transmitted packets), file delay and data rate */
+void print_ber_stats(const char *name, struct ber_stats *stats, uint32_t sent, uint8_t len);
+
+/* summary line of print_ber_stats into line (size bytes, zero-terminated), returns its length */
+#define BER_STATS_LINE_MAX 256
+int format_ber_stats(char *line, size_t size, const char *name, struct ber_stats *stats, uint32_t sent, uint8_t len);
+
+#endif
@@ -15,12 +15,13 @@
 
 #include <stdio.h>
 #include <string.h>
-#include <math.h>
 #include "pico/stdlib.h"
 #include "pico/binary_info.h"
 #include "hardware/spi.h"
 #include "receiver_CC2500.h"
 #include "carrier_CC2500.h"
+#include "cc2500_regs.h"
+#include "lib_output.h"
 
 // Address Config = No address check
 // Base Frequency = 2449.999756
@@ -142,6 +143,45 @@ void stopCarrier(){
     write_strobe_tx(SIDLE); // stop carrier (enter IDLE mode with command strobe: SIDLE)
 }
 
+uint8_t read_marcstate_tx() {
+    uint8_t buf[2] = {0, 0};
+    cs_select_tx();
+    spi_read_blocking(RADIO_SPI, 0xF5, buf, 2); // read status register MARCSTATE (0x35 + burst bit)
+    cs_deselect_tx();
+    return buf[1] & 0x1F;
+}
+
+uint32_t startCarrier_sync(){
+    uint8_t cmd = STX;
+    uint64_t start = time_us_64();
+    cs_select_tx();
+    spi_write_blocking(RADIO_SPI, &cmd, 1); // start carrier (enter TX mode with command strobe: STX)
+    cs_deselect_tx();
+    // wait until calibration and PLL settling are done
+    while(read_marcstate_tx() != MARCSTATE_TX && time_us_64() - start < CARRIER_SETTLE_TIMEOUT_US);
+    return (uint32_t) (time_us_64() - start);
+}
+
+void stopCarrier_sync(){
+    uint8_t cmd = SIDLE;
+    cs_select_tx();
+    spi_write_blocking(RADIO_SPI, &cmd, 1); // stop carrier (enter IDLE mode with command strobe: SIDLE)
+    cs_deselect_tx();
+}
+
+static bool manual_calibration = false;
+
+void setCarrierManualCalibration(bool manual){
+    manual_calibration = manual;
+    write_strobe_tx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
+    // MCSM0: FS_AUTOCAL = 0 (never) or 1 (when going from IDLE to RX or TX), PO_TIMEOUT = 2
+    RF_setting set = {.address = 0x18, .value = manual ? 0x08 : 0x18};
+    write_register_tx(set);
+    if(manual){
+        write_strobe_tx(SCAL); // calibrate now (takes approx. 720us, covered by the strobe delay)
+    }
+}
+
 void set_frecuency_tx(uint32_t f_carrier)
 {
 // Test read_register_tx
@@ -153,15 +193,15 @@ void set_frecuency_tx(uint32_t f_carrier)
     write_strobe_tx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
     
     // see datasheet, section 21
-    // approach: chose start frequency as close as possible to f_carrier, correct with channel
-    uint32_t freq = floor(f_carrier *((double) (1 << 16)) / ((double) F_XOSC));
+    // approach: chose the frequency control word closest to f_carrier, channel 0 (the channel spacing is unused)
+    uint32_t f_carrier_calculated;
+    uint32_t freq = cc2500_frequency_word(f_carrier, &f_carrier_calculated);
     uint8_t channel = 0;
     uint8_t channspc_e = 0;
-    uint8_t channspc_m = floor(((((double) f_carrier) * (1 << 16)) / ((double) F_XOSC) - freq - (1 << 6)) * (1 << 2));
+    uint8_t channspc_m = 0xF8; // reset value
 
     // print new value
-    uint32_t f_carrier_calculated = floor(((double) F_XOSC) * (freq + (double) channel*(256+channspc_m)/((double) (1 << 2))) / ((double) (1 << 16)));
-    printf("set tx f_carrier [%u %u %u %u] %u\n", freq, channel, channspc_e, channspc_m, f_carrier_calculated);
+    lib_printf("set tx f_carrier [%u %u %u %u] %u\n", freq, channel, channspc_e, channspc_m, f_carrier_calculated);
     
     // CHANNR, FREQ2, FREQ1, FREQ0, MDMCFG1, MDMCFG1
     RF_setting mdmcfg1 = read_register_tx(0x13);
@@ -175,4 +215,34 @@ void set_frecuency_tx(uint32_t f_carrier)
     };
     //printf("debug %02x %02x %02x %02x %02x %02x\n", set[0].value, set[1].value, set[2].value, set[3].value, set[4].value, set[5].value);
     write_registers_tx(set,6);
+    if(manual_calibration){
+        write_strobe_tx(SCAL); // re-calibrate for the new frequency
+    }
+}
+
+void read_image_tx(uint8_t *image){
+    uint8_t header = 0xC0; // burst read from 0x00
+    cs_select_tx();
+    spi_write_blocking(RADIO_SPI, &header, 1);
+    spi_read_blocking(RADIO_SPI, 0x00, image, CC2500_IMAGE_LEN);
+    cs_deselect_tx();
+}
+
+bool restoreCarrier(const uint8_t *image){
+    uint8_t cmd = SRES; // in case of reset without power loss - reset manually (without the fixed delays of setupCarrier)
+    uint64_t start = time_us_64();
+    cs_select_tx();
+    spi_write_blocking(RADIO_SPI, &cmd, 1);
+    cs_deselect_tx();
+    while(read_marcstate_tx() != MARCSTATE_IDLE && time_us_64() - start < CARRIER_SETTLE_TIMEOUT_US);
+    uint8_t header = 0x40; // burst write from 0x00
+    cs_select_tx();
+    spi_write_blocking(RADIO_SPI, &header, 1);
+    spi_write_blocking(RADIO_SPI, image, CC2500_IMAGE_LEN);
+    cs_deselect_tx();
+    setTXpower(TX_power[17]); // set +1dBm output power (max), as setupCarrier
+    manual_calibration = ((image[0x18] >> 4) & 0x03) == 0x00; // MCSM0: FS_AUTOCAL = 0
+    uint8_t check[CC2500_IMAGE_LEN];
+    read_image_tx(check);
+    return memcmp(check, image, CC2500_IMAGE_LEN) == 0;
 }
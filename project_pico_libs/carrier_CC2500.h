@@ -32,6 +32,11 @@
 #define SIDLE                 0x36
 #define   STX                 0x35
 #define  SRES                 0x30
+#define  SCAL                 0x33
+
+#define MARCSTATE_IDLE        0x01
+#define MARCSTATE_TX          0x13
+#define CARRIER_SETTLE_TIMEOUT_US 2000 // upper bound for IDLE -> TX (including calibration)
 
 #ifndef RF_SETTING
 #define RF_SETTING
@@ -74,7 +79,34 @@ void startCarrier();
 
 void stopCarrier();
 
+/* 
+ * fast carrier gating: strobe without the fixed 1ms delay
+ * startCarrier_sync() returns once the CC2500 reached TX state and provides the measured settling time [us]
+ */
+uint32_t startCarrier_sync();
+
+void stopCarrier_sync();
+
+// read the main radio control state (status register MARCSTATE)
+uint8_t read_marcstate_tx();
+
+/* 
+ * calibrate the frequency synthesizer once (and after each frequency change) instead of at every IDLE -> TX transition
+ * this reduces the settling time of the carrier from approx. 800us to approx. 90us (see datasheet, table 34)
+ */
+void setCarrierManualCalibration(bool manual);
+
 //set carrier frequency [Hz]
 void set_frecuency_tx(uint32_t f_carrier);
 
+// register image of the carrier (CC2500_IMAGE_LEN bytes, see cc2500_regs.h), including its calibration
+void read_image_tx(uint8_t *image);
+
+/*
+ * fast setup of the carrier from a register image (instead of setupCarrier and the configuration functions):
+ * reset and a single burst write without fixed delays, the calibration of the image is used (no SCAL)
+ * returns false if the read-back differs from the image (e.g. no carrier)
+ */
+bool restoreCarrier(const uint8_t *image);
+
 #endif
@@ -0,0 +1,108 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Integer-only solvers of the CC2500 register pairs (see cc2500_regs.h).
+ *
+ */
+
+#include "cc2500_regs.h"
+
+/* |a - b| */
+static inline uint64_t distance(uint64_t a, uint64_t b){
+    return (a > b) ? a - b : b - a;
+}
+
+/* round(num / den) */
+static inline uint32_t div_round(uint64_t num, uint64_t den){
+    return (uint32_t) ((num + den/2) / den);
+}
+
+struct cc2500_em cc2500_datarate_regs(uint32_t r_data){
+    // compare R * 2^28 with (256 + m) * 2^e * F_XOSC (at most 511 * 2^15 * 26e6 < 2^49)
+    uint64_t target = ((uint64_t) r_data) << 28;
+    struct cc2500_em best = {0, 0, 0};
+    uint64_t best_error = UINT64_MAX;
+    for (uint8_t e = 0; e < 16; e++) {
+        uint64_t step = ((uint64_t) CC2500_XOSC) << e;
+        if (target + step < 256*step || target > 512*step) {
+            continue; // no mantissa of this exponent within one step of the target (avoids the division)
+        }
+        // closest mantissa of this exponent: floor and floor + 1 of target/step - 256
+        uint64_t q = target / step;
+        for (uint64_t k = q; k <= q + 1; k++) {
+            if (k < 256 || k > 511) {
+                continue;
+            }
+            uint64_t error = distance(k*step, target);
+            if (error < best_error) {
+                best_error = error;
+                best.e = e;
+                best.m = (uint8_t) (k - 256);
+            }
+        }
+    }
+    if (best_error == UINT64_MAX && target > 256ull*CC2500_XOSC) {
+        // above the largest data rate (below the smallest one: e = 0, m = 0)
+        best.e = 15;
+        best.m = 255;
+    }
+    best.value = div_round((256 + (uint64_t) best.m)*(((uint64_t) CC2500_XOSC) << best.e), 1ull << 28);
+    return best;
+}
+
+struct cc2500_em cc2500_bandwidth_regs(uint32_t bw){
+    // narrowest BW >= bw: F_XOSC >= bw * 8 * (4 + m) * 2^e with the largest divider
+    struct cc2500_em best = {0, 0, 0};
+    uint32_t best_divider = 0;
+    for (uint8_t e = 0; e < 4; e++) {
+        for (uint8_t m = 0; m < 4; m++) {
+            uint32_t divider = (8u*(4 + m)) << e;
+            if (((uint64_t) bw)*divider <= CC2500_XOSC && divider > best_divider) {
+                best_divider = divider;
+                best.e = e;
+                best.m = m;
+            }
+        }
+    }
+    if (best_divider == 0) {
+        best_divider = 8*4; // wider than the widest filter
+    }
+    best.value = div_round(CC2500_XOSC, best_divider);
+    return best;
+}
+
+struct cc2500_em cc2500_deviation_regs(uint32_t f_dev){
+    // compare f_dev * 2^17 with F_XOSC * (8 + m) * 2^e
+    uint64_t target = ((uint64_t) f_dev) << 17;
+    struct cc2500_em best = {0, 0, 0};
+    uint64_t best_error = UINT64_MAX;
+    for (uint8_t e = 0; e < 8; e++) {
+        uint64_t step = ((uint64_t) CC2500_XOSC) << e;
+        if (target + step < 8*step || target > 16*step) {
+            continue; // no mantissa of this exponent within one step of the target
+        }
+        for (uint8_t m = 0; m < 8; m++) {
+            uint64_t error = distance((((uint64_t) CC2500_XOSC)*(8 + m)) << e, target);
+            if (error < best_error) {
+                best_error = error;
+                best.e = e;
+                best.m = m;
+            }
+        }
+    }
+    if (best_error == UINT64_MAX && target > 8ull*CC2500_XOSC) {
+        // above the largest deviation (below the smallest one: e = 0, m = 0)
+        best.e = 7;
+        best.m = 7;
+    }
+    best.value = div_round((((uint64_t) CC2500_XOSC)*(8 + best.m)) << best.e, 1ull << 17);
+    return best;
+}
+
+uint32_t cc2500_frequency_word(uint32_t f_carrier, uint32_t *f_calculated){
+    uint32_t freq = div_round(((uint64_t) f_carrier) << 16, CC2500_XOSC) & 0x00FFFFFF;
+    if (f_calculated) {
+        *f_calculated = div_round(((uint64_t) CC2500_XOSC)*freq, 1u << 16);
+    }
+    return freq;
+}
@@ -0,0 +1,47 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Integer-only solvers of the CC2500 exponent/mantissa register pairs (datasheet sections 12, 13, 16, 21).
+ *
+ * All (e, m) pairs are searched for the closest setting (no floating point, no log2), rounding in the
+ * direction the parameter needs:
+ * - data rate and deviation: nearest value
+ * - channel filter bandwidth: the narrowest bandwidth which is not below the requested one
+ *   (the signal has to pass the filter), the widest one (812.5 kHz) if none is wide enough
+ * - frequency: nearest frequency control word
+ *
+ */
+
+#ifndef CC2500_REGS_LIB
+#define CC2500_REGS_LIB
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#define CC2500_XOSC 26000000 // crystal frequency [Hz] (F_XOSC)
+
+/* register image: configuration registers 0x00 (IOCFG2) to 0x28 (RCCTRL0), including the calibration FSCAL3..FSCAL0
+ * (0x23-0x26), the test registers are not part of it (see read_image_rx/restoreReceiver, read_image_tx/restoreCarrier) */
+#define CC2500_IMAGE_LEN   0x29
+#define CC2500_FSCAL3      0x23
+#define CC2500_FSCAL0      0x26
+
+struct cc2500_em {
+  uint8_t  e;
+  uint8_t  m;
+  uint32_t value;  // resulting setting [Hz or Baud] (rounded to nearest)
+};
+
+/* MDMCFG4[3:0] (DRATE_E), MDMCFG3 (DRATE_M): R = (256 + m) * 2^e * F_XOSC / 2^28 */
+struct cc2500_em cc2500_datarate_regs(uint32_t r_data);
+
+/* MDMCFG4[7:4] (CHANBW_E, CHANBW_M): BW = F_XOSC / (8 * (4 + m) * 2^e) */
+struct cc2500_em cc2500_bandwidth_regs(uint32_t bw);
+
+/* DEVIATN (DEVIATION_E, DEVIATION_M): f_dev = F_XOSC * (8 + m) * 2^e / 2^17 */
+struct cc2500_em cc2500_deviation_regs(uint32_t f_dev);
+
+/* FREQ2..0 (24 bit): f = F_XOSC * freq / 2^16, returns freq (f_calculated: resulting frequency, may be NULL) */
+uint32_t cc2500_frequency_word(uint32_t f_carrier, uint32_t *f_calculated);
+
+#endif
@@ -0,0 +1,100 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Spectrum sensing using the RSSI register of the receiver CC2500.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "receiver_CC2500.h"
+#include "backscatter.h"
+#include "channel_scan.h"
+
+uint32_t scan_center_offset(uint16_t d0, uint16_t d1){
+    return (CLKFREQ*1000000/d0 + CLKFREQ*1000000/d1)/2;
+}
+
+int32_t scan_noise_floor(struct scan_entry *entry){
+    if(entry->samples == 0){
+        return 0;
+    }
+    return entry->rssi_sum / ((int32_t) entry->samples);
+}
+
+// is entry a less occupied than entry b?
+static bool scan_better(struct scan_entry *a, struct scan_entry *b){
+    // compare the fraction of occupied samples first (cross-multiplied to avoid a division)
+    uint32_t busy_a = ((uint32_t) a->busy) * b->samples;
+    uint32_t busy_b = ((uint32_t) b->busy) * a->samples;
+    if(busy_a != busy_b){
+        return busy_a < busy_b;
+    }
+    return scan_noise_floor(a) < scan_noise_floor(b);
+}
+
+static void scan_entry_measure(struct scan_config *config, struct scan_entry *entry){
+    tune_frecuency_rx(entry->f_carrier + entry->center_offset);
+    write_strobe_rx(SRX);        // enter RX mode (includes 1ms settling from the strobe)
+    sleep_us(SCAN_SETTLE_US);
+    absolute_time_t end = make_timeout_time_us(config->window_us);
+    while(absolute_time_diff_us(get_absolute_time(), end) > 0 || entry->samples == 0){
+        int32_t rssi = read_rssi_rx();
+        int32_t bin  = (rssi - SCAN_HIST_MIN_DBM) / SCAN_HIST_BIN_DB;
+        entry->hist[max(0, min(SCAN_HIST_BINS-1, bin))]++;
+        entry->rssi_sum += rssi;
+        entry->rssi_max  = max(entry->rssi_max, rssi);
+        entry->busy     += (rssi > SCAN_BUSY_THRESHOLD);
+        entry->samples++;
+        sleep_us(config->sample_interval_us);
+    }
+    write_strobe_rx(SIDLE);
+}
+
+void channel_scan(struct scan_config *config, struct scan_table *table){
+    memset(table, 0, sizeof(struct scan_table));
+    for(uint8_t c = 0; c < min(config->n_carriers, SCAN_MAX_CARRIERS); c++){
+        for(uint8_t o = 0; o < min(config->n_offsets, SCAN_MAX_OFFSETS); o++){
+            struct scan_entry *entry = &table->entry[table->len];
+            entry->f_carrier     = config->carriers[c];
+            entry->d0            = config->offsets[o].d0;
+            entry->d1            = config->offsets[o].d1;
+            entry->center_offset = scan_center_offset(entry->d0, entry->d1);
+            entry->rssi_max      = SCAN_HIST_MIN_DBM;
+            scan_entry_measure(config, entry);
+            if(scan_better(entry, &table->entry[table->best])){
+                table->best = table->len;
+            }
+            table->len++;
+        }
+    }
+    table->time_us = to_us_since_boot(get_absolute_time());
+}
+
+void print_scan_table(struct scan_table *table){
+    char line[SCAN_LINE_MAX];
+    format_scan_header(line, sizeof(line), table);
+    printf("%s", line);
+    for(uint8_t i = 0; i < table->len; i++){
+        format_scan_entry(line, sizeof(line), table, i);
+        printf("%s", line);
+    }
+}
+
+int format_scan_header(char *line, size_t size, struct scan_table *table){
+    return snprintf(line, size, "# channel scan: %u candidates, histogram from %d dBm in %d dB bins\n"
+                    "# carrier [kHz]  d0  d1 offset [kHz]  mean [dBm]  max [dBm]  busy [%%]  histogram\n",
+                    table->len, SCAN_HIST_MIN_DBM, SCAN_HIST_BIN_DB);
+}
+
+int format_scan_entry(char *line, size_t size, struct scan_table *table, uint8_t i){
+    struct scan_entry *entry = &table->entry[i];
+    char hist[6*SCAN_HIST_BINS + 1] = ""; // at most " 65535" per bin
+    uint8_t len = 0;
+    for(uint8_t b = 0; b < SCAN_HIST_BINS; b++){
+        len += sprintf(&hist[len], " %u", entry->hist[b]);
+    }
+    return snprintf(line, size, "# %13u %3u %3u %13u %11d %10d %9u %s%s\n", entry->f_carrier/1000, entry->d0, entry->d1, entry->center_offset/1000,
+                    scan_noise_floor(entry), entry->rssi_max, (100*entry->busy)/max(1, entry->samples), hist, (i == table->best) ? "  <- selected" : "");
+}
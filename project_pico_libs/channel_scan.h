@@ -0,0 +1,87 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Spectrum sensing using the RSSI register of the receiver CC2500.
+ *
+ * The receiver sweeps all candidate pairs of carrier frequency and subcarrier (clock dividers d0/d1)
+ * and samples the RSSI at the resulting receive frequency (carrier + center offset) for a configurable
+ * observation window. The samples are collected in an occupancy histogram. The pair with the least
+ * occupancy and the lowest noise floor is selected.
+ *
+ * The carrier has to be switched off while scanning, otherwise the noise floor is dominated by the
+ * own carrier and its phase noise.
+ *
+ */
+
+#ifndef CHANNEL_SCAN_LIB
+#define CHANNEL_SCAN_LIB
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#define SCAN_MAX_CARRIERS         8
+#define SCAN_MAX_OFFSETS          8
+#define SCAN_HIST_BINS           12
+#define SCAN_HIST_MIN_DBM      -110 // lower edge of the first histogram bin [dBm]
+#define SCAN_HIST_BIN_DB          5 // width of a histogram bin [dB]
+#define SCAN_BUSY_THRESHOLD     -85 // RSSI samples above this level are counted as occupied [dBm]
+#define SCAN_SETTLE_US          500 // time until the RSSI is valid after entering RX mode [us]
+
+/* subcarrier generated by the clock dividers of the backscatter state-machine */
+struct scan_offset {
+  uint16_t d0;
+  uint16_t d1;
+};
+
+struct scan_config {
+  const uint32_t *carriers;           // candidate carrier frequencies [Hz]
+  uint8_t n_carriers;
+  const struct scan_offset *offsets;  // candidate clock divider pairs
+  uint8_t n_offsets;
+  uint32_t window_us;                 // observation window per candidate [us]
+  uint32_t sample_interval_us;        // time between two RSSI samples [us]
+};
+
+struct scan_entry {
+  uint32_t f_carrier;                 // carrier frequency [Hz]
+  uint16_t d0;
+  uint16_t d1;
+  uint32_t center_offset;             // subcarrier center offset [Hz]
+  uint16_t samples;
+  uint16_t busy;                      // samples above SCAN_BUSY_THRESHOLD
+  int32_t  rssi_sum;
+  int16_t  rssi_max;
+  uint16_t hist[SCAN_HIST_BINS];
+};
+
+struct scan_table {
+  struct scan_entry entry[SCAN_MAX_CARRIERS*SCAN_MAX_OFFSETS];
+  uint8_t len;
+  uint8_t best;                       // index of the selected entry
+  uint64_t time_us;                   // time of the last scan
+};
+
+/* center offset [Hz] of the subcarrier generated with the clock dividers d0/d1 */
+uint32_t scan_center_offset(uint16_t d0, uint16_t d1);
+
+/* mean RSSI [dBm] of all samples of an entry */
+int32_t scan_noise_floor(struct scan_entry *entry);
+
+/*
+ * sweep all candidates and select the least occupied one (table->best)
+ * - the receiver has to be configured (deviation, datarate, filter bandwidth) and the carrier has to be off
+ * - the receiver is left in IDLE mode, the caller has to restart listening
+ */
+void channel_scan(struct scan_config *config, struct scan_table *table);
+
+/* print the scan table: all lines start with '#' to keep the log parsable */
+void print_scan_table(struct scan_table *table);
+
+/* lines of print_scan_table into line (size bytes, zero-terminated), returns their length:
+ * the header (two lines) and the line of entry i */
+#define SCAN_LINE_MAX 256
+int format_scan_header(char *line, size_t size, struct scan_table *table);
+int format_scan_entry(char *line, size_t size, struct scan_table *table, uint8_t i);
+
+#endif
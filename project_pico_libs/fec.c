@@ -0,0 +1,140 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Convolutional code, block interleaver and Viterbi decoder (see fec.h).
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "fec.h"
+
+#define FEC_G0         0x0D // 15 octal
+#define FEC_G1         0x0F // 17 octal
+#define FEC_STATES        8
+#define FEC_ROWS          8 // interleaver depth
+
+/*
+ * state: the last 3 input bits (newest at bit 0), register: state << 1 | input
+ * enc_table[state][nibble]: 8 coded bits of 4 input bits (MSB first), the next state is nibble & 7
+ * symbol_table[register]: 2 coded bits of one input bit
+ */
+static uint8_t enc_table[FEC_STATES][16];
+static uint8_t symbol_table[2*FEC_STATES];
+static bool tables_ready = false;
+
+static uint8_t parity4(uint8_t x){
+    x ^= x >> 2;
+    x ^= x >> 1;
+    return x & 1;
+}
+
+/* number of differing bits of two 2-bit symbols */
+static inline uint8_t symbol_distance(uint8_t a, uint8_t b){
+    uint8_t x = a ^ b;
+    return (x >> 1) + (x & 1);
+}
+
+static void fec_tables_init(){
+    for(uint8_t reg = 0; reg < 2*FEC_STATES; reg++){
+        symbol_table[reg] = (parity4(reg & FEC_G0) << 1) | parity4(reg & FEC_G1);
+    }
+    for(uint8_t state = 0; state < FEC_STATES; state++){
+        for(uint8_t nibble = 0; nibble < 16; nibble++){
+            uint8_t s = state, out = 0;
+            for(int8_t b = 3; b >= 0; b--){
+                uint8_t reg = (s << 1) | ((nibble >> b) & 1);
+                out = (out << 2) | symbol_table[reg];
+                s = reg & (FEC_STATES - 1);
+            }
+            enc_table[state][nibble] = out;
+        }
+    }
+    tables_ready = true;
+}
+
+static inline uint8_t get_bit(const uint8_t *buffer, uint16_t idx){
+    return (buffer[idx >> 3] >> (7 - (idx & 7))) & 1;
+}
+
+uint8_t fec_encode(const uint8_t *data, uint8_t len, uint8_t *coded){
+    if(!tables_ready){
+        fec_tables_init();
+    }
+    len = min(len, FEC_MAX_LEN);
+    uint8_t n = FEC_ENCODED_LEN(len);
+    uint8_t stream[FEC_ENCODED_LEN(FEC_MAX_LEN)];
+    uint8_t state = 0;
+    for(uint8_t i = 0; i < len; i++){
+        stream[2*i]     = enc_table[state][data[i] >> 4];
+        stream[2*i + 1] = enc_table[(data[i] >> 4) & 7][data[i] & 0x0F];
+        state = data[i] & 7;
+    }
+    stream[2*len] = enc_table[state][0]; // tail
+    // interleave: coded bit r*n + c is sent as bit r of byte c
+    memset(coded, 0, n);
+    for(uint8_t r = 0; r < FEC_ROWS; r++){
+        for(uint8_t c = 0; c < n; c++){
+            coded[c] |= get_bit(stream, r*n + c) << (7 - r);
+        }
+    }
+    return n;
+}
+
+uint16_t fec_decode(const uint8_t *coded, uint8_t len, uint8_t *data){
+    if(!tables_ready){
+        fec_tables_init();
+    }
+    len = min(len, FEC_MAX_LEN);
+    uint8_t n = FEC_ENCODED_LEN(len);
+    // de-interleave
+    uint8_t stream[FEC_ENCODED_LEN(FEC_MAX_LEN)];
+    memset(stream, 0, n);
+    for(uint8_t r = 0; r < FEC_ROWS; r++){
+        for(uint8_t c = 0; c < n; c++){
+            uint16_t idx = r*n + c;
+            stream[idx >> 3] |= ((coded[c] >> (7 - r)) & 1) << (7 - (idx & 7));
+        }
+    }
+
+    // Viterbi: path metrics and the decisions of each step (bit s: the survivor of state s comes from the upper predecessor)
+    uint16_t steps = 8*len + FEC_TAIL_BITS;
+    uint8_t decisions[8*FEC_MAX_LEN + FEC_TAIL_BITS];
+    uint16_t metric[FEC_STATES], next[FEC_STATES];
+    metric[0] = 0;
+    for(uint8_t s = 1; s < FEC_STATES; s++){
+        metric[s] = 0x3FFF; // the encoder starts in state 0
+    }
+    for(uint16_t t = 0; t < steps; t++){
+        uint8_t symbol = (stream[t >> 2] >> (6 - 2*(t & 3))) & 3;
+        uint8_t decision = 0;
+        for(uint8_t s = 0; s < FEC_STATES; s++){
+            // predecessors (s >> 1) and (s >> 1) | 4 with input bit s & 1
+            uint8_t lower = s >> 1, upper = lower | 4;
+            uint8_t reg_lower = (lower << 1) | (s & 1);
+            uint8_t reg_upper = reg_lower | 8;
+            uint16_t m_lower = metric[lower] + symbol_distance(symbol, symbol_table[reg_lower]);
+            uint16_t m_upper = metric[upper] + symbol_distance(symbol, symbol_table[reg_upper]);
+            if(m_upper < m_lower){
+                next[s] = m_upper;
+                decision |= 1 << s;
+            }else{
+                next[s] = m_lower;
+            }
+        }
+        decisions[t] = decision;
+        memcpy(metric, next, sizeof(metric));
+    }
+
+    // trace back from state 0 (terminated trellis)
+    memset(data, 0, len);
+    uint8_t state = 0;
+    for(int16_t t = steps - 1; t >= 0; t--){
+        if(t < 8*len){
+            data[t >> 3] |= (state & 1) << (7 - (t & 7));
+        }
+        state = (state >> 1) | (((decisions[t] >> state) & 1) << 2);
+    }
+    return metric[0];
+}
@@ -0,0 +1,44 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Forward error correction of the tag frames (similar to the FEC and interleaving option of the CC2500):
+ * - rate 1/2 convolutional code, constraint length 4 (generators 15 and 17 octal), terminated with 4 zero bits
+ * - block interleaver: the coded bits are written into 8 rows (row by row) and sent column by column,
+ *   thus a burst of up to 8 channel bit errors results in single bit errors spread over the trellis
+ * - hard decision Viterbi decoder (8 states)
+ *
+ * n data bytes are encoded into FEC_ENCODED_LEN(n) = 2n+1 bytes.
+ *
+ */
+
+#ifndef FEC_LIB
+#define FEC_LIB
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+
+#define FEC_ENCODED_LEN(n) (2*(n) + 1)
+#define FEC_MAX_LEN          30 // maximal number of data bytes (the encoded frame has to fit into the RX FIFO)
+#define FEC_TAIL_BITS         4 // zero bits terminating the trellis in state 0
+
+#ifndef MINMAX
+#define MINMAX
+#define max(x, y) (((x) > (y)) ? (x) : (y))
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+#endif
+
+/*
+ * encode and interleave len data bytes (len <= FEC_MAX_LEN)
+ * coded: FEC_ENCODED_LEN(len) bytes (must not overlap with data)
+ * returns the number of coded bytes
+ */
+uint8_t fec_encode(const uint8_t *data, uint8_t len, uint8_t *coded);
+
+/*
+ * de-interleave and decode FEC_ENCODED_LEN(len) coded bytes into len data bytes (len <= FEC_MAX_LEN)
+ * returns the number of coded bits which differ from the decoded path (corrected bit errors)
+ */
+uint16_t fec_decode(const uint8_t *coded, uint8_t len, uint8_t *data);
+
+#endif
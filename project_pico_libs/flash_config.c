@@ -0,0 +1,77 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Last known-good configuration in flash (see flash_config.h).
+ *
+ */
+
+#include <stddef.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "hardware/flash.h"
+#include "hardware/sync.h"
+#include "flash_config.h"
+
+#define FLASH_CONFIG_PAGES ((sizeof(struct flash_config) + FLASH_PAGE_SIZE - 1)/FLASH_PAGE_SIZE)
+
+// CRC-32 (IEEE 802.3, reflected)
+static uint32_t crc32(const uint8_t *data, size_t len){
+    uint32_t crc = 0xFFFFFFFF;
+    for (size_t i = 0; i < len; i++){
+        crc ^= data[i];
+        for (uint8_t b = 0; b < 8; b++){
+            crc = (crc >> 1) ^ (0xEDB88320 & (0 - (crc & 1)));
+        }
+    }
+    return ~crc;
+}
+
+uint32_t flash_config_build(const char *stamp){
+    return crc32((const uint8_t *) stamp, strlen(stamp));
+}
+
+bool flash_config_load(struct flash_config *record, uint32_t build){
+    memcpy(record, (const void *) (XIP_BASE + FLASH_CONFIG_OFFSET), sizeof(struct flash_config));
+    return record->magic == FLASH_CONFIG_MAGIC && record->version == FLASH_CONFIG_VERSION && record->size == sizeof(struct flash_config)
+           && record->build == build && record->crc == crc32((const uint8_t *) record, offsetof(struct flash_config, crc));
+}
+
+// clear the calibration and the CRC (compared by flash_config_differs)
+static void strip(struct flash_config *record){
+    memset(&record->carrier[CC2500_FSCAL3], 0, CC2500_FSCAL0 - CC2500_FSCAL3 + 1);
+    for (uint8_t r = 0; r < MAX_RECEIVERS; r++){
+        memset(&record->receivers[r][CC2500_FSCAL3], 0, CC2500_FSCAL0 - CC2500_FSCAL3 + 1);
+    }
+    record->crc = 0;
+}
+
+bool flash_config_differs(const struct flash_config *a, const struct flash_config *b){
+    static struct flash_config x, y;
+    x = *a;
+    y = *b;
+    strip(&x);
+    strip(&y);
+    return memcmp(&x, &y, sizeof(struct flash_config)) != 0;
+}
+
+void flash_config_save(struct flash_config *record, bool core1){
+    static uint8_t pages[FLASH_CONFIG_PAGES*FLASH_PAGE_SIZE];
+    record->magic = FLASH_CONFIG_MAGIC;
+    record->version = FLASH_CONFIG_VERSION;
+    record->size = sizeof(struct flash_config);
+    record->crc = crc32((const uint8_t *) record, offsetof(struct flash_config, crc));
+    memset(pages, 0xFF, sizeof(pages));
+    memcpy(pages, record, sizeof(struct flash_config));
+    // the flash is not readable while it is written: no code may run from it (core 1, interrupts)
+    if (core1){
+        multicore_lockout_start_blocking();
+    }
+    uint32_t interrupts = save_and_disable_interrupts();
+    flash_range_erase(FLASH_CONFIG_OFFSET, FLASH_SECTOR_SIZE);
+    flash_range_program(FLASH_CONFIG_OFFSET, pages, sizeof(pages));
+    restore_interrupts(interrupts);
+    if (core1){
+        multicore_lockout_end_blocking();
+    }
+}
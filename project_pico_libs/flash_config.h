@@ -0,0 +1,66 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Last known-good configuration in the last sector of the flash (fast boot): the tag setting and the image of its
+ * PIO program (instructions and loop counts, see backscatter_program_restore), the carrier frequency and the register
+ * images of the carrier and receiver CC2500s including their calibration (FSCAL3..FSCAL0). Restoring the record
+ * replaces the full setup: no program generation (floating point), no register tables with fixed delays, no calibration
+ * and no channel scan.
+ *
+ * A record is valid if magic, version, size, build and CRC-32 match. The build identifies the firmware that wrote it
+ * (flash_config_build of BUILD_STAMP of main.c, a hash of the sources set by CMakeLists.txt): after flashing a build of
+ * other sources, the record is ignored, while rebuilding the same sources keeps it valid.
+ * Writing erases the sector (tens of ms with the interrupts disabled, core 1 is paused if requested), hence a record
+ * is only written if it differs from the stored one (flash_config_differs, the calibration is not compared).
+ *
+ */
+
+#ifndef FLASH_CONFIG_LIB
+#define FLASH_CONFIG_LIB
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/flash.h"
+#include "backscatter.h"
+#include "receiver_CC2500.h"
+#include "cc2500_regs.h"
+
+#define FLASH_CONFIG_MAGIC    0x46434642 // "BFCF"
+#define FLASH_CONFIG_VERSION           2
+#define FLASH_CONFIG_OFFSET   (PICO_FLASH_SIZE_BYTES - FLASH_SECTOR_SIZE) // last sector of the flash
+
+struct flash_config {
+  uint32_t magic;
+  uint16_t version;
+  uint16_t size;                 // sizeof(struct flash_config)
+  uint32_t build;                // firmware which wrote the record (flash_config_build)
+  /* tag */
+  uint16_t d0;
+  uint16_t d1;
+  uint32_t baud;                 // requested baud-rate
+  bool     two_antennas;
+  bool     fec;
+  struct backscatter_image program;
+  /* radios */
+  uint32_t f_carrier;            // [Hz]
+  uint8_t  carrier[CC2500_IMAGE_LEN];
+  uint8_t  n_receivers;
+  uint8_t  receivers[MAX_RECEIVERS][CC2500_IMAGE_LEN];
+  uint8_t  salvage_len[MAX_RECEIVERS]; // salvage mode of the receivers (get_salvage_length_rx)
+  uint32_t crc;                  // CRC-32 of all bytes before
+};
+
+/* identifier of a build (CRC-32 of a string, e.g. a hash of the sources) */
+uint32_t flash_config_build(const char *stamp);
+
+/* copy the stored record into record, returns false if it is not valid or was written by another build */
+bool flash_config_load(struct flash_config *record, uint32_t build);
+
+/* true if the records differ in more than the calibration of the radios (the padding has to be zero: memset the records) */
+bool flash_config_differs(const struct flash_config *a, const struct flash_config *b);
+
+/* complete the header and CRC of record and write it (core1: pause core 1 while the flash is not readable) */
+void flash_config_save(struct flash_config *record, bool core1);
+
+#endif
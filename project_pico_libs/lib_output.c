@@ -0,0 +1,26 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Text output of the libraries (see lib_output.h).
+ *
+ */
+
+#include <stdio.h>
+#include "lib_output.h"
+
+static lib_output_t redirect = NULL;
+
+void lib_output_redirect(lib_output_t output){
+    redirect = output;
+}
+
+void lib_printf(const char *format, ...){
+    va_list args;
+    va_start(args, format);
+    if (redirect != NULL){
+        redirect(format, args);
+    } else {
+        vprintf(format, args);
+    }
+    va_end(args);
+}
@@ -0,0 +1,28 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Text output of the libraries: register settings, warnings of the program generation, the loopback
+ * self-test and the trace dump.
+ *
+ * lib_printf() prints with printf by default. An application can redirect the output, e.g. to the
+ * logger of core 1 (usb_logger.h), such that reconfiguring the radios from the RX loop does not wait
+ * for the stdio lock.
+ *
+ */
+
+#ifndef LIB_OUTPUT_LIB
+#define LIB_OUTPUT_LIB
+
+#include <stdarg.h>
+#include <stdbool.h>
+
+/* output function of the redirection (vprintf format), returns false if the text was dropped */
+typedef bool (*lib_output_t)(const char *format, va_list args);
+
+/* redirect the output of lib_printf (NULL: printf) */
+void lib_output_redirect(lib_output_t output);
+
+/* printf of the libraries */
+void lib_printf(const char *format, ...);
+
+#endif
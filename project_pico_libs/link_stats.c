@@ -0,0 +1,65 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Link statistics of received packets (packet error rate, CRC pass rate, RSSI and link quality).
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "receiver_CC2500.h"
+#include "link_stats.h"
+
+void link_stats_reset(struct link_stats *stats){
+    memset(stats, 0, sizeof(struct link_stats));
+    stats->rssi_min = 0;
+    stats->rssi_max = -128;
+    stats->start_us = to_us_since_boot(get_absolute_time());
+}
+
+void link_stats_update(struct link_stats *stats, Packet_status *status){
+    stats->received++;
+    if(status->overflowed){
+        stats->overflowed++;
+        return;
+    }
+    uint32_t valid = stats->received - stats->overflowed;
+    stats->crc_pass += status->CRCcheck;
+    stats->rssi_sum += status->RSSI;
+    stats->rssi_min  = (valid == 1) ? status->RSSI : min(stats->rssi_min, status->RSSI);
+    stats->rssi_max  = max(stats->rssi_max, status->RSSI);
+    stats->lqi_sum  += status->LinkQualityIndicator;
+    if(status->CRCcheck && status->len >= 2){
+        stats->delivered += status->len - 2;
+    }
+}
+
+uint32_t link_stats_per(struct link_stats *stats, uint32_t sent){
+    uint32_t lost = (sent > stats->received) ? sent - stats->received : 0;
+    return (10000*(lost + stats->received - stats->crc_pass))/max(1, sent);
+}
+
+uint32_t link_stats_crc_pass(struct link_stats *stats){
+    return (10000*stats->crc_pass)/max(1, stats->received);
+}
+
+uint32_t link_stats_goodput(struct link_stats *stats){
+    uint64_t elapsed_us = max(1, to_us_since_boot(get_absolute_time()) - stats->start_us);
+    return (uint32_t) ((((uint64_t) stats->delivered)*8*1000000)/elapsed_us);
+}
+
+void print_link_stats(const char *name, struct link_stats *stats, uint32_t sent){
+    char line[LINK_STATS_LINE_MAX];
+    format_link_stats(line, sizeof(line), name, stats, sent);
+    printf("%s", line);
+}
+
+int format_link_stats(char *line, size_t size, const char *name, struct link_stats *stats, uint32_t sent){
+    uint32_t valid  = max(1, stats->received - stats->overflowed);
+    uint32_t per    = link_stats_per(stats, sent);
+    uint32_t passed = link_stats_crc_pass(stats);
+    return snprintf(line, size, "# %s: sent %u received %u overflow %u PER %u.%02u%% CRC pass %u.%02u%% RSSI mean %d min %d max %d LQI mean %u selected %u goodput %u bit/s\n",
+           name, sent, stats->received, stats->overflowed, per/100, per%100, passed/100, passed%100,
+           stats->rssi_sum/((int32_t) valid), stats->rssi_min, stats->rssi_max, stats->lqi_sum/valid, stats->selected, link_stats_goodput(stats));
+}
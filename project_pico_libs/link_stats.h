@@ -0,0 +1,53 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Link statistics of received packets (packet error rate, CRC pass rate, RSSI and link quality).
+ *
+ * The statistics are printed as log lines starting with '#' (without '|'),
+ * such that the log remains parsable by the stats scripts.
+ *
+ */
+
+#ifndef LINK_STATS_LIB
+#define LINK_STATS_LIB
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "receiver_CC2500.h"
+
+struct link_stats {
+  uint32_t received;      // number of received packets (including overflows)
+  uint32_t overflowed;    // packets with corrupted length field
+  uint32_t crc_pass;
+  int32_t  rssi_sum;
+  int32_t  rssi_min;
+  int32_t  rssi_max;
+  uint32_t lqi_sum;
+  uint32_t selected;      // selection diversity: how often this copy has been chosen
+  uint32_t delivered;     // payload bytes of packets passing the CRC (excluding length and seq)
+  uint64_t start_us;      // time of the last reset (goodput)
+};
+
+void link_stats_reset(struct link_stats *stats);
+
+void link_stats_update(struct link_stats *stats, Packet_status *status);
+
+/* packet error rate [0.01%]: lost packets and packets failing the CRC out of sent packets */
+uint32_t link_stats_per(struct link_stats *stats, uint32_t sent);
+
+/* CRC pass rate [0.01%] of the received packets */
+uint32_t link_stats_crc_pass(struct link_stats *stats);
+
+/* goodput [bit/s]: payload of packets passing the CRC since the last reset */
+uint32_t link_stats_goodput(struct link_stats *stats);
+
+/* print one summary line, sent: number of transmitted packets (to derive the packet error rate)
+ * the goodput is derived from the delivered payload bytes since the last reset */
+void print_link_stats(const char *name, struct link_stats *stats, uint32_t sent);
+
+/* summary line of print_link_stats into line (size bytes, zero-terminated), returns its length */
+#define LINK_STATS_LINE_MAX 256
+int format_link_stats(char *line, size_t size, const char *name, struct link_stats *stats, uint32_t sent);
+
+#endif
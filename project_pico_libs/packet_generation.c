@@ -11,8 +11,7 @@
 #include "pico/stdlib.h"
 #include "packet_generation.h"
 
-#define DEFAULT_SEED 0xABCD
-uint32_t seed = DEFAULT_SEED;
+struct data_generator file_generator = {.seed = DEFAULT_SEED, .file_position = 0, .initial_seed = DEFAULT_SEED};
 
 uint8_t packet_hdr_2500[HEADER_LEN] = {0xaa, 0xaa, 0xaa, 0xaa, 0xd3, 0x91, 0xd3, 0x91, 0x00, 0x00};    // CC2500, the last two byte one for the payload length. and another is seq number
 uint8_t packet_hdr_1352[HEADER_LEN] = {0xaa, 0xaa, 0xaa, 0xaa, 0x93, 0x0b, 0x51, 0xde, 0x00, 0x00};    // CC1352P7, the last two byte one for the payload length. and another is seq number
@@ -30,58 +29,116 @@ uint8_t *packet_hdr_template(uint16_t receiver){
     }
 }
 
+void generator_init(struct data_generator *gen, uint32_t initial_seed){
+    gen->initial_seed = initial_seed;
+    generator_reset(gen);
+}
+
+/* restart the file at position 0 */
+void generator_reset(struct data_generator *gen){
+    gen->seed = gen->initial_seed;
+    gen->file_position = 0;
+}
+
 /* 
  * generate of a uniform random number.
  */
-uint32_t rnd() {
+uint32_t generator_rnd(struct data_generator *gen) {
     const uint32_t A1 = 1664525;
     const uint32_t C1 = 1013904223;
     const uint32_t RAND_MAX1 = 0xFFFFFFFF;
-    seed = ((seed * A1 + C1) & RAND_MAX1);
-    return seed;
+    gen->seed = ((gen->seed * A1 + C1) & RAND_MAX1);
+    return gen->seed;
+}
+
+uint32_t rnd() {
+    return generator_rnd(&file_generator);
+}
+
+struct lcg_jump lcg_jump_ahead(uint64_t n){
+    struct lcg_jump jump = {.a = 1, .c = 0};       // identity
+    struct lcg_jump step = {.a = 1664525, .c = 1013904223}; // one step of generator_rnd()
+    while (n > 0) {
+        if (n & 1) {
+            // the maps are powers of the same map and commute: jump = step o jump
+            jump.c = step.a*jump.c + step.c;
+            jump.a = step.a*jump.a;
+        }
+        // step = step o step
+        step.c = step.a*step.c + step.c;
+        step.a = step.a*step.a;
+        n >>= 1;
+    }
+    return jump;
+}
+
+uint32_t lcg_advance(uint32_t seed, uint64_t n){
+    struct lcg_jump jump = lcg_jump_ahead(n);
+    return jump.a*seed + jump.c;
+}
+
+/*
+ * move the generator to the given file position
+ * each sample consumes two random numbers and the seed restarts at position 0: the seed at a position is the initial
+ * seed advanced by file_position steps (jump-ahead, at most 16 squarings)
+ */
+bool generator_seek(struct data_generator *gen, uint16_t file_position){
+    if (file_position % 2 != 0) {
+        return false;
+    }
+    gen->seed = lcg_advance(gen->initial_seed, file_position);
+    gen->file_position = file_position;
+    return true;
 }
 
 /* 
  * generate compressible payload sample
  * file_position provides the index of the next data byte (increments by 2 each time the function is called)
  */
-uint16_t file_position = 0;
-uint16_t generate_sample(){
-    if (file_position == 0) {
-        seed = DEFAULT_SEED; /* reset seed when exceeding uint16_t max */
+uint16_t generator_sample(struct data_generator *gen){
+    if (gen->file_position == 0) {
+        gen->seed = gen->initial_seed; /* reset seed when exceeding uint16_t max */
     }
-    file_position = file_position + 2;
+    gen->file_position = gen->file_position + 2;
     double two_pi = 2.0 * M_PI;
     double u1, u2;
-    u1 = ((double) rnd())/ ((double) 0xFFFFFFFF);
-    u2 = ((double) rnd())/((double) 0xFFFFFFFF);
+    u1 = ((double) generator_rnd(gen))/ ((double) 0xFFFFFFFF);
+    u2 = ((double) generator_rnd(gen))/((double) 0xFFFFFFFF);
     double tmp = ((double) 0x7FF) * sqrt(-2.0 * log(u1));
     return max(0.0,min(((double) 0x3FFFFF),tmp * cos(two_pi * u2) + ((double) 0x1FFF)));
 }
 
+uint16_t generate_sample(){
+    return generator_sample(&file_generator);
+}
+
 /*
  * fill packet with 16-bit samples
  * include_index: shall the file index be included at the first two byte?
  * length: the length of the buffer which can be filled with data
 */
-void generate_data(uint8_t *buffer, uint8_t length, bool include_index) {
+void generator_data(struct data_generator *gen, uint8_t *buffer, uint8_t length, bool include_index) {
     if(length % 2 != 0){
         printf("WARNING: generate_data has been used with an odd length.");
     }
 
     uint8_t data_start = 0;
     if(include_index){
-        buffer[0]   = (uint8_t) (file_position >> 8);
-        buffer[1] = (uint8_t) (file_position & 0x00FF);
+        buffer[0]   = (uint8_t) (gen->file_position >> 8);
+        buffer[1] = (uint8_t) (gen->file_position & 0x00FF);
         data_start = 2;
     }
     for (uint8_t i=data_start; i < length; i=i+2) {
-        uint16_t sample = generate_sample();
+        uint16_t sample = generator_sample(gen);
         buffer[i]   = (uint8_t) (sample >> 8);
         buffer[i+1] = (uint8_t) (sample & 0x00FF);
     }
 }
 
+void generate_data(uint8_t *buffer, uint8_t length, bool include_index) {
+    generator_data(&file_generator, buffer, length, include_index);
+}
+
 /* including a header to the packet:
  * - 8B header sequence
  * - 1B payload length
@@ -102,3 +159,76 @@ void add_header(uint8_t *packet, uint8_t seq, uint8_t *header_template) {
     packet[HEADER_LEN-1] = seq;
 }
 
+/* number of header bytes for the given frame format */
+uint8_t header_len_format(struct frame_format *format) {
+    return format->preamble_len + format->sync_len + (format->fixed_length ? 0 : 1) + 1;
+}
+
+/* including a header with the given frame format to the packet:
+ * packet: buffer to be updated with the header
+ * seq: sequence number of the packet
+ * header_template: obtained using packet_hdr_template()
+ * format: preamble length, sync word length and length mode
+ * payload_len: number of payload bytes following the header
+ */
+uint8_t add_header_format(uint8_t *packet, uint8_t seq, uint8_t *header_template, struct frame_format *format, uint8_t payload_len) {
+    uint8_t pos = 0;
+    /* fill in the preamble */
+    for(uint8_t i = 0; i < format->preamble_len; i++) {
+        packet[pos++] = header_template[0];
+    }
+    /* fill in the (last sync_len bytes of the) sync word */
+    for(uint8_t i = HEADER_LEN-2-format->sync_len; i < HEADER_LEN-2; i++) {
+        packet[pos++] = header_template[i];
+    }
+    /* add the payload length */
+    if(!format->fixed_length) {
+        packet[pos++] = 1 + payload_len; // payload data including seq, excluding the length byte and the optional CRC
+    }
+    /* add the packet as sequence number. */
+    packet[pos++] = seq;
+    return pos;
+}
+
+/*
+ * CRC-16 as computed by the CC2500/CC1101 (polynomial 0x8005, initial value 0xFFFF)
+ */
+uint16_t crc16_cc2500(uint8_t *data, uint8_t len) {
+    uint16_t crc = 0xFFFF;
+    for(uint8_t i = 0; i < len; i++) {
+        uint8_t byte = data[i];
+        for(uint8_t bit = 0; bit < 8; bit++) {
+            if(((crc & 0x8000) >> 8) ^ (byte & 0x80)) {
+                crc = (crc << 1) ^ 0x8005;
+            }else{
+                crc = (crc << 1);
+            }
+            byte = byte << 1;
+        }
+    }
+    return crc;
+}
+
+/* appending the CRC to the packet:
+ * packet: pointer to the length byte
+ * len: number of bytes covered by the CRC (length byte, sequence number and payload)
+ */
+void add_crc(uint8_t *packet, uint8_t len) {
+    uint16_t crc = crc16_cc2500(packet, len);
+    packet[len]   = (uint8_t) (crc >> 8);
+    packet[len+1] = (uint8_t) (crc & 0x00FF);
+}
+
+void add_tx_timestamp(uint8_t *packet, uint32_t time_us) {
+    for (uint8_t i = 0; i < TX_TIMESTAMP_LEN; i++) {
+        packet[i] = (uint8_t) (time_us >> (8*(TX_TIMESTAMP_LEN - 1 - i)));
+    }
+}
+
+uint32_t read_tx_timestamp(const uint8_t *packet) {
+    uint32_t time_us = 0;
+    for (uint8_t i = 0; i < TX_TIMESTAMP_LEN; i++) {
+        time_us = (time_us << 8) | packet[i];
+    }
+    return time_us;
+}
@@ -16,6 +16,10 @@
 
 #define PAYLOADSIZE 14
 #define HEADER_LEN  10 // 8 header + length + seq
+#define CRC_LEN      2
+#define TX_TIMESTAMP_LEN 4 // trailer with the TX start time [us since boot, lower 32 bit]
+#define DEFAULT_SEED 0xABCD
+#define FILE_PERIOD  65536 // the file repeats when the 16-bit file position wraps
 #define buffer_size(x, y) (((x + y) % 4 == 0) ? ((x + y) / 4) : ((x + y) / 4 + 1)) // define the buffer size with ceil((PAYLOADSIZE+HEADER_LEN)/4)
 
 #ifndef MINMAX
@@ -24,22 +28,77 @@
 #define min(x, y) (((x) < (y)) ? (x) : (y))
 #endif
 
+/*
+ * frame format (the default format corresponds to add_header: 4B preamble, 4B sync, length and seq)
+ * - preamble_len: number of preamble bytes (0xaa)
+ * - sync_len: 2 (16-bit sync word) or 4 (32-bit sync word), the last sync_len bytes of the template are used
+ * - fixed_length: no length byte, the frame size has to be configured at the receiver
+ */
+struct frame_format {
+  uint8_t preamble_len;
+  uint8_t sync_len;
+  bool fixed_length;
+};
+#define DEFAULT_FRAME_FORMAT {.preamble_len = 4, .sync_len = 4, .fixed_length = false}
+
 /*
  * obtain the packet header template for the corresponding radio
  */
 uint8_t *packet_hdr_template(uint16_t receiver);
 
+/*
+ * state of the payload generator
+ * - seed: state of the uniform random number generator
+ * - file_position: index of the next data byte (the seed is reset to initial_seed when it wraps to 0)
+ * the transmitted file is deterministic: a second generator can replay it to compare received data
+ */
+struct data_generator {
+  uint32_t seed;
+  uint16_t file_position;
+  uint32_t initial_seed;
+};
+
+/* generator used by rnd(), generate_sample() and generate_data() */
+extern struct data_generator file_generator;
+
+/* setup a generator for the file with the given initial seed (DEFAULT_SEED for the transmitted file) */
+void generator_init(struct data_generator *gen, uint32_t initial_seed);
+
+/* restart the file at position 0 */
+void generator_reset(struct data_generator *gen);
+
+/*
+ * jump-ahead of the LCG of generator_rnd(): n steps are the affine map seed -> a*seed + c (mod 2^32),
+ * computed by squaring the map of one step (O(log n) multiplications instead of n steps)
+ */
+struct lcg_jump {
+  uint32_t a;
+  uint32_t c;
+};
+struct lcg_jump lcg_jump_ahead(uint64_t n);
+
+/* seed after n steps of generator_rnd() */
+uint32_t lcg_advance(uint32_t seed, uint64_t n);
+
+/*
+ * move the generator to the given file position (even, the next sample starts at this position)
+ * in O(log n) for any position (lcg_jump_ahead), e.g. to generate parts of the file independently
+ * returns false for odd positions (not the start of a sample)
+ */
+bool generator_seek(struct data_generator *gen, uint16_t file_position);
+
 /* 
  * generate of a uniform random number.
  */
 uint32_t rnd();
+uint32_t generator_rnd(struct data_generator *gen);
 
 /* 
  * generate compressible payload sample
  * file_position provides the index of the next data byte (increments by 2 each time the function is called)
  */
-extern uint16_t file_position;
 uint16_t generate_sample();
+uint16_t generator_sample(struct data_generator *gen);
 
 /*
  * fill packet with 16-bit samples
@@ -47,6 +106,7 @@ uint16_t generate_sample();
  * length: the length of the buffer which can be filled with data
 */
 void generate_data(uint8_t *buffer, uint8_t length, bool include_index);
+void generator_data(struct data_generator *gen, uint8_t *buffer, uint8_t length, bool include_index);
 
 
 /* including a header to the packet:
@@ -59,4 +119,37 @@ void generate_data(uint8_t *buffer, uint8_t length, bool include_index);
  */
 void add_header(uint8_t *packet, uint8_t seq, uint8_t *header_template);
 
+/* including a header with the given frame format to the packet:
+ * - preamble_len x 0xaa, sync_len bytes sync word
+ * - 1B payload length (only if !fixed_length)
+ * - 1B sequence number
+ *
+ * returns the header length (the payload starts at packet[header length])
+ */
+uint8_t add_header_format(uint8_t *packet, uint8_t seq, uint8_t *header_template, struct frame_format *format, uint8_t payload_len);
+
+/* number of header bytes for the given frame format */
+uint8_t header_len_format(struct frame_format *format);
+
+/*
+ * CRC-16 as computed by the CC2500/CC1101 (polynomial 0x8005, initial value 0xFFFF)
+ */
+uint16_t crc16_cc2500(uint8_t *data, uint8_t len);
+
+/* appending the CRC to the packet:
+ * - the CRC covers the length byte, sequence number and payload
+ * - packet: pointer to the length byte, len: number of bytes covered by the CRC
+ * - the CRC is written to packet[len] and packet[len+1] (MSB first)
+ */
+void add_crc(uint8_t *packet, uint8_t len);
+
+/* TX timestamp trailer (after the payload, before the CRC):
+ * - time_us: lower 32 bit of the time at which the frame was assembled (MSB first)
+ * - the one-way latency of a received frame is (uint32_t) (rx_time_us - read_tx_timestamp(trailer))
+ *   if tag and receiver share one timer (carrier-receiver-baseband)
+ */
+void add_tx_timestamp(uint8_t *packet, uint32_t time_us);
+
+uint32_t read_tx_timestamp(const uint8_t *packet);
+
 #endif
\ No newline at end of file
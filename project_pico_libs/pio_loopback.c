@@ -0,0 +1,221 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * On-chip self-test of the backscatter state-machine (see pio_loopback.h).
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "hardware/dma.h"
+#include "pio_loopback.h"
+#include "lib_output.h"
+
+#define F_PIO  ((uint32_t) CLKFREQ*1000000)
+#define ASM_IN 0x4000 // IN pins (bit count in the lowest 5 bits)
+
+/* runs of both symbols and alternating symbols */
+static const uint32_t loopback_message[LOOPBACK_MESSAGE_WORDS] = {0xF0F0CCAA, 0x5533FF00};
+
+/* rising edges of PIN_TX1 produced by generatePIOprogram() for a message */
+struct model {
+  const uint32_t *message;
+  uint16_t symbols;
+  uint16_t d0, d1;
+  uint32_t cycles;   // symbol length
+  uint16_t k;        // current symbol
+  uint32_t j;        // current period of the symbol (n: remaining period)
+  bool     level;    // PIN_TX1 at the start of symbol k
+};
+
+struct model_edge {
+  uint32_t t;        // [cycles] after the start of the message
+  uint16_t k;        // symbol
+  uint16_t d;        // period of the symbol
+  bool     full;     // the next edge follows after one full period
+};
+
+/* symbol: out, jmp !x, mov (3 cycles), n full periods (d/2 high, d/2 - 1 low, jmp), remaining period (high, low), jmp */
+static bool model_next(struct model *m, struct model_edge *edge){
+    while (m->k < m->symbols){
+        bool bit = (m->message[m->k/32] >> (31 - m->k%32)) & 1;
+        uint16_t d = bit ? m->d1 : m->d0;
+        uint32_t n = (m->cycles - 4)/d;
+        uint32_t rem = (m->cycles - 4)%d;
+        uint32_t high = min(rem, (uint32_t) d/2);
+        uint32_t start = m->k*m->cycles + 3;
+        if (m->j == 0 && m->level){
+            m->j = 1; // the pin is still high: no edge at the first period
+        }
+        if (m->j <= n && (m->j < n || high > 0)){
+            edge->t = start + m->j*d;
+            edge->k = m->k;
+            edge->d = d;
+            edge->full = (m->j + 1 < n) || (m->j + 1 == n && high > 0);
+            m->j++;
+            return true;
+        }
+        m->level = (high > 0) && (rem == high);
+        m->k++;
+        m->j = 0;
+    }
+    return false;
+}
+
+static inline bool sample(const uint32_t *capture, uint32_t i){
+    return (capture[i/32] >> (31 - i%32)) & 1; // autopush with left shift: the first sample is the MSB
+}
+
+/* next rising edge after sample *pos, *pos is set to the sample of the edge */
+static bool next_edge(const uint32_t *capture, uint32_t samples, uint32_t *pos){
+    for (uint32_t i = *pos + 1; i < samples; i++){
+        if (sample(capture, i) && !sample(capture, i - 1)){
+            *pos = i;
+            return true;
+        }
+    }
+    *pos = samples;
+    return false;
+}
+
+static inline uint32_t distance(uint32_t a, uint32_t b){
+    return (a > b) ? a - b : b - a;
+}
+
+bool loopback_analyze(const uint32_t *pin1, const uint32_t *pin2, uint32_t words, uint16_t div, const uint32_t *message, uint16_t symbols,
+                      uint16_t d0, uint16_t d1, uint32_t symbol_cycles, enum antenna_phase phase, struct loopback_result *result){
+    memset(result, 0, sizeof(*result));
+    result->div = div;
+    result->symbol_cycles = symbol_cycles;
+    result->f0_expected = F_PIO/d0;
+    result->f1_expected = F_PIO/d1;
+    result->pin2 = (pin2 != NULL);
+    uint32_t samples = 32*words;
+    struct model m = {.message = message, .symbols = symbols, .d0 = d0, .d1 = d1, .cycles = symbol_cycles, .k = 0, .j = 0, .level = sample(pin1, 0)};
+    struct model_edge e, e0 = {0}, e_prev = {0};
+    uint32_t pos = 0, pos2 = 0;
+    uint32_t r = 0, r0 = 0, r_prev = 0;
+    bool edge2 = (pin2 != NULL) && next_edge(pin2, samples, &pos2);
+    uint64_t period_sum[2] = {0, 0};
+    uint32_t period_n[2] = {0, 0};
+    int64_t phase_sum = 0;
+    uint32_t phase_n = 0;
+    result->symbols = symbols;
+    while (model_next(&m, &e)){
+        if (result->edges > 0 && r0 + (e.t - e0.t) >= samples*div){
+            result->symbols = e.k; // the rest of the message is beyond the capture
+            break;
+        }
+        result->expected_edges++;
+        if (!next_edge(pin1, samples, &pos)){
+            continue; // missing edge
+        }
+        r = pos*div;
+        if (result->edges == 0){
+            r0 = r;
+            e0 = e;
+        } else {
+            if (e_prev.full){
+                // full period of the previous edge: frequency and phase of PIN_TX2
+                period_sum[e_prev.d == d1] += r - r_prev;
+                period_n[e_prev.d == d1]++;
+            }
+            while (edge2 && pos2*div < r){
+                uint32_t r2 = pos2*div;
+                if (e_prev.full && r2 >= r_prev){
+                    uint32_t expected = (phase == PHASE_INVERTED) ? e_prev.d/2 : ((phase == PHASE_QUARTER) ? e_prev.d/4 : 0);
+                    result->pin2_error = max(result->pin2_error, distance(r2 - r_prev, expected));
+                    phase_sum += ((int64_t) (r2 - r_prev))*360/(r - r_prev);
+                    phase_n++;
+                }
+                result->pin2_edges++;
+                edge2 = next_edge(pin2, samples, &pos2);
+            }
+        }
+        result->max_error = max(result->max_error, distance(r - r0, e.t - e0.t));
+        result->edges++;
+        e_prev = e;
+        r_prev = r;
+    }
+    // edges which are not part of the message
+    bool extra = (result->edges == result->expected_edges) && next_edge(pin1, samples, &pos);
+    while (edge2){
+        result->pin2_edges++;
+        edge2 = next_edge(pin2, samples, &pos2);
+    }
+    for (uint8_t b = 0; b < 2; b++){
+        uint32_t f = period_sum[b] ? (uint32_t) (((uint64_t) F_PIO)*period_n[b]/period_sum[b]) : 0;
+        if (b){
+            result->f1 = f;
+        } else {
+            result->f0 = f;
+        }
+    }
+    if (result->edges > 1 && e_prev.t > e0.t){
+        uint32_t span = e_prev.t - e0.t;
+        result->symbol_mcycles = (uint32_t) (((uint64_t) symbol_cycles)*1000*(r_prev - r0)/span);
+        result->drift_ppm = (int32_t) ((((int64_t) (r_prev - r0)) - span)*1000000/span);
+    }
+    result->pin2_phase = phase_n ? (int32_t) (phase_sum/phase_n) : 0;
+    result->pass = result->edges > 1 && result->edges == result->expected_edges && !extra && result->max_error <= div;
+    if (pin2 != NULL){
+        if (phase == PHASE_SINGLE){
+            result->pass &= (result->pin2_edges == 0);
+        } else {
+            result->pass &= (phase_n > 0) && (result->pin2_error <= div);
+        }
+    }
+    return result->pass;
+}
+
+bool loopback_selftest(PIO pio, uint sm, uint pin1, uint pin2, bool twoAntennas, uint16_t d0, uint16_t d1, const struct backscatter_config *config, struct loopback_result *result){
+    static uint32_t capture[2][LOOPBACK_WORDS];
+    static const uint16_t sampler[1] = {ASM_IN | 1}; // in pins, 1 (wraps onto itself)
+    uint32_t symbol_cycles = F_PIO/config->baudrate;
+    // sampling step: the whole message, but at least four samples per period (long symbols are captured in part)
+    uint16_t div = (uint16_t) min((LOOPBACK_SYMBOLS + 2)*symbol_cycles/(32*LOOPBACK_WORDS) + 1, max(1, min(d0, d1)/4));
+    uint8_t n = twoAntennas ? 2 : 1;
+    struct pio_program program = {.instructions = sampler, .length = 1, .origin = -1};
+    pio_clear_instruction_memory(LOOPBACK_PIO);
+    pio_add_program_at_offset(LOOPBACK_PIO, &program, 0);
+    int channel[2];
+    for (uint8_t s = 0; s < n; s++){
+        pio_sm_config c = pio_get_default_sm_config();
+        sm_config_set_wrap(&c, 0, 0);
+        sm_config_set_in_pins(&c, (s == 0) ? pin1 : pin2);
+        sm_config_set_in_shift(&c, false, true, 32);     // shift left, autopush after 32 samples
+        sm_config_set_fifo_join(&c, PIO_FIFO_JOIN_RX);   // 8-deep RX FIFO
+        sm_config_set_clkdiv_int_frac(&c, div, 0);
+        pio_sm_init(LOOPBACK_PIO, s, 0, &c);
+        channel[s] = dma_claim_unused_channel(true);
+        dma_channel_config dc = dma_channel_get_default_config(channel[s]);
+        channel_config_set_transfer_data_size(&dc, DMA_SIZE_32);
+        channel_config_set_read_increment(&dc, false);
+        channel_config_set_write_increment(&dc, true);
+        channel_config_set_dreq(&dc, pio_get_dreq(LOOPBACK_PIO, s, false));
+        dma_channel_configure(channel[s], &dc, capture[s], &LOOPBACK_PIO->rxf[s], LOOPBACK_WORDS, true);
+    }
+    // both pins are sampled in sync, the message starts shortly after
+    pio_enable_sm_mask_in_sync(LOOPBACK_PIO, (1u << n) - 1);
+    backscatter_start(pio, sm, (uint32_t *) loopback_message, LOOPBACK_MESSAGE_WORDS);
+    for (uint8_t s = 0; s < n; s++){
+        dma_channel_wait_for_finish_blocking(channel[s]);
+        pio_sm_set_enabled(LOOPBACK_PIO, s, false);
+        dma_channel_unclaim(channel[s]);
+    }
+    backscatter_wait_sent(pio, sm);
+    return loopback_analyze(capture[0], twoAntennas ? capture[1] : NULL, LOOPBACK_WORDS, div, loopback_message, LOOPBACK_SYMBOLS,
+                            d0, d1, symbol_cycles, getAntennaPhase(), result);
+}
+
+void print_loopback(const struct loopback_result *result){
+    lib_printf("# loopback: div %u symbols %u edges %u/%u f0 %u Hz (%u) f1 %u Hz (%u) symbol %u.%03u cycles (%u) drift %d ppm max error %u cycles",
+           result->div, result->symbols, result->edges, result->expected_edges, result->f0, result->f0_expected, result->f1, result->f1_expected,
+           result->symbol_mcycles/1000, result->symbol_mcycles%1000, result->symbol_cycles, result->drift_ppm, result->max_error);
+    if (result->pin2){
+        lib_printf(" pin2 edges %u phase %d deg error %u cycles", result->pin2_edges, result->pin2_phase, result->pin2_error);
+    }
+    lib_printf(" %s\n", result->pass ? "pass" : "MISMATCH");
+}
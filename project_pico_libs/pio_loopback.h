@@ -0,0 +1,64 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * On-chip self-test of the backscatter state-machine: two state-machines of pio1 sample PIN_TX1 and
+ * PIN_TX2 (`in pins, 1`, one sample every div cycles, autopush) while the program on pio0 sends a
+ * test message of LOOPBACK_SYMBOLS symbols. Two DMA channels drain the RX FIFOs into RAM. The sampling
+ * step covers the whole message, but keeps four samples per period (the capture of long symbols ends
+ * within the message).
+ *
+ * The rising edges of the capture are timestamped (sample index * div) and compared with the edges
+ * that the program of generatePIOprogram() has to produce for the message: symbol start, full periods
+ * of d0/d1 and the remaining period of each symbol. The result contains the measured frequency of
+ * both symbols (mean over the full periods), the symbol length and drift from the first to the last
+ * edge, the largest deviation of an edge from the model and the phase of PIN_TX2 (antenna phase).
+ * The test passes if no edge is missing and every edge (also of PIN_TX2) is within the sampling step.
+ *
+ * pio1 is used exclusively during the test (its instruction memory is cleared). The test takes
+ * LOOPBACK_SYMBOLS symbols plus the analysis.
+ *
+ */
+
+#ifndef PIO_LOOPBACK_LIB
+#define PIO_LOOPBACK_LIB
+
+#include <stdint.h>
+#include <stdbool.h>
+#include "pico/stdlib.h"
+#include "hardware/pio.h"
+#include "backscatter.h"
+
+#define LOOPBACK_PIO          pio1
+#define LOOPBACK_WORDS        2048 // capture per pin (32 samples per word)
+#define LOOPBACK_MESSAGE_WORDS   2
+#define LOOPBACK_SYMBOLS      (32*LOOPBACK_MESSAGE_WORDS)
+
+struct loopback_result {
+  uint16_t div;            // sampling step [cycles]
+  uint16_t symbols;        // symbols of the message within the capture
+  uint32_t edges;          // rising edges of PIN_TX1 (compared with the model)
+  uint32_t expected_edges;
+  uint32_t f0, f1;         // measured frequency of symbol 0 and 1 [Hz]
+  uint32_t f0_expected, f1_expected;
+  uint32_t symbol_mcycles; // measured symbol length [0.001 cycles]
+  uint32_t symbol_cycles;  // expected symbol length [cycles]
+  int32_t  drift_ppm;      // symbol timing drift over the message
+  uint32_t max_error;      // largest deviation of an edge of PIN_TX1 from the model [cycles]
+  bool     pin2;           // PIN_TX2 has been sampled (two antennas)
+  uint32_t pin2_edges;
+  int32_t  pin2_phase;     // mean phase of PIN_TX2 after PIN_TX1 [degree]
+  uint32_t pin2_error;     // largest deviation of an edge of PIN_TX2 from the antenna phase [cycles]
+  bool     pass;
+};
+
+/* send the test message with the loaded program (pio/sm) and measure it, returns result->pass */
+bool loopback_selftest(PIO pio, uint sm, uint pin1, uint pin2, bool twoAntennas, uint16_t d0, uint16_t d1, const struct backscatter_config *config, struct loopback_result *result);
+
+/* compare a capture with the model of the message (pin2 NULL: one antenna), returns result->pass (host check: host/sim/loopback_check.cpp) */
+bool loopback_analyze(const uint32_t *pin1, const uint32_t *pin2, uint32_t words, uint16_t div, const uint32_t *message, uint16_t symbols,
+                      uint16_t d0, uint16_t d1, uint32_t symbol_cycles, enum antenna_phase phase, struct loopback_result *result);
+
+/* one log line: # loopback: ... pass/MISMATCH */
+void print_loopback(const struct loopback_result *result);
+
+#endif
@@ -7,6 +7,7 @@
  * GPIO 18 (pin 24) SCK/spi0_sclk
  * GPIO 19 (pin 25) MOSI/spi0_tx
  * GPIO 21 GDO0: interrupt for received sync word
+ * GPIO 20/22: chip select/GDO0 of the optional second receiver
  *
  * The example uses SPI port 0.
  * The stdout has been directed to USB.
@@ -16,13 +17,15 @@
 
 #include <stdio.h>
 #include <string.h>
-#include <math.h>
 #include "pico/stdlib.h"
 #include "pico/util/queue.h"
 #include "pico/binary_info.h"
 #include "hardware/spi.h"
 #include "receiver_CC2500.h"
 #include "carrier_CC2500.h"
+#include "cc2500_regs.h"
+#include "trace.h"
+#include "lib_output.h"
 
 queue_t event_queue;
 
@@ -75,15 +78,35 @@ RF_setting cc2500_receiver[20] = {
   {.address = 0x26, .value = 0x11}, // CC2500_FSCAL0: Frequency Synthesizer Calibration
 };
 
+static const uint rx_csn_pins[MAX_RECEIVERS]  = {RX_CSN, RX2_CSN};
+static const uint rx_gdo0_pins[MAX_RECEIVERS] = {RX_GDO0_PIN, RX2_GDO0_PIN};
+static uint rx_csn = RX_CSN;
+static uint rx_gdo0 = RX_GDO0_PIN;
+static uint8_t rx_selected = 0;
+static uint8_t rx_fixed_length[MAX_RECEIVERS] = {0}; // packet length in fixed length mode (0: variable length mode)
+static uint8_t rx_salvage_length[MAX_RECEIVERS] = {0}; // frame length of the salvage mode (0: off)
+static bool rx_manual_calibration[MAX_RECEIVERS] = {false};
+static bool log_microseconds = false;
+
+void select_receiver_rx(uint8_t receiver) {
+    rx_selected = receiver % MAX_RECEIVERS;
+    rx_csn  = rx_csn_pins[rx_selected];
+    rx_gdo0 = rx_gdo0_pins[rx_selected];
+}
+
+uint8_t event_receiver(event_t evt) {
+    return (evt == rx2_assert_evt || evt == rx2_deassert_evt) ? 1 : 0;
+}
+
 void cs_select_rx() {
     asm volatile("nop \n nop \n nop");
-    gpio_put(RX_CSN, 0);  // Active low
+    gpio_put(rx_csn, 0);  // Active low
     asm volatile("nop \n nop \n nop");
 }
 
 void cs_deselect_rx() {
     asm volatile("nop \n nop \n nop");
-    gpio_put(RX_CSN, 1);
+    gpio_put(rx_csn, 1);
     asm volatile("nop \n nop \n nop");
 }
 
@@ -133,7 +156,7 @@ void print_registers_rx() {
         spi_read_blocking(RADIO_SPI, r+0x80, buf, 2);
         cs_deselect_rx();
         sleep_ms(1);
-        printf("    {.address = 0x%02x, .value = 0x%02x},\n", r, buf[1]);
+        lib_printf("    {.address = 0x%02x, .value = 0x%02x},\n", r, buf[1]);
     }
 }
 
@@ -145,43 +168,104 @@ void receiver_isr(uint gpio, uint32_t events)
         case RX_GDO0_PIN:
             switch(events){
                 case GPIO_IRQ_EDGE_RISE:
+                    TRACE(TRACE_RX_ASSERT_EVT);
                     evt = rx_assert_evt;
                     queue_try_add(&event_queue, &evt);
                     break;
                 case GPIO_IRQ_EDGE_FALL:
+                    TRACE(TRACE_RX_DEASSERT_EVT);
                     evt = rx_deassert_evt;
                     queue_try_add(&event_queue, &evt);
                     break;
             }
         break;
+        case RX2_GDO0_PIN:
+            switch(events){
+                case GPIO_IRQ_EDGE_RISE:
+                    TRACE(TRACE_RX_ASSERT_EVT);
+                    evt = rx2_assert_evt;
+                    queue_try_add(&event_queue, &evt);
+                    break;
+                case GPIO_IRQ_EDGE_FALL:
+                    TRACE(TRACE_RX_DEASSERT_EVT);
+                    evt = rx2_deassert_evt;
+                    queue_try_add(&event_queue, &evt);
+                    break;
+            }
+        break;
     }
 }
 
+static void setup_events();
+
+// setup the selected receiver (the event queue is shared by all receivers)
 void setupReceiver(){
     write_strobe_rx(SRES);  // in case of reset without power loss - reset manually
     sleep_us(100);
     write_strobe_rx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
     write_registers_rx(cc2500_receiver,20);
+    setup_events();
+}
+
+// event queue and GDO0 interrupt of the selected receiver
+static void setup_events(){
+    static bool queue_initialized = false;
 
     /* Event queue setup */
-    queue_init(&event_queue, sizeof(event_t), EVENT_QUEUE_LENGTH);
+    if(!queue_initialized){
+        queue_init(&event_queue, sizeof(event_t), EVENT_QUEUE_LENGTH);
+        queue_initialized = true;
+    }
 
     /* Reset the queue */
     while(queue_try_remove(&event_queue, NULL));
 
     /* GDO0 setup as interrupt */
-    gpio_set_irq_enabled_with_callback(RX_GDO0_PIN, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true, &receiver_isr);
+    gpio_set_irq_enabled_with_callback(rx_gdo0, GPIO_IRQ_EDGE_RISE | GPIO_IRQ_EDGE_FALL, true, &receiver_isr);
+}
 
+// command strobe without the fixed 1ms delay
+static void strobe_rx(uint8_t cmd) {
+    cs_select_rx();
+    spi_write_blocking(RADIO_SPI, &cmd, 1);
+    cs_deselect_rx();
+}
+
+uint8_t read_marcstate_rx() {
+    uint8_t buf[2] = {0, 0};
+    cs_select_rx();
+    spi_read_blocking(RADIO_SPI, 0xF5, buf, 2); // read status register MARCSTATE (0x35 + burst bit)
+    cs_deselect_rx();
+    return buf[1] & 0x1F;
 }
 
-// continously listen for packets
+// wait until the receiver reached the given state (bounded by RX_SETTLE_TIMEOUT_US)
+static void wait_marcstate_rx(uint8_t state) {
+    uint64_t start = time_us_64();
+    while(read_marcstate_rx() != state && time_us_64() - start < RX_SETTLE_TIMEOUT_US);
+}
+
+// continously listen for packets (returns once the receiver is in RX mode)
 void RX_start_listen(){
-    write_strobe_rx(SIDLE);
+    strobe_rx(SIDLE);
+    wait_marcstate_rx(MARCSTATE_IDLE);
     RF_setting set = {.address = 0x17, .value = 0x00};    // after receiving a packet, return to idle
     //RF_setting set = {.address = 0x17, .value = 0x0C}; // after receiving a packet, listen for next one
+    write_registers_rx(&set, 1);
+    strobe_rx(SFRX); // clear FIFO
+    strobe_rx(SRX);  // start listening (enter RX mode with command strobe: SRX)
+    wait_marcstate_rx(MARCSTATE_RX);
+}
+
+void setReceiverManualCalibration(bool manual){
+    write_strobe_rx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
+    // MCSM0: FS_AUTOCAL = 0 (never) or 1 (when going from IDLE to RX or TX), PO_TIMEOUT = 2
+    RF_setting set = {.address = 0x18, .value = manual ? 0x08 : 0x18};
     write_register_rx(set);
-    write_strobe_rx(SFRX); // clear FIFO
-    write_strobe_rx(SRX);  // start listening (enter RX mode with command strobe: SRX)
+    rx_manual_calibration[rx_selected] = manual;
+    if(manual){
+        write_strobe_rx(SCAL); // calibrate now (takes approx. 720us, covered by the strobe delay)
+    }
 }
 
 // stop listening
@@ -189,6 +273,15 @@ void RX_stop_listen(){
     write_strobe_rx(SIDLE); // stop listening (enter IDLE mode with command strobe: SIDLE)
 }
 
+// convert the RSSI register value into dBm (see datasheet, section 17.3)
+static int32_t rssi_to_dbm(uint8_t rssi_dec){
+    if(rssi_dec >= 128){
+        return (((int32_t) rssi_dec) - 256)/2 - 70;
+    }else{
+        return ((int32_t) rssi_dec)/2 - 70;
+    }
+}
+
 Packet_status readPacket(uint8_t *buffer){
     Packet_status status;
     uint8_t tmp_buffer[2];
@@ -199,23 +292,32 @@ Packet_status readPacket(uint8_t *buffer){
     status.overflowed = (bool) (tmp_buffer[1] & 0x80);
     if (!status.overflowed){
         status.len = (tmp_buffer[1] & 0x7F) - 2;
+        // in fixed length mode, no length byte is received: insert it to keep the buffer layout (length, seq, payload)
+        uint8_t offset = rx_fixed_length[rx_selected] ? 1 : 0;
+        buffer[0] = status.len;
         cs_select_rx();
         spi_read_blocking(RADIO_SPI, 0xFF, tmp_buffer, 1);               // sart burst access to RX FIFO
-        spi_read_blocking(RADIO_SPI, 0xFF, buffer, min(min(status.len, 62), RX_BUFFER_SIZE));  // start reading from burst (max. 62 bytes of packet)
+        spi_read_blocking(RADIO_SPI, 0xFF, buffer + offset, min(min(status.len, 62), RX_BUFFER_SIZE - offset));  // start reading from burst (max. 62 bytes of packet)
         spi_read_blocking(RADIO_SPI, 0xFF, tmp_buffer,  2);              // read quality information
         cs_deselect_rx();
+        status.len = status.len + offset;
         status.CRCcheck = (bool) (tmp_buffer[1] & 0x80);
         status.LinkQualityIndicator = (tmp_buffer[1] & 0x7F);
-        if(tmp_buffer[0] >= 128){
-            status.RSSI = (((int32_t) tmp_buffer[0]) - 256)/2 - 70;
-        }else{
-            status.RSSI = ((int32_t) tmp_buffer[0])/2 - 70;
-        }
+        status.RSSI = rssi_to_dbm(tmp_buffer[0]);
     }
     return status;
 }
 
-void printPacket(uint8_t *packet, Packet_status status, uint64_t time_us){
+// read the current RSSI [dBm] (the receiver has to be in RX mode)
+int32_t read_rssi_rx(){
+    uint8_t buf[2] = {0, 0};
+    cs_select_rx();
+    spi_read_blocking(RADIO_SPI, 0xF4, buf, 2); // read status register RSSI (0x34 + burst bit)
+    cs_deselect_rx();
+    return rssi_to_dbm(buf[1]);
+}
+
+uint16_t formatPacket(char *line, uint8_t *packet, Packet_status status, uint64_t time_us){
     // generate timestamp since boot-up
     uint64_t time_rem;
     uint32_t hours    = (int32_t) (time_us  / ((uint64_t) 36 * (uint64_t) 100000000));
@@ -224,22 +326,97 @@ void printPacket(uint8_t *packet, Packet_status status, uint64_t time_us){
     time_rem          =           (time_rem % (60 *   1000000));
     uint32_t  sec     = (int32_t) (time_rem / (1000000));
     time_rem          =           (time_rem % (1000000));
-    uint32_t msec     = (int32_t) (time_rem / (1000));
-    printf("%02d:%02d:%02d.%03d | ", hours, minutes, sec, msec);
+    int len;
+    if(log_microseconds){
+        len = sprintf(line, "%02d:%02d:%02d.%06d | ", hours, minutes, sec, (int32_t) time_rem);
+    }else{
+        uint32_t msec = (int32_t) (time_rem / (1000));
+        len = sprintf(line, "%02d:%02d:%02d.%03d | ", hours, minutes, sec, msec);
+    }
     if(status.overflowed){
-        printf("packet overflow (possible length field corrupted) | CRC error\n");
+        len += sprintf(&line[len], "packet overflow (possible length field corrupted) | CRC error\n");
     }else{
+        static const char hex[] = "0123456789abcdef";
         for(uint8_t i = 0; i < min(status.len,RX_BUFFER_SIZE); i++){
-            printf("%02x ", packet[i]);
+            line[len++] = hex[packet[i] >> 4];
+            line[len++] = hex[packet[i] & 0x0F];
+            line[len++] = ' ';
         }
-        printf("| ");
-        printf("%d ", status.RSSI);
-        if(status.CRCcheck){
-            printf("CRC pass\n");
-        }else{
-            printf("CRC error\n");
+        len += sprintf(&line[len], "| %d %s\n", status.RSSI, status.CRCcheck ? "CRC pass" : "CRC error");
+    }
+    return (uint16_t) len;
+}
+
+void printPacket(uint8_t *packet, Packet_status status, uint64_t time_us){
+    char line[PACKET_LINE_MAX];
+    formatPacket(line, packet, status, time_us);
+    printf("%s", line);
+}
+
+void setLogMicroseconds(bool enable){
+    log_microseconds = enable;
+}
+
+uint8_t formatPacketBinary(uint8_t *record, uint8_t *packet, Packet_status status, uint64_t time_us){
+    uint8_t len = status.overflowed ? 0 : min(status.len, RX_BUFFER_SIZE);
+    record[0] = BINARY_SYNC0;
+    record[1] = BINARY_SYNC1;
+    record[2] = len;
+    record[3] = (status.CRCcheck ? BINARY_FLAG_CRC : 0) | (status.overflowed ? BINARY_FLAG_OVERFLOW : 0);
+    record[4] = (uint8_t) ((int8_t) max(-128, min(127, status.RSSI)));
+    record[5] = status.LinkQualityIndicator;
+    for(uint8_t i = 0; i < 8; i++){
+        record[6 + i] = (uint8_t) (time_us >> (8*i)); // little endian
+    }
+    memcpy(&record[BINARY_HEADER_LEN], packet, len);
+    uint8_t checksum = 0;
+    for(uint8_t i = 2; i < BINARY_HEADER_LEN + len; i++){
+        checksum ^= record[i];
+    }
+    record[BINARY_HEADER_LEN + len] = checksum;
+    return BINARY_HEADER_LEN + len + 1;
+}
+
+void printPacketBinary(uint8_t *packet, Packet_status status, uint64_t time_us){
+    uint8_t record[BINARY_RECORD_MAX];
+    uint8_t len = formatPacketBinary(record, packet, status, time_us);
+    // raw output: printf would translate 0x0a into "\r\n"
+    for(uint8_t i = 0; i < len; i++){
+        putchar_raw(record[i]);
+    }
+}
+
+int8_t select_best_copy(RX_copy *copies, uint8_t n){
+    int8_t best = -1;
+    for(uint8_t i = 0; i < n; i++){
+        if(!copies[i].received || copies[i].status.overflowed){
+            continue;
+        }
+        if(best < 0){
+            best = i;
+            continue;
+        }
+        Packet_status *a = &copies[i].status;
+        Packet_status *b = &copies[best].status;
+        if(a->CRCcheck != b->CRCcheck){
+            if(a->CRCcheck){
+                best = i;
+            }
+        }else if(a->LinkQualityIndicator != b->LinkQualityIndicator){
+            if(a->LinkQualityIndicator < b->LinkQualityIndicator){
+                best = i;
+            }
+        }else if(a->RSSI > b->RSSI){
+            best = i;
+        }
+    }
+    // all copies overflowed: report the first one
+    for(uint8_t i = 0; i < n && best < 0; i++){
+        if(copies[i].received){
+            best = i;
         }
     }
+    return best;
 }
 
 event_t get_event(void)
@@ -256,13 +433,13 @@ void set_datarate_rx(uint32_t r_data)
 {
     write_strobe_rx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
     
-    // see datasheet, section 12
-    uint8_t drate_e = floor(log2(((double) r_data * (1 << 20)) / ((double) F_XOSC)));
-    uint8_t drate_m = floor(((double) r_data * (1 << 28)) / ((double) F_XOSC * (1 << drate_e)) - 256.0);
+    // see datasheet, section 12 (closest data rate)
+    struct cc2500_em drate = cc2500_datarate_regs(r_data);
+    uint8_t drate_e = drate.e;
+    uint8_t drate_m = drate.m;
     
     // print new value
-    uint32_t r_data_calculated = floor(((256.0+drate_m)*(1 << drate_e) * (double) F_XOSC) / ((double) (1 << 28)));
-    printf("set rx r_data: [%u %u] %u\n", drate_e, drate_m, r_data_calculated);
+    lib_printf("set rx r_data: [%u %u] %u\n", drate_e, drate_m, drate.value);
     
     // MDMCFG4, MDMCFG3
     RF_setting mdmcfg3 = read_register_rx(0x10);
@@ -277,13 +454,13 @@ void set_filter_bandwidth_rx(uint32_t bw)
 {
     write_strobe_rx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
 
-    // see datasheet, section 13
-    uint8_t chanbw_e = floor(log2(((double) F_XOSC)/((double) (1 << 5) * bw)/log2(2.0)));
-    uint8_t chanbw_m = floor(((double) F_XOSC)/((double) 8.0 * bw * (1 << chanbw_e)) - 4.0);
+    // see datasheet, section 13 (narrowest filter not below bw)
+    struct cc2500_em chanbw = cc2500_bandwidth_regs(bw);
+    uint8_t chanbw_e = chanbw.e;
+    uint8_t chanbw_m = chanbw.m;
     
     // print new value
-    uint32_t bw_calculated = floor(((double) F_XOSC) / ((double) 8.0*(4.0+chanbw_m)*(1 << chanbw_e)));
-    printf("set rx bw: [%u %u] %u\n", chanbw_e, chanbw_m, bw_calculated);
+    lib_printf("set rx bw: [%u %u] %u\n", chanbw_e, chanbw_m, chanbw.value);
     
     // MDMCFG3
     RF_setting mdmcfg3 = read_register_rx(0x10);
@@ -295,20 +472,75 @@ void set_frequency_deviation_rx(uint32_t f_dev)
 {
     write_strobe_rx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
 
-    // see datasheet, section 16
-    uint8_t deviation_e = floor(log2(((double) f_dev) * (1 << 14) / ((double) F_XOSC)));
-    uint8_t deviation_m = floor((((double) f_dev) * (1 << 17)) / ((double) (1 << deviation_e) * F_XOSC) - 8.0);
+    // see datasheet, section 16 (closest deviation)
+    struct cc2500_em deviation = cc2500_deviation_regs(f_dev);
+    uint8_t deviation_e = deviation.e;
+    uint8_t deviation_m = deviation.m;
 
     // new value
-    uint32_t f_dev_calculated = floor(((double) F_XOSC) * (8.0 + (double) deviation_m + 1.0)*(1 << deviation_e) / ((double) (1 << 17)));
-    printf("set rx f_dev: [%u %u] %u\n", deviation_e, deviation_m, f_dev_calculated);
+    lib_printf("set rx f_dev: [%u %u] %u\n", deviation_e, deviation_m, deviation.value);
 
     // DEVIATN
     RF_setting set = {.address = 0x15, .value = ((deviation_e & 0x07) << 4) + (deviation_m & 0x07)};
     write_register_rx(set);
 }
 
-void set_frecuency_rx(uint32_t f_carrier)
+void set_packet_format_rx(uint8_t preamble_len, uint8_t sync_len, uint8_t fixed_len)
+{
+    write_strobe_rx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
+
+    // see datasheet, section 15: minimum number of preamble bytes (only used in TX) and preamble quality threshold
+    const uint8_t num_preamble[8] = {2, 3, 4, 6, 8, 12, 16, 24};
+    uint8_t num_preamble_idx = 0;
+    while(num_preamble_idx < 7 && num_preamble[num_preamble_idx+1] <= preamble_len){
+        num_preamble_idx++;
+    }
+    // PQT: the 32-bit sync word keeps the qualification of cc2500_receiver (PQT 0), the 16-bit sync word is more likely
+    // to be detected in noise and additionally requires half of the preamble bits (threshold: 4*PQT)
+    uint8_t pqt = (sync_len == 4) ? 0 : min(7, (preamble_len*8/2)/4);
+    // SYNC_MODE: 30/32 (32-bit sync word) or 15/16 (16-bit sync word) sync word bits detected
+    uint8_t sync_mode = (sync_len == 4) ? 0x03 : 0x01;
+    rx_fixed_length[rx_selected] = fixed_len;
+    rx_salvage_length[rx_selected] = 0;
+    lib_printf("set rx packet format: preamble %u (NUM_PREAMBLE %u, PQT %u) sync %u bit, %s length %u\n", preamble_len, num_preamble_idx, pqt, 8*sync_len, fixed_len ? "fixed" : "variable", fixed_len);
+
+    // PKTLEN, PKTCTRL1, PKTCTRL0, MDMCFG2, MDMCFG1
+    RF_setting mdmcfg2 = read_register_rx(0x12);
+    RF_setting mdmcfg1 = read_register_rx(0x13);
+    RF_setting pktctrl0 = read_register_rx(0x08);
+    RF_setting set[5] = {
+        {.address = 0x06, .value = fixed_len ? fixed_len : 0xFF},
+        {.address = 0x07, .value = (pqt << 5) | 0x04},                                      // APPEND_STATUS
+        {.address = 0x08, .value = (pktctrl0.value & 0xFC) | (fixed_len ? 0x00 : 0x01)},    // LENGTH_CONFIG
+        {.address = 0x12, .value = (mdmcfg2.value & 0xF8) | sync_mode},
+        {.address = 0x13, .value = (mdmcfg1.value & 0x8F) | (num_preamble_idx << 4)}
+    };
+    write_registers_rx(set,5);
+}
+
+void set_salvage_length_rx(uint8_t frame_len)
+{
+    write_strobe_rx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
+    rx_fixed_length[rx_selected] = 0; // the length byte is received (no insertion by readPacket)
+    rx_salvage_length[rx_selected] = frame_len;
+    lib_printf("set rx salvage length: %u\n", frame_len);
+
+    // PKTLEN, PKTCTRL0: fixed length mode of frame_len bytes (off: variable length mode)
+    RF_setting pktctrl0 = read_register_rx(0x08);
+    RF_setting set[2] = {
+        {.address = 0x06, .value = frame_len ? frame_len : 0xFF},
+        {.address = 0x08, .value = (pktctrl0.value & 0xFC) | (frame_len ? 0x00 : 0x01)}    // LENGTH_CONFIG
+    };
+    write_registers_rx(set,2);
+}
+
+uint8_t get_salvage_length_rx()
+{
+    return rx_salvage_length[rx_selected];
+}
+
+// compute and write the frequency registers, returns the configured carrier frequency [Hz]
+static uint32_t write_frecuency_rx(uint32_t f_carrier, bool verbose)
 {
 // Test read_register_rx
 //    RF_setting a = {.address = 0x13, .value = 0xab};
@@ -318,15 +550,17 @@ void set_frecuency_rx(uint32_t f_carrier)
     
     write_strobe_rx(SIDLE); // ensure IDLE mode with command strobe: SIDLE
     // see datasheet, section 21
-    // approach: chose start frequency as close as possible to f_carrier, correct with channel
-    uint32_t freq = floor(f_carrier *((double) (1 << 16)) / ((double) F_XOSC));
+    // approach: chose the frequency control word closest to f_carrier, channel 0 (the channel spacing is unused)
+    uint32_t f_carrier_calculated;
+    uint32_t freq = cc2500_frequency_word(f_carrier, &f_carrier_calculated);
     uint8_t channel = 0;
     uint8_t channspc_e = 0;
-    uint8_t channspc_m = floor(((((double) f_carrier) * (1 << 16)) / ((double) F_XOSC) - freq - (1 << 6)) * (1 << 2));
+    uint8_t channspc_m = 0xF8; // reset value
 
     // print new value
-    uint32_t f_carrier_calculated = floor(((double) F_XOSC) * (freq + (double) channel*(256+channspc_m)/((double) (1 << 2))) / ((double) (1 << 16)));
-    printf("set rx f_carrier [%u %u %u %u] %u\n", freq, channel, channspc_e, channspc_m, f_carrier_calculated);
+    if(verbose){
+        lib_printf("set rx f_carrier [%u %u %u %u] %u\n", freq, channel, channspc_e, channspc_m, f_carrier_calculated);
+    }
     
     // CHANNR, FREQ2, FREQ1, FREQ0, MDMCFG1, MDMCFG1
     RF_setting mdmcfg1 = read_register_rx(0x13);
@@ -340,4 +574,45 @@ void set_frecuency_rx(uint32_t f_carrier)
     };
     //printf("debug %02x %02x %02x %02x %02x %02x\n", set[0].value, set[1].value, set[2].value, set[3].value, set[4].value, set[5].value);
     write_registers_rx(set,6);
+    if(rx_manual_calibration[rx_selected]){
+        write_strobe_rx(SCAL); // re-calibrate for the new frequency
+    }
+    return f_carrier_calculated;
+}
+
+void set_frecuency_rx(uint32_t f_carrier)
+{
+    write_frecuency_rx(f_carrier, true);
+}
+
+// retune without printing (e.g. while sweeping), returns the configured carrier frequency [Hz]
+uint32_t tune_frecuency_rx(uint32_t f_carrier)
+{
+    return write_frecuency_rx(f_carrier, false);
+}
+
+void read_image_rx(uint8_t *image){
+    uint8_t header = 0xC0; // burst read from 0x00
+    cs_select_rx();
+    spi_write_blocking(RADIO_SPI, &header, 1);
+    spi_read_blocking(RADIO_SPI, 0x00, image, CC2500_IMAGE_LEN);
+    cs_deselect_rx();
+}
+
+bool restoreReceiver(const uint8_t *image, uint8_t salvage_len){
+    strobe_rx(SRES);  // in case of reset without power loss - reset manually (without the fixed delays of setupReceiver)
+    wait_marcstate_rx(MARCSTATE_IDLE);
+    uint8_t header = 0x40; // burst write from 0x00
+    cs_select_rx();
+    spi_write_blocking(RADIO_SPI, &header, 1);
+    spi_write_blocking(RADIO_SPI, image, CC2500_IMAGE_LEN);
+    cs_deselect_rx();
+    // state of the configuration functions: fixed length mode (PKTCTRL0, PKTLEN) and manual calibration (MCSM0: FS_AUTOCAL = 0)
+    rx_fixed_length[rx_selected] = ((image[0x08] & 0x03) == 0x00 && salvage_len == 0) ? image[0x06] : 0;
+    rx_salvage_length[rx_selected] = salvage_len;
+    rx_manual_calibration[rx_selected] = ((image[0x18] >> 4) & 0x03) == 0x00;
+    setup_events();
+    uint8_t check[CC2500_IMAGE_LEN];
+    read_image_rx(check);
+    return memcmp(check, image, CC2500_IMAGE_LEN) == 0;
 }
@@ -7,6 +7,11 @@
  * GPIO 18 (pin 24) SCK/spi0_sclk
  * GPIO 19 (pin 25) MOSI/spi0_tx
  * GPIO 21 GDO0: interrupt for received sync word
+ *
+ * Optional second receiver (selection diversity):
+ * GPIO 20 Chip select
+ * GPIO 22 GDO0: interrupt for received sync word
+ * All functions operate on the receiver chosen with select_receiver_rx() (default: first receiver).
  * 
  * The example uses SPI port 0. 
  * The stdout has been directed to USB.
@@ -31,6 +36,9 @@
 
 #define RX_CSN                  17
 #define RX_GDO0_PIN             21
+#define RX2_CSN                 20
+#define RX2_GDO0_PIN            22
+#define MAX_RECEIVERS            2
 
 #define RX_BUFFER_SIZE          64
 #define EVENT_QUEUE_LENGTH      20 
@@ -39,6 +47,11 @@
 #define   SRX                 0x34
 #define  SFRX                 0x3A
 #define  SRES                 0x30
+#define  SCAL                 0x33
+
+#define MARCSTATE_IDLE        0x01
+#define MARCSTATE_RX          0x0D
+#define RX_SETTLE_TIMEOUT_US  2000 // upper bound for IDLE -> RX (including calibration)
 
 #define F_XOSC            26000000
 
@@ -70,11 +83,24 @@ typedef struct packet_status Packet_status;
 
 /* Event queue */
 typedef enum _event_t{
-    no_evt          = 0,
-    rx_assert_evt   = 1,
-    rx_deassert_evt = 2
+    no_evt           = 0,
+    rx_assert_evt    = 1,
+    rx_deassert_evt  = 2,
+    rx2_assert_evt   = 3,
+    rx2_deassert_evt = 4
 } event_t;
 
+/* one received copy of a frame (selection diversity) */
+struct rx_copy {
+  bool busy;        // sync word received, packet not yet read
+  bool received;    // packet read, not yet merged
+  uint64_t time_us;
+  Packet_status status;
+  uint8_t buffer[RX_BUFFER_SIZE];
+  uint8_t *packet;  // received bytes: buffer or a slot of the USB logger (usb_logger.h)
+};
+typedef struct rx_copy RX_copy;
+
 // Address Config = No address check 
 // Base Frequency = 2456.596924 
 // CRC Autoflush = false 
@@ -99,6 +125,12 @@ typedef enum _event_t{
 
 extern RF_setting cc2500_receiver[20];
 
+// select the receiver (0 or 1) for all following operations
+void select_receiver_rx(uint8_t receiver);
+
+// receiver index of an rx event
+uint8_t event_receiver(event_t evt);
+
 void cs_select_rx();
 
 void cs_deselect_rx();
@@ -114,18 +146,73 @@ void receiver_isr(uint gpio, uint32_t events);
 
 void setupReceiver();
 
-// continously listen for packets
+// continously listen for packets (returns once the receiver is in RX mode)
 void RX_start_listen();
 
+// read the main radio control state (status register MARCSTATE)
+uint8_t read_marcstate_rx();
+
+/* 
+ * calibrate the frequency synthesizer once (and after each frequency change) instead of at every IDLE -> RX transition
+ * this reduces the time to re-arm the receiver from approx. 800us to approx. 90us (see datasheet, table 34)
+ */
+void setReceiverManualCalibration(bool manual);
+
 // stop listening
 void RX_stop_listen();
 
+// register image of the selected receiver (CC2500_IMAGE_LEN bytes, see cc2500_regs.h), including its calibration
+void read_image_rx(uint8_t *image);
+
+/*
+ * fast setup of the selected receiver from a register image (instead of setupReceiver and the configuration functions):
+ * reset and a single burst write without fixed delays, the calibration of the image is used (no SCAL)
+ * salvage_len: get_salvage_length_rx() when the image was read (the salvage mode is not part of the registers)
+ * returns false if the read-back differs from the image (e.g. no receiver)
+ */
+bool restoreReceiver(const uint8_t *image, uint8_t salvage_len);
+
 void print_registers_rx();
 
 Packet_status readPacket(uint8_t *buffer);
 
+// read the current RSSI [dBm] (the receiver has to be in RX mode)
+int32_t read_rssi_rx();
+
+/* text line of a received frame: hh:mm:ss.mmm | len seq payload | rssi CRC pass/error
+ * (hh:mm:ss.mmmuuu with setLogMicroseconds(true), readable by the same parsers) */
 void printPacket(uint8_t *packet, Packet_status status, uint64_t time_us);
 
+/* text line of printPacket into line (at least PACKET_LINE_MAX bytes, zero-terminated), returns its length */
+#define PACKET_LINE_MAX (3*RX_BUFFER_SIZE + 80)
+uint16_t formatPacket(char *line, uint8_t *packet, Packet_status status, uint64_t time_us);
+
+// print the timestamps of printPacket with microsecond resolution
+void setLogMicroseconds(bool enable);
+
+/*
+ * binary log record (instead of the text line of printPacket, about 3x shorter):
+ * sync (0xA5 0x5A) | frame length n | flags | RSSI (int8) | LQI | time_us (uint64, little endian) | frame (n bytes) | checksum
+ * flags: bit 0 CRC pass, bit 1 overflow (n = 0); checksum: XOR of all bytes after the sync word
+ * Text lines ('#' statistics) can be mixed in, as they never start with 0xA5. Decoded by carrier-receiver-baseband/serial-capture.py.
+ */
+#define BINARY_SYNC0          0xA5
+#define BINARY_SYNC1          0x5A
+#define BINARY_HEADER_LEN       14
+#define BINARY_FLAG_CRC       0x01
+#define BINARY_FLAG_OVERFLOW  0x02
+#define BINARY_RECORD_MAX     (BINARY_HEADER_LEN + RX_BUFFER_SIZE + 1)
+void printPacketBinary(uint8_t *packet, Packet_status status, uint64_t time_us);
+
+/* binary record of printPacketBinary into record (at least BINARY_RECORD_MAX bytes), returns its length */
+uint8_t formatPacketBinary(uint8_t *record, uint8_t *packet, Packet_status status, uint64_t time_us);
+
+/* 
+ * selection diversity: index of the best received copy or -1 if none has been received
+ * preference: CRC pass, lowest link quality indicator (lower is better), highest RSSI
+ */
+int8_t select_best_copy(RX_copy *copies, uint8_t n);
+
 event_t get_event(void);
 
 //set datarate [baud]
@@ -137,7 +224,31 @@ void set_filter_bandwidth_rx(uint32_t bw);
 //set FSK frequency deviation [Hz]
 void set_frequency_deviation_rx(uint32_t f_dev);
 
+/*
+ * set packet format
+ * - preamble_len: number of preamble bytes sent by the tag (sets NUM_PREAMBLE and, for a 16-bit sync word, the preamble quality threshold)
+ * - sync_len: 4 (32-bit sync word, 30/32 bits detected) or 2 (16-bit sync word, 15/16 bits detected)
+ * - fixed_len: 0 for variable length mode, otherwise the fixed packet length (seq + payload)
+ *   in fixed length mode, readPacket() inserts the length byte to keep the buffer layout
+ * (turns the salvage mode off)
+ */
+void set_packet_format_rx(uint8_t preamble_len, uint8_t sync_len, uint8_t fixed_len);
+
+/*
+ * salvage mode of the variable length format: receive frame_len bytes (length byte, seq and payload) in fixed length mode
+ * instead of the number given by the received length byte. A corrupted length byte neither truncates the frame nor
+ * extends it until the FIFO overflows: the frame is received completely (CRC error) and its payload can still be scored.
+ * The received length byte stays in the buffer (status.len is frame_len). 0: off (variable length mode)
+ */
+void set_salvage_length_rx(uint8_t frame_len);
+
+// frame length of the salvage mode of the selected receiver (0: off)
+uint8_t get_salvage_length_rx();
+
 //set carrier frequency [Hz]
 void set_frecuency_rx(uint32_t f_carrier);
 
+//set carrier frequency [Hz] without printing the register values, returns the configured frequency [Hz]
+uint32_t tune_frecuency_rx(uint32_t f_carrier);
+
 #endif
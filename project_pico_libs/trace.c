@@ -0,0 +1,39 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Lightweight trace points for the hot path of the TX/RX loop.
+ *
+ */
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "pico/stdlib.h"
+#include "trace.h"
+#include "lib_output.h"
+
+struct trace_entry trace_buffer[TRACE_SIZE];
+uint32_t trace_count = 0;
+volatile bool trace_paused = false;
+
+static const char *trace_names[TRACE_STAGES] = {
+    "idle", "generate", "header", "swap", "carrier_start", "fifo", "airtime", "carrier_stop",
+    "read", "rearm", "print", "rx_assert_evt", "rx_deassert_evt"
+};
+
+void trace_dump(){
+    if (!ENABLE_TRACE) {
+        lib_printf("# trace: disabled (build with -DENABLE_TRACE=ON)\n");
+        return;
+    }
+    trace_paused = true;
+    uint32_t count = trace_count;
+    uint32_t first = (count > TRACE_SIZE) ? count - TRACE_SIZE : 0;
+    lib_printf("# trace: %u entries (%u dropped)\n", count - first, first);
+    for (uint32_t i = first; i < count; i++) {
+        struct trace_entry *entry = &trace_buffer[i & (TRACE_SIZE - 1)];
+        lib_printf("# trace %" PRIu64 " %s\n", entry->time_us, (entry->stage < TRACE_STAGES) ? trace_names[entry->stage] : "unknown");
+    }
+    lib_printf("# trace: end\n");
+    trace_count = 0;
+    trace_paused = false;
+}
@@ -0,0 +1,77 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Lightweight trace points for the hot path of the TX/RX loop.
+ *
+ * TRACE(stage) writes the stage id and the 64-bit timer timestamp into a RAM ring buffer
+ * (the last TRACE_SIZE trace points are kept). The trace points are compiled in only if the
+ * project is built with ENABLE_TRACE (cmake -DENABLE_TRACE=ON), otherwise TRACE() is empty.
+ *
+ * trace_dump() prints the buffer (oldest entry first) as log lines starting with '#':
+ *   # trace <timestamp [us]> <stage>
+ * and stats/trace.py converts them into per-stage latency histograms and a timeline.
+ *
+ */
+
+#ifndef TRACE_LIB
+#define TRACE_LIB
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+#include "hardware/sync.h"
+
+#ifndef ENABLE_TRACE
+#define ENABLE_TRACE 0
+#endif
+
+#define TRACE_SIZE 1024 // entries in the ring buffer (power of two)
+
+/* a trace point marks the start of a stage (stages ending with _evt are events of an ISR) */
+enum trace_stage {
+  TRACE_IDLE = 0,       // waiting for the next event
+  TRACE_GENERATE,       // payload generation
+  TRACE_HEADER,         // header, payload and CRC
+  TRACE_SWAP,           // byte swap into 32-bit words
+  TRACE_CARRIER_START,  // start carrier and wait until it has settled
+  TRACE_FIFO,           // put the frame into the FIFO of the state-machine
+  TRACE_AIRTIME,        // backscattering until the state-machine stalls
+  TRACE_CARRIER_STOP,   // end of frame: stop carrier (end of window) and statistics
+  TRACE_READ,           // readPacket
+  TRACE_REARM,          // re-arm the receivers
+  TRACE_PRINT,          // merge and printPacket
+  TRACE_RX_ASSERT_EVT,  // GDO0 asserted: sync word received (ISR)
+  TRACE_RX_DEASSERT_EVT,// GDO0 deasserted: end of packet (ISR)
+  TRACE_STAGES
+};
+
+struct trace_entry {
+  uint32_t stage;
+  uint64_t time_us;
+};
+
+extern struct trace_entry trace_buffer[TRACE_SIZE];
+extern uint32_t trace_count;
+extern volatile bool trace_paused; // set while dumping
+
+#if ENABLE_TRACE
+/* record a trace point (safe to use in ISRs) */
+static inline void trace(uint32_t stage){
+    if (trace_paused) {
+        return;
+    }
+    uint32_t irq = save_and_disable_interrupts();
+    struct trace_entry *entry = &trace_buffer[trace_count & (TRACE_SIZE - 1)];
+    entry->stage   = stage;
+    entry->time_us = time_us_64();
+    trace_count++;
+    restore_interrupts(irq);
+}
+#define TRACE(stage) trace(stage)
+#else
+#define TRACE(stage) ((void) 0)
+#endif
+
+/* print all recorded trace points (oldest first) and clear the buffer (trace points are dropped while printing) */
+void trace_dump();
+
+#endif
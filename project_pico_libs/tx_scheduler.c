@@ -0,0 +1,101 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Event-driven transmission scheduler.
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "tx_scheduler.h"
+
+static bool tx_scheduler_timer_callback(repeating_timer_t *rt){
+    ((struct tx_scheduler *) rt->user_data)->due = true;
+    return true; // keep repeating
+}
+
+void tx_scheduler_init(struct tx_scheduler *sched, uint8_t burst_len, uint32_t period_us){
+    memset(sched, 0, sizeof(struct tx_scheduler));
+    sched->burst_len  = (burst_len > 0) ? burst_len : 1;
+    sched->period_us  = period_us;
+    sched->gap_min_us = UINT32_MAX;
+    sched->start_us   = time_us_64();
+    sched->due        = true; // first window starts immediately
+    if(period_us > 0){
+        // negative delay: period between the starts of the callbacks
+        add_repeating_timer_us(-((int64_t) period_us), tx_scheduler_timer_callback, sched, &sched->timer);
+    }
+}
+
+bool tx_scheduler_ready(struct tx_scheduler *sched){
+    return sched->burst_pos > 0 || sched->period_us == 0 || sched->due;
+}
+
+bool tx_scheduler_idle(struct tx_scheduler *sched){
+    return sched->burst_pos == 0;
+}
+
+bool tx_scheduler_window_start(struct tx_scheduler *sched){
+    if(sched->burst_pos > 0){
+        return false;
+    }
+    sched->due = false;
+    sched->window_start_us = time_us_64();
+    return true;
+}
+
+bool tx_scheduler_sent(struct tx_scheduler *sched, uint64_t start_us){
+    uint64_t now = time_us_64();
+    sched->frames++;
+    sched->airtime_us  += now - start_us;
+    sched->frame_end_us = now;
+    sched->burst_pos++;
+    if(sched->burst_pos >= sched->burst_len){
+        sched->burst_pos = 0;
+        sched->carrier_on_us += now - sched->window_start_us;
+        return true;
+    }
+    return false;
+}
+
+bool tx_scheduler_close(struct tx_scheduler *sched){
+    if(sched->burst_pos == 0){
+        return false;
+    }
+    sched->burst_pos = 0;
+    sched->carrier_on_us += time_us_64() - sched->window_start_us;
+    return true;
+}
+
+void tx_scheduler_rearmed(struct tx_scheduler *sched){
+    if(sched->frame_end_us == 0){
+        return;
+    }
+    uint32_t gap = (uint32_t) (time_us_64() - sched->frame_end_us);
+    sched->gap_min_us  = min(sched->gap_min_us, gap);
+    sched->gap_sum_us += gap;
+    sched->gaps++;
+    sched->frame_end_us = 0;
+}
+
+void print_tx_scheduler(struct tx_scheduler *sched){
+    char line[TX_SCHEDULER_LINE_MAX];
+    if(format_tx_scheduler(line, sizeof(line), sched) > 0){
+        printf("%s", line);
+    }
+}
+
+int format_tx_scheduler(char *line, size_t size, struct tx_scheduler *sched){
+    uint64_t elapsed_us = time_us_64() - sched->start_us;
+    if(elapsed_us == 0){
+        line[0] = '\0';
+        return 0;
+    }
+    uint32_t duty    = (uint32_t) ((10000*sched->carrier_on_us)/elapsed_us); // [0.01%]
+    uint32_t airtime = (uint32_t) ((10000*sched->airtime_us)/elapsed_us);    // [0.01%]
+    uint32_t fps     = (uint32_t) ((((uint64_t) sched->frames)*100000000)/elapsed_us); // [0.01 frames/s]
+    return snprintf(line, size, "# scheduler: frames %u burst %u period %u us, carrier duty cycle %u.%02u%%, airtime %u.%02u%%, %u.%02u frames/s, gap min %u us mean %u us\n",
+           sched->frames, sched->burst_len, sched->period_us, duty/100, duty%100, airtime/100, airtime%100, fps/100, fps%100,
+           (sched->gaps > 0) ? sched->gap_min_us : 0, (sched->gaps > 0) ? (uint32_t) (sched->gap_sum_us/sched->gaps) : 0);
+}
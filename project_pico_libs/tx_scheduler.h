@@ -0,0 +1,80 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Event-driven transmission scheduler.
+ *
+ * Frames are grouped into carrier-on windows of burst_len frames. A window starts when the
+ * hardware timer expired (every period_us) or immediately (period_us = 0, back-to-back).
+ * Within a window, the next frame is sent as soon as the receiver has been re-armed.
+ * The gap between the end of a frame and the re-armed receiver is measured and reported.
+ *
+ * usage:
+ *   if (receiver_ready && tx_scheduler_ready(&s)) {
+ *       if (tx_scheduler_window_start(&s)) { start carrier }
+ *       uint64_t start_us = time_us_64();
+ *       send frame and wait until it has been sent
+ *       if (tx_scheduler_sent(&s, start_us)) { stop carrier }
+ *   }
+ *   once the receiver has been re-armed: tx_scheduler_rearmed(&s);
+ *
+ */
+
+#ifndef TX_SCHEDULER_LIB
+#define TX_SCHEDULER_LIB
+
+#include <stdio.h>
+#include "pico/stdlib.h"
+
+#ifndef MINMAX
+#define MINMAX
+#define max(x, y) (((x) > (y)) ? (x) : (y))
+#define min(x, y) (((x) < (y)) ? (x) : (y))
+#endif
+
+struct tx_scheduler {
+  uint8_t  burst_len;         // frames per carrier-on window
+  uint8_t  burst_pos;         // frames sent in the current window
+  uint32_t period_us;         // period of the carrier-on windows (0: back-to-back)
+  volatile bool due;          // set by the hardware timer
+  repeating_timer_t timer;
+  // statistics
+  uint32_t frames;
+  uint64_t start_us;
+  uint64_t window_start_us;
+  uint64_t carrier_on_us;     // sum of all carrier-on windows
+  uint64_t airtime_us;        // sum of all frame durations
+  uint64_t frame_end_us;      // end of the last frame (0: gap has been measured)
+  uint32_t gap_min_us;        // minimal gap: end of frame -> receiver re-armed
+  uint64_t gap_sum_us;
+  uint32_t gaps;
+};
+
+/* setup the scheduler, period_us = 0 sends back-to-back (no timer) */
+void tx_scheduler_init(struct tx_scheduler *sched, uint8_t burst_len, uint32_t period_us);
+
+/* may the next frame be sent (window open, timer expired or back-to-back)? */
+bool tx_scheduler_ready(struct tx_scheduler *sched);
+
+/* is no carrier-on window open? (e.g. to reconfigure or scan between windows) */
+bool tx_scheduler_idle(struct tx_scheduler *sched);
+
+/* returns true if the frame to be sent opens a new carrier-on window (the carrier has to be started) */
+bool tx_scheduler_window_start(struct tx_scheduler *sched);
+
+/* frame has been sent (start_us: when it was put into the FIFO), returns true if the window is complete (the carrier has to be stopped) */
+bool tx_scheduler_sent(struct tx_scheduler *sched, uint64_t start_us);
+
+/* end the current window early (e.g. no more data), returns true if a window was open (the carrier has to be stopped) */
+bool tx_scheduler_close(struct tx_scheduler *sched);
+
+/* the receiver has been re-armed after the last frame: measures the inter-frame gap */
+void tx_scheduler_rearmed(struct tx_scheduler *sched);
+
+/* print duty cycle, frames per second and the measured inter-frame gap ('#'-line) */
+void print_tx_scheduler(struct tx_scheduler *sched);
+
+/* line of print_tx_scheduler into line (size bytes, zero-terminated), returns its length (0: nothing to report yet) */
+#define TX_SCHEDULER_LINE_MAX 256
+int format_tx_scheduler(char *line, size_t size, struct tx_scheduler *sched);
+
+#endif
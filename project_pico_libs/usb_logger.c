@@ -0,0 +1,163 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Logging of the received frames on core 1 (see usb_logger.h).
+ *
+ */
+
+#include <stdio.h>
+#include <string.h>
+#include "pico/stdlib.h"
+#include "pico/multicore.h"
+#include "pico/util/queue.h"
+#include "usb_logger.h"
+#if LIB_PICO_STDIO_USB
+#include "pico/stdio_usb.h"
+#endif
+#if LIB_PICO_STDIO_UART
+#include "pico/stdio_uart.h"
+#endif
+
+#define LOG_REPORT_MAX 128 // length of the drop reports [B]
+#define LOG_TEXT_FLAG 0x80 // index of a text slot in ready_slots
+
+static struct log_slot slots[LOG_SLOTS];
+static char texts[LOG_TEXT_SLOTS][LOG_TEXT_MAX];
+static uint16_t text_len[LOG_TEXT_SLOTS];
+static queue_t free_slots;          // indices of the free slots (core 1 -> core 0)
+static queue_t free_texts;          // indices of the free text slots (core 1 -> core 0)
+static queue_t ready_slots;         // indices of the frames and text lines to log, in order (core 0 -> core 1)
+static volatile uint32_t dropped = 0;
+static volatile uint32_t dropped_lines = 0;
+static bool binary_log = false;
+
+/* batch of core 1 */
+static char batch[LOG_BATCH];
+static uint16_t batch_len = 0;
+static uint64_t batch_start_us = 0;
+static uint32_t reported = 0;
+static uint32_t reported_lines = 0;
+
+static void logger_core1(void){
+    multicore_lockout_victim_init(); // core 0 can pause core 1 while it writes the flash (flash_config_save)
+    while (true){
+        if (!usb_logger_poll()){
+            tight_loop_contents();
+        }
+    }
+}
+
+void usb_logger_init(bool binary){
+    binary_log = binary;
+    if (binary){
+        // the batch is written through stdout: a 0x0A byte of a binary record must not be translated to "\r\n"
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT && LIB_PICO_STDIO_USB
+        stdio_set_translate_crlf(&stdio_usb, false);
+#endif
+#if PICO_STDIO_ENABLE_CRLF_SUPPORT && LIB_PICO_STDIO_UART
+        stdio_set_translate_crlf(&stdio_uart, false);
+#endif
+    }
+    queue_init(&free_slots, sizeof(uint8_t), LOG_SLOTS);
+    queue_init(&free_texts, sizeof(uint8_t), LOG_TEXT_SLOTS);
+    queue_init(&ready_slots, sizeof(uint8_t), LOG_SLOTS + LOG_TEXT_SLOTS);
+    for (uint8_t i = 0; i < LOG_SLOTS; i++){
+        queue_try_add(&free_slots, &i);
+    }
+    for (uint8_t i = 0; i < LOG_TEXT_SLOTS; i++){
+        queue_try_add(&free_texts, &i);
+    }
+    multicore_launch_core1(logger_core1);
+}
+
+struct log_slot *usb_logger_acquire(void){
+    uint8_t idx;
+    if (!queue_try_remove(&free_slots, &idx)){
+        dropped++;
+        return NULL;
+    }
+    return &slots[idx];
+}
+
+void usb_logger_submit(struct log_slot *slot){
+    uint8_t idx = (uint8_t) (slot - slots);
+    queue_try_add(&ready_slots, &idx); // never full: the queue holds all slots
+}
+
+void usb_logger_release(struct log_slot *slot){
+    uint8_t idx = (uint8_t) (slot - slots);
+    queue_try_add(&free_slots, &idx);
+}
+
+uint32_t usb_logger_dropped(void){
+    return dropped;
+}
+
+bool usb_logger_vprintf(const char *format, va_list args, bool wait){
+    uint8_t idx;
+    while (!queue_try_remove(&free_texts, &idx)){
+        if (!wait){
+            dropped_lines++;
+            return false;
+        }
+        tight_loop_contents();
+    }
+    int len = vsnprintf(texts[idx], LOG_TEXT_MAX, format, args); // no stdio lock: only the string is formatted
+    text_len[idx] = (uint16_t) min(max(len, 0), LOG_TEXT_MAX - 1);
+    idx |= LOG_TEXT_FLAG;
+    queue_try_add(&ready_slots, &idx); // never full: the queue holds all slots
+    return true;
+}
+
+bool usb_logger_poll(void){
+    bool active = false;
+    uint8_t idx;
+    // format as many frames and text lines as fit into the batch (the slot is free again once it is formatted)
+    while (batch_len + PACKET_LINE_MAX + LOG_REPORT_MAX <= LOG_BATCH && queue_try_remove(&ready_slots, &idx)){
+        if (batch_len == 0){
+            batch_start_us = time_us_64();
+        }
+        active = true;
+        if (idx & LOG_TEXT_FLAG){
+            // text line of core 0 (already formatted)
+            idx &= ~LOG_TEXT_FLAG;
+            memcpy(&batch[batch_len], texts[idx], text_len[idx]);
+            batch_len += text_len[idx];
+            queue_try_add(&free_texts, &idx);
+            continue;
+        }
+        struct log_slot *slot = &slots[idx];
+        if (binary_log){
+            batch_len += formatPacketBinary((uint8_t *) &batch[batch_len], slot->buffer, slot->status, slot->time_us);
+        } else {
+            batch_len += formatPacket(&batch[batch_len], slot->buffer, slot->status, slot->time_us);
+        }
+        queue_try_add(&free_slots, &idx);
+    }
+    uint32_t total = dropped;
+    if (total != reported){
+        if (batch_len == 0){
+            batch_start_us = time_us_64();
+        }
+        batch_len += sprintf(&batch[batch_len], "# logger: %u frames dropped (%u in total)\n", total - reported, total);
+        reported = total;
+        active = true;
+    }
+    total = dropped_lines;
+    if (total != reported_lines){
+        if (batch_len == 0){
+            batch_start_us = time_us_64();
+        }
+        batch_len += sprintf(&batch[batch_len], "# logger: %u lines dropped (%u in total)\n", total - reported_lines, total);
+        reported_lines = total;
+        active = true;
+    }
+    // write once the batch is full or its first frame waited LOG_FLUSH_US
+    if (batch_len > 0 && (batch_len + PACKET_LINE_MAX + LOG_REPORT_MAX > LOG_BATCH || time_us_64() - batch_start_us >= LOG_FLUSH_US)){
+        fwrite(batch, 1, batch_len, stdout); // binary records: CR/LF translation turned off by usb_logger_init
+        fflush(stdout);
+        batch_len = 0;
+        active = true;
+    }
+    return active;
+}
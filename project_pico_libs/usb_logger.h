@@ -0,0 +1,68 @@
+/**
+ * Tobias Mages & Wenqing Yan
+ *
+ * Logging of the received frames on core 1, such that a slow USB connection (or a host which stops
+ * reading) cannot stall the reception on core 0.
+ *
+ * The frames are handed over in a pool of LOG_SLOTS preallocated slots: core 0 reads a frame from the
+ * RX FIFO directly into a free slot (usb_logger_acquire), and passes the slot index to core 1
+ * (usb_logger_submit). Core 1 formats the frames (printPacket/printPacketBinary format) into a batch of
+ * up to LOG_BATCH bytes and writes it at once, when it is full or LOG_FLUSH_US after its first frame.
+ * Both directions use the queues of the SDK (multicore safe, non-blocking on core 0).
+ *
+ * If no slot is free, the frame is not logged (it is still used for the statistics) and counted as
+ * dropped. Core 1 reports new drops in the log:
+ *   # logger: <n> frames dropped (<total> in total)
+ *
+ * The '#' statistics lines of core 0 take the same path (usb_logger_vprintf): they are formatted into one of
+ * LOG_TEXT_SLOTS text slots and written by core 1 in order with the frames, so core 0 never waits for the stdio
+ * mutex held by core 1. Lines without a free text slot are dropped and reported as well:
+ *   # logger: <n> lines dropped (<total> in total)
+ *
+ */
+
+#ifndef USB_LOGGER_LIB
+#define USB_LOGGER_LIB
+
+#include <stdarg.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include "receiver_CC2500.h"
+
+#define LOG_SLOTS          32 // frames between core 0 and core 1
+#define LOG_BATCH        2048 // bytes written at once [B]
+#define LOG_FLUSH_US     2000 // maximal delay of a frame in a batch [us]
+#define LOG_TEXT_SLOTS     24 // statistics lines between core 0 and core 1
+#define LOG_TEXT_MAX      256 // length of a statistics line [B] (at most PACKET_LINE_MAX)
+
+struct log_slot {
+  uint64_t time_us;
+  Packet_status status;
+  uint8_t buffer[RX_BUFFER_SIZE];
+};
+
+/* set up the slot pool and start core 1 (binary: records of printPacketBinary instead of text lines,
+ * the CR/LF translation of stdio is turned off, all lines end with "\n" only) */
+void usb_logger_init(bool binary);
+
+/* free slot to read a frame into, NULL if the logger fell behind (counted as dropped) */
+struct log_slot *usb_logger_acquire(void);
+
+/* log the frame of the slot (status and time_us have to be set), the slot belongs to core 1 afterwards */
+void usb_logger_submit(struct log_slot *slot);
+
+/* return a slot without logging its frame */
+void usb_logger_release(struct log_slot *slot);
+
+/* frames which could not be logged since start-up */
+uint32_t usb_logger_dropped(void);
+
+/* log a text line of core 0 (vprintf format, truncated to LOG_TEXT_MAX - 1 bytes) in order with the frames
+ * wait: wait for a free text slot (core 1 has to run), otherwise the line is dropped (and counted) if none is free
+ * returns false if the line was dropped */
+bool usb_logger_vprintf(const char *format, va_list args, bool wait);
+
+/* format the submitted frames and write the batch if it is due, returns false if there was nothing to do (loop of core 1) */
+bool usb_logger_poll(void);
+
+#endif
@@ -40,6 +40,7 @@ def readfile(filename):
     # parse the payload to seq and payload
     df.frame = df.frame.str.rstrip().str.lstrip()
     df = df[df.frame.str.contains("packet overflow") == False]
+    df['length'] = df.frame.apply(lambda x: int(x[0:2], base=16))
     df['seq'] = df.frame.apply(lambda x: int(x[3:5], base=16))
     df['payload'] = df.frame.apply(lambda x: x[6:])
     # parse the rssi data
@@ -49,6 +50,15 @@ def readfile(filename):
     df.reset_index(inplace=True)
     return df
 
+# frames with a corrupted length byte (SALVAGE_LENGTH of carrier-receiver-baseband/main.c, or a length byte which was too large):
+# a frame received at least up to the expected length is cut to PAYLOADSIZE bytes instead of being dropped by the length filter
+def salvage_frames(df, PAYLOADSIZE):
+    expected = PAYLOADSIZE*3-1 # hex bytes separated by spaces
+    df = df.copy()
+    df['salvaged'] = (df.payload.str.len() >= expected) & (df.length != PAYLOADSIZE+1)
+    df['payload'] = df.payload.str.slice(0, expected)
+    return df
+
 # parse the hex payload, return a list with int numbers for each byte
 def parse_payload(payload_string):
     tmp = map(lambda x: int(x, base=16), payload_string.split())
@@ -78,51 +88,70 @@ def rnd(seed):
     seed = ((seed * A1 + C1) & RAND_MAX1)
     return seed
 
-# a 16-bit generator returns compressible 16-bit data sample
+# jump-ahead of rnd(): n steps are the affine map seed -> a*seed + c (mod 2^32), computed in O(log n) (identical to lcg_jump_ahead() in project_pico_libs/packet_generation.c)
+def lcg_jump_ahead(n):
+    a, c = 1, 0                   # identity
+    step_a, step_c = 1664525, 1013904223
+    while n > 0:
+        if n & 1:
+            a, c = (step_a * a) & 0xFFFFFFFF, (step_a * c + step_c) & 0xFFFFFFFF
+        step_a, step_c = (step_a * step_a) & 0xFFFFFFFF, (step_a * step_c + step_c) & 0xFFFFFFFF
+        n >>= 1
+    return a, c
+
+# seed after n steps of rnd() (lcg_advance())
+def lcg_advance(seed, n):
+    a, c = lcg_jump_ahead(n)
+    return (a * seed + c) & 0xFFFFFFFF
+
+# seed at the (even) file position: two rnd() per sample, restart at position 0 (generator_seek())
+def seed_at(file_position, initial_seed=0xabcd):
+    return lcg_advance(initial_seed, file_position % 0x10000)
+
+# a 16-bit generator returns compressible 16-bit data sample (identical to generate_sample() in project_pico_libs/packet_generation.c)
 def data(seed):
     two_pi = np.float64(2.0 * np.float64(math.pi))
-    u1 = 0
-    u2 = 0
-    while(u1 == 0 or u2 == 0):
-        seed = rnd(seed)
-        u1 = np.float64(seed/0xFFFFFFFF)
-        seed = rnd(seed)
-        u2 = np.float64(seed/0xFFFFFFFF)
-    tmp = 0x7FF * np.float64(math.sqrt(np.float64(-2.0 * np.float64(math.log(u1)))))
-    return np.trunc(max([0,min([0x3FFFFF,np.float64(np.float64(tmp * np.float64(math.cos(np.float64(two_pi * u2)))) + 0x1FFF)])])), seed
-
-# generate the transmitted file for comparison
-TOTAL_NUM_16RND = 512*40 # generate a 40MB file, in case transmit too many data (larger than required 2MB)
-def generate_data(NUM_16RND, TOTAL_NUM_16RND):
+    seed = rnd(seed)
+    u1 = np.float64(seed/0xFFFFFFFF)
+    seed = rnd(seed)
+    u2 = np.float64(seed/0xFFFFFFFF)
+    # as in C: log(0) = -inf, the sample is clipped and converted to uint16_t
+    tmp = 0x7FF * np.float64(math.sqrt(np.float64(-2.0 * np.float64(math.log(u1))))) if u1 > 0 else np.inf
+    return np.float64(int(np.trunc(max([0,min([0x3FFFFF,np.float64(np.float64(tmp * np.float64(math.cos(np.float64(two_pi * u2)))) + 0x1FFF)])]))) & 0xFFFF), seed
+
+# file data of length bytes from the (even) file position, without generating the data before it
+def data_at(file_position, length, initial_seed=0xabcd):
     LOW_BYTE = (1 << 8) - 1
-    length = int(np.ceil(TOTAL_NUM_16RND/NUM_16RND))
-    index = [NUM_16RND*i*2 for i in range(length)]
-    df = pd.DataFrame(index=index, columns=['data'])
-    initial_seed = 0xabcd # initial seed
-    pseudo_seq = 0 # (16-bit)
-    seed  = initial_seed
-    for i in index:
-        payload_data = []
-        for j in range(NUM_16RND):
-            if pseudo_seq > 0xffff:
-                pseudo_seq = 0
-                seed = initial_seed
-            pseudo_seq = pseudo_seq + 2
-            number, seed = data(seed)
-            payload_data.append((int(number) >> 8) - 0)
-            payload_data.append(int(number) & LOW_BYTE)
-        df.loc[i, "data"] = payload_data
-    return df
+    payload_data = []
+    seed = seed_at(file_position, initial_seed)
+    for j in range((length + 1)//2):
+        if file_position % 0x10000 == 0:
+            seed = initial_seed
+        file_position = file_position + 2
+        number, seed = data(seed)
+        payload_data.append((int(number) >> 8) - 0)
+        payload_data.append(int(number) & LOW_BYTE)
+    return payload_data[:length]
+
+# reference file generated with host/build/make_reference (see host/analyzer/reference_file.h)
+REFERENCE_MAGIC = b'PBREF001'
+REFERENCE_HEADER = 24
+reference_content = None
+def load_reference(filename):
+    global reference_content
+    header = np.fromfile(filename, dtype=np.uint8, count=REFERENCE_HEADER)
+    if bytes(header[:8]) != REFERENCE_MAGIC:
+        raise ValueError(f"{filename} is not a reference file")
+    seed, period, payload_size, _ = header[8:].view('<u4')
+    reference_content = np.memmap(filename, dtype=np.uint8, mode='r', offset=REFERENCE_HEADER)
+    print(f"Reference file {filename}: seed 0x{seed:X}, payload {payload_size} B, period {period} B")
 
-file_content = None
 def payload_for_peudo_seq(pseudo_seq,PACKET_LEN):
-    global file_content
-    if type(file_content) == type(None): # generate data
-        file_content = generate_data(int(PACKET_LEN/2), TOTAL_NUM_16RND)
-    if pseudo_seq in file_content.index:
-        return file_content.loc[pseudo_seq, 'data']
-    else:
-        return file_content.loc[0, 'data'] # TODO: pseudo sequence not within the first expected range
+    if pseudo_seq % 2 != 0:
+        pseudo_seq = 0 # not the start of a sample
+    if type(reference_content) != type(None): # data at the file offset pseudo_seq (memory-mapped)
+        return list(reference_content[pseudo_seq:pseudo_seq+PACKET_LEN])
+    return data_at(pseudo_seq, PACKET_LEN) # jump to the file offset (any position)
 
 def compute_ber_packet(df_row, PACKET_LEN=32):
     payload = parse_payload(df_row.payload)
@@ -142,6 +171,12 @@ def compute_ber(df, PACKET_LEN=32):
         print("Warning, the log-file seems empty.")
         return 0.5
 
+# read the per-packet CSV of the native log analyzer (host/analyzer): time_ms, seq, len, file_index, bit_errors, bits, rssi, crc
+def read_analyzer_csv(filename):
+    df = pd.read_csv(filename)
+    df['time_rx'] = pd.to_timedelta(df.time_ms, unit='ms')
+    return df
+
 # plot radar chart
 def radar_plot(metrics):
     categories = ['Time', 'Reliability', 'Distance']
@@ -0,0 +1,52 @@
+#!/usr/bin/python3
+
+# Tobias Mages and Wenqing Yan
+# Course: Wireless Communication and Networked Embedded Systems, Project VT2023
+# BER/PER over Eb/N0 of the host simulator (host/sim/backscatter_sim --csv)
+#
+
+# usage example: python simulation.py --help
+# usage example: python simulation.py results.csv
+# usage example: python simulation.py results.csv --baud 100000 --fec 0 --save simulation
+
+import argparse
+import pandas as pd
+import matplotlib.pyplot as plt
+
+# parse arguments and give help option
+parser = argparse.ArgumentParser(prog = 'Simulation results', description='Wireless Communication and Networked Embedded Systems, Project VT2023\nusage example: python3 simulation.py ./results.csv')
+parser.add_argument('f', type=str, help='CSV file written by backscatter_sim --csv')
+parser.add_argument('--baud', type=int, default=None, help='only configurations with this baud-rate')
+parser.add_argument('--antennas', type=int, default=None, help='only configurations with this number of antennas (1 or 2)')
+parser.add_argument('--fec', type=int, default=None, help='only configurations with (1) or without (0) FEC')
+parser.add_argument('--save', type=str, default=None, help='save the plot as <SAVE>.png instead of showing it')
+args = parser.parse_args()
+
+df = pd.read_csv(args.f)
+for column in ['baud', 'antennas', 'fec']:
+    value = getattr(args, column)
+    if value is not None:
+        df = df[df[column] == value]
+if df.empty:
+    print('No configuration matches the selection.')
+    exit(1)
+
+fig, (ax_ber, ax_per) = plt.subplots(1, 2, figsize=(12, 5))
+for (d0, d1, baud, antennas, fec), run in df.groupby(['d0', 'd1', 'baud', 'antennas', 'fec']):
+    label = f'd0={d0} d1={d1} {baud/1000:g} kBaud {antennas} ant.' + (' FEC' if fec else '')
+    # BER of 0 cannot be shown on a logarithmic axis
+    ber = run[run.ber > 0]
+    ax_ber.semilogy(ber.ebn0_db, ber.ber, marker='o', label=label)
+    ax_per.semilogy(run.ebn0_db, run.per.clip(lower=1e-4), marker='o', label=label)
+ax_ber.set_xlabel('Eb/N0 [dB] (one antenna)')
+ax_ber.set_ylabel('bit error rate (detected frames)')
+ax_per.set_xlabel('Eb/N0 [dB] (one antenna)')
+ax_per.set_ylabel('packet error rate')
+for ax in (ax_ber, ax_per):
+    ax.grid(True, which='both', alpha=0.3)
+ax_per.legend(fontsize='small')
+plt.tight_layout()
+if args.save:
+    plt.savefig(f'{args.save}.png', dpi=150)
+else:
+    plt.show()
@@ -0,0 +1,106 @@
+#!/usr/bin/python3
+
+# Tobias Mages and Wenqing Yan
+# Course: Wireless Communication and Networked Embedded Systems, Project VT2023
+# Per-stage latency histograms and timeline of the trace points (project_pico_libs/trace.h)
+#
+
+# usage example: python trace.py --help
+# usage example: python trace.py ../carrier-receiver-baseband/received.txt
+# usage example: python trace.py ../carrier-receiver-baseband/received.txt --timeline 5000 --save trace
+
+import argparse
+import numpy as np
+import pandas as pd
+import matplotlib.pyplot as plt
+
+# parse arguments and give help option
+parser = argparse.ArgumentParser(prog = 'Trace analysis', description='Wireless Communication and Networked Embedded Systems, Project VT2023\nusage example: python3 trace.py ./received.txt')
+parser.add_argument('f', type=str, help='log file containing the trace dump (send \'t\' to the board to dump the trace buffer)')
+parser.add_argument('--timeline', type=int, default=5000, help='length of the plotted timeline [us] (starting with the first trace point)')
+parser.add_argument('--save', type=str, default=None, help='save the plots as <SAVE>_histogram.png and <SAVE>_timeline.png instead of showing them')
+args = parser.parse_args()
+
+# read all trace points: "# trace <timestamp [us]> <stage>" (each dump is an independent recording)
+def read_trace(filename):
+    rows = []
+    dump = -1
+    for line in open(filename):
+        fields = line.split()
+        if line.startswith('# trace:') and 'entries' in line:
+            dump = dump + 1
+        elif len(fields) == 4 and fields[0] == '#' and fields[1] == 'trace':
+            rows.append((max(0, dump), int(fields[2]), fields[3]))
+    return pd.DataFrame(rows, columns=['dump', 'time_us', 'stage'])
+
+# a trace point starts a stage which lasts until the next trace point of the main loop (events of the ISR are excluded)
+def stage_durations(df):
+    loop = df[~df.stage.str.endswith('_evt')].copy()
+    loop['duration_us'] = loop.groupby('dump').time_us.shift(-1) - loop.time_us
+    return loop.dropna()
+
+# latency from an ISR event to the next trace point of the given stage (e.g. end of packet -> readPacket)
+def event_latency(df, event, stage):
+    latency = []
+    for _, trace in df.groupby('dump'):
+        events = trace[trace.stage == event].time_us.values
+        stages = trace[trace.stage == stage].time_us.values
+        idx = np.searchsorted(stages, events)
+        latency += [stages[i] - t for (i, t) in zip(idx, events) if i < len(stages)]
+    return np.array(latency)
+
+df = read_trace(args.f)
+if len(df) == 0:
+    print('No trace points found (build with cmake -DENABLE_TRACE=ON and send \'t\' to dump the trace buffer).')
+    exit(1)
+durations = stage_durations(df)
+latencies = {
+    'rx_assert_evt -> rx_deassert_evt': event_latency(df, 'rx_assert_evt', 'rx_deassert_evt'),
+    'rx_deassert_evt -> read': event_latency(df, 'rx_deassert_evt', 'read'),
+}
+
+# summary table
+print(f"{'stage':>34} {'count':>6} {'mean [us]':>10} {'p50 [us]':>9} {'p99 [us]':>9} {'max [us]':>9}")
+series = {stage: group.duration_us.values for (stage, group) in durations.groupby('stage', sort=False)}
+series.update({name: values for (name, values) in latencies.items() if len(values) > 0})
+for (stage, values) in series.items():
+    print(f'{stage:>34} {len(values):6} {np.mean(values):10.1f} {np.percentile(values, 50):9.0f} {np.percentile(values, 99):9.0f} {np.max(values):9.0f}')
+
+# per-stage latency histograms
+cols = 4
+rows = int(np.ceil(len(series)/cols))
+fig, axes = plt.subplots(rows, cols, figsize=(16, 3*rows), squeeze=False)
+for ax, (stage, values) in zip(axes.flat, series.items()):
+    ax.hist(values, bins=50, color='#77A136')
+    ax.set_title(stage)
+    ax.set_xlabel('latency [us]')
+    ax.grid()
+for ax in list(axes.flat)[len(series):]:
+    ax.axis('off')
+fig.tight_layout()
+if args.save:
+    fig.savefig(f'{args.save}_histogram.png')
+
+# timeline of the first dump: one row per stage, ISR events as markers
+first = durations[durations.dump == durations.dump.min()]
+events = df[(df.dump == durations.dump.min()) & df.stage.str.endswith('_evt')]
+t0 = df[df.dump == durations.dump.min()].time_us.min()
+first = first[first.time_us - t0 < args.timeline]
+events = events[events.time_us - t0 < args.timeline]
+stages = list(dict.fromkeys(list(first.stage) + list(events.stage)))
+fig, ax = plt.subplots(figsize=(16, 0.5*len(stages) + 1))
+for (row, stage) in enumerate(stages):
+    bars = first[first.stage == stage]
+    if len(bars) > 0:
+        ax.broken_barh(list(zip(bars.time_us - t0, bars.duration_us)), (row - 0.4, 0.8), color='grey' if stage == 'idle' else '#77A136')
+    marks = events[events.stage == stage]
+    ax.scatter(marks.time_us - t0, [row]*len(marks), marker='|', s=200, color='black')
+ax.set_yticks(range(len(stages)))
+ax.set_yticklabels(stages)
+ax.set_xlabel('time [us]')
+ax.grid()
+fig.tight_layout()
+if args.save:
+    fig.savefig(f'{args.save}_timeline.png')
+else:
+    plt.show()